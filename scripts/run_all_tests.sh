@@ -62,6 +62,36 @@ compile_all() {
     gcc -O2 -o prefetch/prefetch_distance prefetch/prefetch_distance.c
     gcc -O2 -o prefetch/prefetch_hints prefetch/prefetch_hints.c
     gcc -O2 -pthread -o prefetch/combined_test prefetch/combined_test.c
+    gcc -O2 -pthread -o prefetch/hw_prefetch_sweep prefetch/hw_prefetch_sweep.c
+
+    # 微架构测试
+    log_info "Compiling microarch tests..."
+    gcc -O2 -o microarch/set_conflict microarch/set_conflict.c
+    gcc -O2 -pthread -o microarch/split_access microarch/split_access.c
+    gcc -O2 -pthread -o microarch/port_contention microarch/port_contention.c
+    gcc -O2 -pthread -o microarch/roofline microarch/roofline.c -lm
+
+    # 工作负载
+    log_info "Compiling workloads..."
+    gcc -O2 -o workloads/search_layout workloads/search_layout.c
+    gcc -O2 -pthread -o workloads/bloom_filter workloads/bloom_filter.c
+    gcc -O2 -pthread -o workloads/linked_traversal workloads/linked_traversal.c
+    gcc -O2 -pthread -o workloads/graph_csr workloads/graph_csr.c
+    gcc -O2 -pthread -o workloads/spmv workloads/spmv.c -lm
+    gcc -O2 -pthread -o workloads/stencil workloads/stencil.c -lm
+    gcc -O2 -pthread -o workloads/histogram workloads/histogram.c -lm
+    gcc -O2 -o workloads/record_layout workloads/record_layout.c
+    gcc -O2 -pthread -o workloads/radix_partition workloads/radix_partition.c
+    gcc -O2 -pthread -o workloads/parallel_sort workloads/parallel_sort.c
+    gcc -O2 -pthread -o workloads/column_scan workloads/column_scan.c
+    gcc -O2 -pthread -o workloads/compressed_scan workloads/compressed_scan.c
+    gcc -O2 -pthread -o workloads/allocator workloads/allocator.c
+    gcc -O2 -pthread -o workloads/object_pool workloads/object_pool.c
+    gcc -O2 -pthread -o workloads/work_stealing workloads/work_stealing.c
+
+    # 分析工具
+    log_info "Compiling analysis tools..."
+    gcc -O2 -o analysis/reuse_distance analysis/reuse_distance.c
 
     log_success "All programs compiled successfully!"
 }
@@ -104,6 +134,7 @@ run_negative_tests() {
     run_with_perf ./negative/dcache_contention "dcache_single" --single
     run_with_perf ./negative/dcache_contention "dcache_same_core" --same-core
     run_with_perf ./negative/dcache_contention "dcache_diff_core" --diff-core
+    run_with_perf ./negative/dcache_contention "dcache_same_core_samples" --same-core --mem-sample
 
     # I-Cache 竞争测试
     run_with_perf ./negative/icache_contention "icache_single" --single
@@ -126,6 +157,7 @@ run_positive_tests() {
     run_with_perf ./positive/latency_hiding "latency_single" --single
     run_with_perf ./positive/latency_hiding "latency_same_core" --same-core
     run_with_perf ./positive/latency_hiding "latency_diff_core" --diff-core
+    run_with_perf ./positive/latency_hiding "latency_cycles" --cycles
 }
 
 # 运行预取测试
@@ -153,6 +185,101 @@ run_prefetch_tests() {
     # 预取距离和提示类型
     run_with_perf ./prefetch/prefetch_distance "prefetch_distance" ""
     run_with_perf ./prefetch/prefetch_hints "prefetch_hints" ""
+
+    # 硬件预取器特性
+    run_with_perf ./prefetch/hw_prefetch_sweep "hw_prefetch_stride" --stride
+    run_with_perf ./prefetch/hw_prefetch_sweep "hw_prefetch_streams" --streams
+}
+
+# 运行微架构测试
+run_microarch_tests() {
+    log_info "=== Running Microarch Tests ==="
+
+    cd "$SRC_DIR"
+
+    # 缓存组冲突与 4K 混叠
+    run_with_perf ./microarch/set_conflict "set_conflict_assoc" --assoc
+    run_with_perf ./microarch/set_conflict "set_conflict_alias" --alias
+
+    # 跨行/跨页非对齐访问
+    run_with_perf ./microarch/split_access "split_access_load" --load
+    run_with_perf ./microarch/split_access "split_access_page" --page
+
+    # 执行端口竞争（超线程配对矩阵）
+    run_with_perf ./microarch/port_contention "port_contention_matrix" --matrix
+
+    # 算术强度扫描与 Roofline
+    run_with_perf ./microarch/roofline "roofline" --all --csv "$RESULT_DIR/roofline.csv"
+}
+
+# 运行工作负载测试
+run_workload_tests() {
+    log_info "=== Running Workload Tests ==="
+
+    cd "$SRC_DIR"
+
+    # 查找布局：有序数组 / Eytzinger / S-tree
+    run_with_perf ./workloads/search_layout "search_layout_single" --single
+    run_with_perf ./workloads/search_layout "search_layout_batched" --batched
+
+    # 分块 Bloom filter：批量预取查询与超线程放置
+    run_with_perf ./workloads/bloom_filter "bloom_throughput" --throughput
+    run_with_perf ./workloads/bloom_filter "bloom_smt" --smt
+
+    # 链表/树遍历：跳跃指针、贪婪预取、超线程预执行
+    run_with_perf ./workloads/linked_traversal "linked_list" --list
+    run_with_perf ./workloads/linked_traversal "linked_tree" --tree
+
+    # CSR 图：BFS / PageRank 间接访问预取
+    run_with_perf ./workloads/graph_csr "graph_bfs" --bfs --lookahead 16
+    run_with_perf ./workloads/graph_csr "graph_pagerank" --pagerank --lookahead 16
+    run_with_perf ./workloads/graph_csr "graph_pagerank_rcm" --pagerank --reorder rcm
+
+    # SpMV：CSR / SELL-C-σ / BCSR
+    run_with_perf ./workloads/spmv "spmv_csr" --csr --type powerlaw
+    run_with_perf ./workloads/spmv "spmv_sell" --sell --type powerlaw
+    run_with_perf ./workloads/spmv "spmv_bcsr" --bcsr --type block
+
+    # 模板计算：空间分块 / 时间分块
+    run_with_perf ./workloads/stencil "stencil_2d" --2d --threads 8
+    run_with_perf ./workloads/stencil "stencil_3d7" --3d7 --threads 8
+    run_with_perf ./workloads/stencil "stencil_3d27" --3d27 --threads 8
+
+    # 并行直方图：原子 / 私有 / 超线程共享 / 分区所有权
+    run_with_perf ./workloads/histogram "histogram_uniform" --uniform
+    run_with_perf ./workloads/histogram "histogram_zipf" --zipf
+
+    # 记录布局：AoS / SoA / AoSoA / 冷热分离
+    run_with_perf ./workloads/record_layout "layout_scan_128b" --scan --size 128
+    run_with_perf ./workloads/record_layout "layout_random_128b" --random --size 128
+
+    # 基数分区：软件写合并 + 非临时存储
+    run_with_perf ./workloads/radix_partition "radix_partition_fanout" --fanout
+    run_with_perf ./workloads/radix_partition "radix_partition_pages" --pages --bits 12
+
+    # 并行排序：LSD/MSD 基数排序、SIMD 归并排序、qsort
+    run_with_perf ./workloads/parallel_sort "sort_u32" --u32 --n 16777216
+    run_with_perf ./workloads/parallel_sort "sort_u64" --u64 --n 16777216
+
+    # 列扫描：SIMD 谓词、位图/选择向量输出、位压缩解码
+    run_with_perf ./workloads/column_scan "column_scan_filter" --filter
+    run_with_perf ./workloads/column_scan "column_scan_unpack" --unpack
+
+    # 压缩数组扫描：bitpack / FOR / delta+varint 与原始数组对比
+    run_with_perf ./workloads/compressed_scan "compressed_scan_cache" --cache
+    run_with_perf ./workloads/compressed_scan "compressed_scan_dram" --dram
+
+    # 小对象分配器：glibc malloc vs 每线程 slab
+    run_with_perf ./workloads/allocator "allocator_steady" --steady
+    run_with_perf ./workloads/allocator "allocator_xthread" --xthread --placement compact
+
+    # 定长对象池：每 CPU 弹匣 + depot vs malloc
+    run_with_perf ./workloads/object_pool "object_pool_local" --local
+    run_with_perf ./workloads/object_pool "object_pool_handoff" --handoff
+
+    # 工作窃取调度：随机 vs 拓扑感知窃取
+    run_with_perf ./workloads/work_stealing "work_stealing_pfor" --pfor
+    run_with_perf ./workloads/work_stealing "work_stealing_matmul" --matmul
 }
 
 # 生成摘要报告
@@ -214,6 +341,8 @@ run_full() {
     run_negative_tests
     run_positive_tests
     run_prefetch_tests
+    run_microarch_tests
+    run_workload_tests
     generate_summary
 
     log_success "All tests completed! Results in $RESULT_DIR"
@@ -242,6 +371,14 @@ case "${1:-quick}" in
         compile_all
         run_prefetch_tests
         ;;
+    --microarch)
+        compile_all
+        run_microarch_tests
+        ;;
+    --workloads)
+        compile_all
+        run_workload_tests
+        ;;
     --help|-h)
         echo "Usage: $0 [option]"
         echo ""
@@ -252,6 +389,8 @@ case "${1:-quick}" in
         echo "  --negative     Run negative scenario tests"
         echo "  --positive     Run positive scenario tests"
         echo "  --prefetch     Run prefetch tests"
+        echo "  --microarch    Run microarch tests"
+        echo "  --workloads    Run workload tests"
         echo "  --help, -h     Show this help"
         ;;
     *)
@@ -81,6 +81,29 @@ static inline void bind_to_different_cores(int *cpu1, int *cpu2) {
     *cpu2 = DIFFERENT_CORES[1];  // Core 1, CPU 1
 }
 
+// 多线程放置策略
+#define NUM_CORES 8
+#define NUM_HW_THREADS 16
+
+typedef enum {
+    PLACE_SPREAD,   // 先占满不同核心 (0,1,...,7)，再使用超线程 (8,...,15)
+    PLACE_COMPACT   // 先占满同一核心的超线程 (0,8,1,9,...)
+} placement_t;
+
+// 第 idx 个线程应绑定的 CPU
+static inline int placement_cpu(int idx, placement_t placement) {
+    idx %= NUM_HW_THREADS;
+    if (placement == PLACE_COMPACT) {
+        return HT_PAIRS[idx / 2][idx % 2];
+    }
+    return HT_PAIRS[idx % NUM_CORES][idx / NUM_CORES];
+}
+
+static inline const char *placement_name(placement_t placement) {
+    return placement == PLACE_COMPACT ? "compact (HT siblings first)"
+                                      : "spread (different cores first)";
+}
+
 // 高精度计时器
 #include <time.h>
 
@@ -0,0 +1,210 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <dirent.h>
+#include "cpu_bindind.h"
+#include "perf_counters.h"
+
+// RAPL 能耗读数
+//
+// 超线程既是吞吐问题也是能效问题：同样的工作，同核两线程可能比
+// 异核两线程慢，但因为只唤醒一个核心而更省电。本文件在测量区间
+// 前后读取封装 (package) 和核心 (core) 能耗，输出焦耳和 ops/J。
+//
+// 数据源（按优先级）：
+//   powercap   /sys/class/powercap/intel-rapl:*/energy_uj（AMD Zen 同样使用此名称），
+//              新内核默认只有 root 可读
+//   perf       power PMU 的 energy-pkg / energy-cores 事件（系统级，
+//              需要 perf_event_paranoid <= 0）
+// 都不可用时所有读数为 n/a，测试照常运行。
+//
+// RAPL 是整个封装/所有核心的能耗，包含后台活动，只适合比较相对值。
+
+typedef enum {
+    ENERGY_PKG,
+    ENERGY_CORE,
+    ENERGY_NUM_DOMAINS
+} energy_domain_t;
+
+typedef struct {
+    double elapsed;
+    double joules[ENERGY_NUM_DOMAINS];  // < 0 表示不可用
+} energy_sample_t;
+
+typedef struct {
+    double t0;
+    double start[ENERGY_NUM_DOMAINS];
+} energy_meter_t;
+
+static struct {
+    const char *source;
+    char path[ENERGY_NUM_DOMAINS][320];  // powercap energy_uj 路径
+    double max_range[ENERGY_NUM_DOMAINS];  // 计数回绕范围（微焦）
+    int fd[ENERGY_NUM_DOMAINS];           // perf 事件
+    double scale[ENERGY_NUM_DOMAINS];     // perf 计数 -> 焦耳
+} energy_state = {"none", {"", ""}, {0, 0}, {-1, -1}, {0, 0}};
+
+static const char *energy_domain_names[ENERGY_NUM_DOMAINS] = {"pkg", "core"};
+
+static inline int energy_read_file(const char *path, char *buf, size_t len) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int ok = fgets(buf, (int)len, f) != NULL;
+    fclose(f);
+    if (!ok) return -1;
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+static inline double energy_read_double(const char *path) {
+    char buf[64];
+    if (energy_read_file(path, buf, sizeof(buf)) != 0) return -1;
+    return atof(buf);
+}
+
+// 在 powercap 目录中查找 package 和 core 域（core 是 package 的子域）
+static inline int energy_probe_powercap(void) {
+    DIR *dir = opendir("/sys/class/powercap");
+    struct dirent *ent;
+    int found = 0;
+
+    if (!dir) return 0;
+    while ((ent = readdir(dir)) != NULL) {
+        char path[320], name[64];
+        int domain;
+
+        if (strncmp(ent->d_name, "intel-rapl:", 11) != 0) continue;
+        snprintf(path, sizeof(path), "/sys/class/powercap/%s/name", ent->d_name);
+        if (energy_read_file(path, name, sizeof(name)) != 0) continue;
+
+        if (strcmp(name, "package-0") == 0) {
+            domain = ENERGY_PKG;
+        } else if (strcmp(name, "core") == 0 && strncmp(ent->d_name, "intel-rapl:0:", 13) == 0) {
+            domain = ENERGY_CORE;
+        } else {
+            continue;
+        }
+
+        snprintf(energy_state.path[domain], sizeof(energy_state.path[domain]),
+                 "/sys/class/powercap/%s/energy_uj", ent->d_name);
+        snprintf(path, sizeof(path), "/sys/class/powercap/%s/max_energy_range_uj", ent->d_name);
+        energy_state.max_range[domain] = energy_read_double(path);
+
+        // 目录存在但无读权限时视为不可用
+        if (energy_read_double(energy_state.path[domain]) < 0) {
+            energy_state.path[domain][0] = '\0';
+        } else {
+            found++;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+// power PMU：events/energy-pkg 内容形如 "event=0x02"
+static inline int energy_probe_perf(void) {
+    static const char *events[ENERGY_NUM_DOMAINS] = {"energy-pkg", "energy-cores"};
+    char path[128], buf[64];
+    int found = 0;
+
+    if (energy_read_file("/sys/bus/event_source/devices/power/type", buf, sizeof(buf)) != 0) {
+        return 0;
+    }
+    uint32_t type = (uint32_t)atoi(buf);
+
+    for (int d = 0; d < ENERGY_NUM_DOMAINS; d++) {
+        snprintf(path, sizeof(path), "/sys/bus/event_source/devices/power/events/%s", events[d]);
+        if (energy_read_file(path, buf, sizeof(buf)) != 0) continue;
+        char *eq = strchr(buf, '=');
+        if (!eq) continue;
+        uint64_t config = strtoull(eq + 1, NULL, 0);
+
+        snprintf(path, sizeof(path), "/sys/bus/event_source/devices/power/events/%s.scale",
+                 events[d]);
+        double scale = energy_read_double(path);
+        if (scale <= 0) continue;
+
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+
+        // 系统级事件：pid = -1，统计 CPU 0 所在封装
+        int fd = perf_event_open_sys(&attr, -1, 0, -1, 0);
+        if (fd < 0) continue;
+        energy_state.fd[d] = fd;
+        energy_state.scale[d] = scale;
+        found++;
+    }
+    return found;
+}
+
+// 探测数据源，在 main 中调用一次
+static inline const char *energy_init(void) {
+    if (energy_probe_powercap() > 0) {
+        energy_state.source = "powercap (RAPL)";
+    } else if (energy_probe_perf() > 0) {
+        energy_state.source = "perf power events";
+    } else {
+        energy_state.source = "unavailable";
+    }
+    return energy_state.source;
+}
+
+// 读取累计能耗（焦耳），不可用时返回 -1
+static inline double energy_read_domain(int d) {
+    if (energy_state.path[d][0] != '\0') {
+        double uj = energy_read_double(energy_state.path[d]);
+        return uj < 0 ? -1 : uj * 1e-6;
+    }
+    if (energy_state.fd[d] >= 0) {
+        uint64_t count;
+        if (read(energy_state.fd[d], &count, sizeof(count)) != sizeof(count)) return -1;
+        return count * energy_state.scale[d];
+    }
+    return -1;
+}
+
+static inline void energy_start(energy_meter_t *m) {
+    for (int d = 0; d < ENERGY_NUM_DOMAINS; d++) m->start[d] = energy_read_domain(d);
+    m->t0 = get_time_sec();
+}
+
+static inline void energy_stop(energy_meter_t *m, energy_sample_t *s) {
+    s->elapsed = get_time_sec() - m->t0;
+    for (int d = 0; d < ENERGY_NUM_DOMAINS; d++) {
+        double now = energy_read_domain(d);
+        if (now < 0 || m->start[d] < 0) {
+            s->joules[d] = -1;
+            continue;
+        }
+        double delta = now - m->start[d];
+        // powercap 计数回绕
+        if (delta < 0 && energy_state.max_range[d] > 0) delta += energy_state.max_range[d] * 1e-6;
+        s->joules[d] = delta;
+    }
+}
+
+// 一行输出：各域焦耳、平均功率和 ops/J（按 package 能耗）
+static inline void energy_print(const energy_sample_t *s, double ops) {
+    printf("Energy:");
+    if (s->joules[ENERGY_PKG] < 0 && s->joules[ENERGY_CORE] < 0) {
+        printf(" n/a (%s)\n", energy_state.source);
+        return;
+    }
+    for (int d = 0; d < ENERGY_NUM_DOMAINS; d++) {
+        if (s->joules[d] < 0) {
+            printf(" %s n/a", energy_domain_names[d]);
+        } else {
+            printf(" %s %.3f J (%.1f W)", energy_domain_names[d], s->joules[d],
+                   s->joules[d] / s->elapsed);
+        }
+        printf(d + 1 < ENERGY_NUM_DOMAINS ? "," : "");
+    }
+    double j = s->joules[ENERGY_PKG] >= 0 ? s->joules[ENERGY_PKG] : s->joules[ENERGY_CORE];
+    if (j > 0) printf(", %.2f M ops/J", ops / j / 1e6);
+    printf("\n");
+}
+
+#endif // ENERGY_H
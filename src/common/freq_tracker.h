@@ -0,0 +1,130 @@
+#ifndef FREQ_TRACKER_H
+#define FREQ_TRACKER_H
+
+#include <fcntl.h>
+#include <x86intrin.h>
+#include "cpu_bindind.h"
+#include "perf_counters.h"
+
+// 有效频率跟踪
+//
+// 超线程/多核运行会改变睿频，只比较墙钟时间会把频率变化和资源争用
+// 混在一起。本文件在每个被测线程内采样实际核心周期，给出
+// 时间、周期数和有效 GHz，便于换算成与频率无关的 cycles/op。
+//
+// 按优先级选择数据源（当前线程）：
+//   perf       cycles / ref-cycles，有效 GHz = TSC 频率 * cycles / ref-cycles；
+//              没有 ref-cycles（AMD）时用 cycles / 时间
+//   aperf      /dev/cpu/N/msr 的 APERF/MPERF（需要 root 和 msr 模块）
+//   tsc        只有 TSC，周期为参考周期，GHz 不可用
+//
+// 用法：main 中调用 freq_init() 校准 TSC，被测线程绑核后
+// freq_start(&ft, cpu) ... freq_stop(&ft, &sample)。
+
+#define MSR_IA32_MPERF 0xE7
+#define MSR_IA32_APERF 0xE8
+
+typedef struct {
+    double elapsed;      // 秒
+    double cycles;       // 核心周期（tsc 源时为参考周期）
+    double ghz;          // 有效频率，< 0 表示不可用
+    const char *source;
+} freq_sample_t;
+
+typedef struct {
+    perf_counter_t cycles;
+    perf_counter_t ref_cycles;
+    int msr_fd;
+    uint64_t aperf, mperf;
+    uint64_t tsc;
+    double t0;
+} freq_tracker_t;
+
+static double freq_tsc_ghz;
+
+// 对照 CLOCK_MONOTONIC 校准 TSC 频率，main 中调用一次
+static inline double freq_init(void) {
+    double t0 = get_time_sec();
+    uint64_t c0 = __rdtsc();
+    while (get_time_sec() - t0 < 0.05) {
+    }
+    double t1 = get_time_sec();
+    uint64_t c1 = __rdtsc();
+    freq_tsc_ghz = (c1 - c0) / (t1 - t0) / 1e9;
+    return freq_tsc_ghz;
+}
+
+static inline int freq_msr_read(int fd, uint32_t reg, uint64_t *value) {
+    return pread(fd, value, sizeof(*value), reg) == sizeof(*value) ? 0 : -1;
+}
+
+// 在已绑定到 cpu_id 的线程中调用
+static inline void freq_start(freq_tracker_t *ft, int cpu_id) {
+    perf_counter_open(&ft->cycles, "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    perf_counter_open(&ft->ref_cycles, "ref-cycles", PERF_TYPE_HARDWARE,
+                      PERF_COUNT_HW_REF_CPU_CYCLES);
+
+    ft->msr_fd = -1;
+    if (!perf_counter_valid(&ft->cycles)) {
+        char path[64];
+        snprintf(path, sizeof(path), "/dev/cpu/%d/msr", cpu_id);
+        ft->msr_fd = open(path, O_RDONLY);
+        if (ft->msr_fd >= 0 && (freq_msr_read(ft->msr_fd, MSR_IA32_APERF, &ft->aperf) != 0 ||
+                                freq_msr_read(ft->msr_fd, MSR_IA32_MPERF, &ft->mperf) != 0)) {
+            close(ft->msr_fd);
+            ft->msr_fd = -1;
+        }
+    }
+
+    perf_counter_start(&ft->cycles);
+    perf_counter_start(&ft->ref_cycles);
+    ft->t0 = get_time_sec();
+    ft->tsc = __rdtsc();
+}
+
+static inline void freq_stop(freq_tracker_t *ft, freq_sample_t *s) {
+    uint64_t tsc = __rdtsc();
+    s->elapsed = get_time_sec() - ft->t0;
+    perf_counter_stop(&ft->cycles);
+    perf_counter_stop(&ft->ref_cycles);
+
+    uint64_t aperf = 0, mperf = 0;
+    int msr_ok = ft->msr_fd >= 0 && freq_msr_read(ft->msr_fd, MSR_IA32_APERF, &aperf) == 0 &&
+                 freq_msr_read(ft->msr_fd, MSR_IA32_MPERF, &mperf) == 0;
+
+    s->ghz = -1;
+    if (perf_counter_valid(&ft->cycles) && ft->cycles.value > 0) {
+        s->cycles = ft->cycles.value;
+        if (perf_counter_valid(&ft->ref_cycles) && ft->ref_cycles.value > 0) {
+            s->ghz = freq_tsc_ghz * ft->cycles.value / ft->ref_cycles.value;
+            s->source = "perf cycles/ref-cycles";
+        } else {
+            s->ghz = ft->cycles.value / s->elapsed / 1e9;
+            s->source = "perf cycles";
+        }
+    } else if (msr_ok && mperf > ft->mperf) {
+        s->cycles = aperf - ft->aperf;
+        s->ghz = freq_tsc_ghz * (aperf - ft->aperf) / (mperf - ft->mperf);
+        s->source = "aperf/mperf";
+    } else {
+        s->cycles = tsc - ft->tsc;
+        s->source = "tsc (reference cycles)";
+    }
+
+    perf_counter_close(&ft->cycles);
+    perf_counter_close(&ft->ref_cycles);
+    if (ft->msr_fd >= 0) close(ft->msr_fd);
+    ft->msr_fd = -1;
+}
+
+// 格式化 GHz，不可用时输出 n/a
+static inline const char *freq_fmt_ghz(const freq_sample_t *s, char *buf, size_t len) {
+    if (s->ghz < 0) {
+        snprintf(buf, len, "n/a");
+    } else {
+        snprintf(buf, len, "%.2f", s->ghz);
+    }
+    return buf;
+}
+
+#endif // FREQ_TRACKER_H
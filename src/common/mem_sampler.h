@@ -0,0 +1,300 @@
+#ifndef MEM_SAMPLER_H
+#define MEM_SAMPLER_H
+
+#include <sys/mman.h>
+#include "perf_counters.h"
+
+// 数据地址采样：把缺失归因到具体缓冲区和偏移
+//
+// cache-misses 计数只说明缺失多少，不说明发生在哪块内存。本文件在被测
+// 区间内对访存指令采样，记录数据地址和延迟（周期），再映射回程序注册的
+// 缓冲区，输出每个缓冲区的延迟直方图和热点偏移热图。
+//
+// 采样源（按优先级）：
+//   intel-ldlat  MEM_TRANS_RETIRED.LOAD_LATENCY（perf mem-loads），只采样
+//                延迟超过阈值的 load，PEBS 给出精确地址和延迟
+//   amd-ibs      IBS op 采样（ibs_op PMU），内核 6.1 起填充数据地址和延迟；
+//                更早的内核地址为 0，全部计入 unattributed
+// 都不可用时 mem_sampler_init() 返回 "unavailable"，采样调用为空操作。
+//
+// 用法：
+//   mem_sampler_register("array1", array1, size);   // 注册缓冲区
+//   mem_sampler_init();                              // main 中一次
+//   每个被测线程：mem_sampler_open / start / stop（stop 时汇总到缓冲区）/ close
+//   mem_sampler_report();
+
+// 配置参数
+#define MS_MAX_BUFFERS 8
+#define MS_HEAT_BINS 64          // 热图把缓冲区等分为 64 段
+#define MS_LAT_BUCKETS 12        // 延迟直方图：<4, 4-8, ..., >=4096 周期
+#define MS_RING_PAGES 512        // 环形缓冲区 2MB（不含元数据页）
+#define MS_LDLAT_THRESHOLD 30    // Intel load 延迟阈值（周期）
+#define MS_INTEL_PERIOD 1000
+#define MS_IBS_PERIOD 0x10000
+
+typedef struct {
+    const char *name;
+    uintptr_t base;
+    size_t size;
+    uint64_t samples;
+    uint64_t latency_sum;
+    uint64_t lat_hist[MS_LAT_BUCKETS];
+    uint64_t heat_count[MS_HEAT_BINS];
+    uint64_t heat_latency[MS_HEAT_BINS];
+} ms_buffer_t;
+
+typedef enum {
+    MS_NONE,
+    MS_INTEL_LDLAT,
+    MS_AMD_IBS
+} ms_method_t;
+
+static struct {
+    ms_method_t method;
+    uint32_t ibs_type;
+    ms_buffer_t buffers[MS_MAX_BUFFERS];
+    int num_buffers;
+    uint64_t unattributed;
+    uint64_t lost;
+} ms_state;
+
+static const char *ms_method_names[] = {"unavailable", "intel-ldlat (PEBS)", "amd-ibs"};
+
+typedef struct {
+    int fd;
+    void *ring;
+    size_t ring_size;  // 含元数据页
+} mem_sampler_t;
+
+static inline void mem_sampler_register(const char *name, const void *addr, size_t size) {
+    if (ms_state.num_buffers >= MS_MAX_BUFFERS) return;
+    ms_buffer_t *b = &ms_state.buffers[ms_state.num_buffers++];
+    memset(b, 0, sizeof(*b));
+    b->name = name;
+    b->base = (uintptr_t)addr;
+    b->size = size;
+}
+
+// 清空统计（保留注册的缓冲区），用于分别报告每个配置
+static inline void mem_sampler_reset(void) {
+    for (int i = 0; i < ms_state.num_buffers; i++) {
+        ms_buffer_t *b = &ms_state.buffers[i];
+        b->samples = b->latency_sum = 0;
+        memset(b->lat_hist, 0, sizeof(b->lat_hist));
+        memset(b->heat_count, 0, sizeof(b->heat_count));
+        memset(b->heat_latency, 0, sizeof(b->heat_latency));
+    }
+    ms_state.unattributed = ms_state.lost = 0;
+}
+
+static inline int ms_open_event(mem_sampler_t *s, ms_method_t method) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_ADDR | PERF_SAMPLE_WEIGHT;
+
+    if (method == MS_INTEL_LDLAT) {
+        attr.type = PERF_TYPE_RAW;
+        attr.config = 0x1cd;  // MEM_TRANS_RETIRED.LOAD_LATENCY
+        attr.config1 = MS_LDLAT_THRESHOLD;
+        attr.sample_period = MS_INTEL_PERIOD;
+        attr.precise_ip = 2;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+    } else if (method == MS_AMD_IBS) {
+        // IBS 不支持 exclude_kernel，内核地址在归因时丢弃
+        attr.type = ms_state.ibs_type;
+        attr.config = 0;
+        attr.sample_period = MS_IBS_PERIOD;
+    } else {
+        return -1;
+    }
+
+    s->fd = perf_event_open_sys(&attr, 0, -1, -1, 0);
+    return s->fd >= 0 ? 0 : -1;
+}
+
+// 探测采样源，在 main 中调用一次
+static inline const char *mem_sampler_init(void) {
+    mem_sampler_t s;
+    FILE *f;
+
+    ms_state.method = MS_NONE;
+    if (access("/sys/bus/event_source/devices/cpu/events/mem-loads", F_OK) == 0 &&
+        ms_open_event(&s, MS_INTEL_LDLAT) == 0) {
+        ms_state.method = MS_INTEL_LDLAT;
+        close(s.fd);
+    } else if ((f = fopen("/sys/bus/event_source/devices/ibs_op/type", "r")) != NULL) {
+        unsigned type;
+        if (fscanf(f, "%u", &type) == 1) {
+            ms_state.ibs_type = type;
+            if (ms_open_event(&s, MS_AMD_IBS) == 0) {
+                ms_state.method = MS_AMD_IBS;
+                close(s.fd);
+            }
+        }
+        fclose(f);
+    }
+    return ms_method_names[ms_state.method];
+}
+
+static inline int mem_sampler_available(void) {
+    return ms_state.method != MS_NONE;
+}
+
+// 为当前线程打开采样事件并映射环形缓冲区
+static inline int mem_sampler_open(mem_sampler_t *s) {
+    s->fd = -1;
+    s->ring = NULL;
+    if (ms_open_event(s, ms_state.method) != 0) return -1;
+
+    s->ring_size = (size_t)(MS_RING_PAGES + 1) * sysconf(_SC_PAGESIZE);
+    s->ring = mmap(NULL, s->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, s->fd, 0);
+    if (s->ring == MAP_FAILED) {
+        close(s->fd);
+        s->fd = -1;
+        s->ring = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static inline void mem_sampler_start(mem_sampler_t *s) {
+    if (s->fd < 0) return;
+    ioctl(s->fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(s->fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static inline int ms_lat_bucket(uint64_t latency) {
+    int b = 0;
+    while (b < MS_LAT_BUCKETS - 1 && latency >= (4ULL << b)) b++;
+    return b;
+}
+
+// 一条样本归因到缓冲区（多个线程可能同时汇总，使用原子加）
+static inline void ms_attribute(uint64_t addr, uint64_t latency) {
+    for (int i = 0; i < ms_state.num_buffers; i++) {
+        ms_buffer_t *b = &ms_state.buffers[i];
+        if (addr < b->base || addr >= b->base + b->size) continue;
+
+        size_t bin = (size_t)((addr - b->base) * MS_HEAT_BINS / b->size);
+        __atomic_fetch_add(&b->samples, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&b->latency_sum, latency, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&b->lat_hist[ms_lat_bucket(latency)], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&b->heat_count[bin], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&b->heat_latency[bin], latency, __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_fetch_add(&ms_state.unattributed, 1, __ATOMIC_RELAXED);
+}
+
+// 停止采样并解析环形缓冲区中的所有记录
+static inline void mem_sampler_stop(mem_sampler_t *s) {
+    if (s->fd < 0) return;
+    ioctl(s->fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    struct perf_event_mmap_page *meta = (struct perf_event_mmap_page *)s->ring;
+    char *data = (char *)s->ring + sysconf(_SC_PAGESIZE);
+    uint64_t data_size = s->ring_size - sysconf(_SC_PAGESIZE);
+    uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+    uint64_t tail = meta->data_tail;
+
+    while (tail < head) {
+        struct perf_event_header hdr;
+        char record[256];
+        uint64_t off = tail % data_size;
+
+        // 记录可能跨越环形缓冲区末尾，先拷贝出来
+        for (size_t i = 0; i < sizeof(hdr); i++) ((char *)&hdr)[i] = data[(off + i) % data_size];
+        if (hdr.size == 0) break;
+        size_t len = hdr.size < sizeof(record) ? hdr.size : sizeof(record);
+        for (size_t i = 0; i < len; i++) record[i] = data[(off + i) % data_size];
+
+        if (hdr.type == PERF_RECORD_SAMPLE) {
+            // 布局：header, ip, pid/tid, addr, weight
+            uint64_t *fields = (uint64_t *)(record + sizeof(hdr));
+            uint64_t addr = fields[2];
+            uint64_t weight = fields[3];
+            if (addr != 0 && addr < 0x800000000000ULL) ms_attribute(addr, weight);
+        } else if (hdr.type == PERF_RECORD_LOST) {
+            // 布局：header, id, lost
+            uint64_t *fields = (uint64_t *)(record + sizeof(hdr));
+            __atomic_fetch_add(&ms_state.lost, fields[1], __ATOMIC_RELAXED);
+        }
+        tail += hdr.size;
+    }
+    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+}
+
+static inline void mem_sampler_close(mem_sampler_t *s) {
+    if (s->ring) munmap(s->ring, s->ring_size);
+    if (s->fd >= 0) close(s->fd);
+    s->ring = NULL;
+    s->fd = -1;
+}
+
+// 每个缓冲区：样本数、平均延迟、延迟直方图、热点偏移热图
+static inline void mem_sampler_report(const char *title) {
+    static const char shades[] = " .:-=+*#%@";
+
+    printf("\n--- Memory Access Samples: %s (%s) ---\n", title, ms_method_names[ms_state.method]);
+    if (ms_state.method == MS_NONE) {
+        printf("Sampling not available (needs PEBS load latency or AMD IBS and\n");
+        printf("perf_event_paranoid <= 1)\n");
+        return;
+    }
+
+    for (int i = 0; i < ms_state.num_buffers; i++) {
+        ms_buffer_t *b = &ms_state.buffers[i];
+        printf("\n[%s] %zu KB, %lu samples", b->name, b->size / 1024, b->samples);
+        if (b->samples == 0) {
+            printf("\n");
+            continue;
+        }
+        printf(", avg latency %.1f cycles\n", (double)b->latency_sum / b->samples);
+
+        printf("  Latency histogram (cycles):\n");
+        for (int k = 0; k < MS_LAT_BUCKETS; k++) {
+            if (b->lat_hist[k] == 0) continue;
+            char range[32];
+            if (k == 0) {
+                snprintf(range, sizeof(range), "<4");
+            } else if (k == MS_LAT_BUCKETS - 1) {
+                snprintf(range, sizeof(range), ">=%llu", 4ULL << (k - 1));
+            } else {
+                snprintf(range, sizeof(range), "%llu-%llu", 4ULL << (k - 1), (4ULL << k) - 1);
+            }
+            int bar = (int)(b->lat_hist[k] * 40 / b->samples);
+            printf("  %10s %8lu %5.1f%% ", range, b->lat_hist[k],
+                   100.0 * b->lat_hist[k] / b->samples);
+            for (int j = 0; j < bar; j++) putchar('#');
+            printf("\n");
+        }
+
+        // 热图：每个字符一段，浓淡表示样本数
+        uint64_t max = 0;
+        int hottest = 0;
+        for (int k = 0; k < MS_HEAT_BINS; k++) {
+            if (b->heat_count[k] > max) {
+                max = b->heat_count[k];
+                hottest = k;
+            }
+        }
+        printf("  Offset heatmap (%zu KB per cell): |", b->size / MS_HEAT_BINS / 1024);
+        for (int k = 0; k < MS_HEAT_BINS; k++) {
+            int level = (int)(b->heat_count[k] * 9 / max);
+            if (b->heat_count[k] > 0 && level == 0) level = 1;
+            putchar(shades[level]);
+        }
+        printf("|\n");
+        printf("  Hottest range: +%zu..+%zu KB, %lu samples, avg %.1f cycles\n",
+               b->size / MS_HEAT_BINS * hottest / 1024,
+               b->size / MS_HEAT_BINS * (hottest + 1) / 1024, max,
+               (double)b->heat_latency[hottest] / max);
+    }
+    printf("\nUnattributed samples (stack, libraries, other heap): %lu\n", ms_state.unattributed);
+    if (ms_state.lost > 0) printf("Lost samples (ring buffer overflow): %lu\n", ms_state.lost);
+}
+
+#endif // MEM_SAMPLER_H
@@ -0,0 +1,257 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include "prefetch_utils.h"
+
+// 定长对象池：每 CPU 弹匣（magazine）+ 全局 depot
+//
+// 对象大小向上取整到缓存行的整数倍并按缓存行对齐，相邻对象不会共享
+// 缓存行，不同线程持有的对象之间没有伪共享。
+//
+// 每个 CPU 一个缓存（op_cache_t），持有 loaded / previous 两个弹匣，
+// 每个最多 OP_MAG_SIZE 个对象指针：
+//   分配  loaded 非空则弹出；否则与 previous 交换；两个都空时从 depot
+//         取一个满弹匣，depot 也空时从对象区切一批新对象
+//   释放  loaded 未满则压入；否则与 previous 交换；两个都满时把 previous
+//         交给 depot，换回一个空弹匣
+// 快速路径只访问本 CPU 的缓存，没有原子操作；depot 是两个无锁栈（满 /
+// 空弹匣），栈顶为 (tag << 32 | 索引 + 1)，tag 每次更新加一，避免 ABA。
+// 弹匣来自预分配的数组，从不释放，出栈时读取 next 是安全的。
+//
+// 每个缓存同一时刻只能由一个线程使用：按本仓库的惯例把线程绑定到 CPU，
+// 用 CPU 号（或线程号）选择缓存即可。线程退出前调用 obj_pool_cache_flush()
+// 把对象还给 depot。
+//
+// 用法：
+//   obj_pool_t pool;
+//   obj_pool_init(&pool, sizeof(request_t), max_objects, num_cpus);
+//   op_cache_t *c = obj_pool_cache(&pool, cpu_id);
+//   p = obj_pool_alloc(c); ... obj_pool_free(c, p);
+//   n = obj_pool_alloc_bulk(c, ptrs, 32); ... obj_pool_free_bulk(c, ptrs, n);
+//   obj_pool_destroy(&pool);
+
+// 配置参数
+#define OP_MAG_SIZE 64           // 每个弹匣的对象数
+
+typedef struct {
+    uint32_t next;               // depot 栈中的下一个弹匣（索引 + 1，0 表示栈底）
+    uint32_t count;
+    void *objs[OP_MAG_SIZE];
+} CACHE_ALIGNED op_magazine_t;
+
+typedef struct obj_pool obj_pool_t;
+
+typedef struct {
+    obj_pool_t *pool;
+    op_magazine_t *loaded;
+    op_magazine_t *previous;
+} CACHE_ALIGNED op_cache_t;
+
+struct obj_pool {
+    size_t obj_size;             // 缓存行整数倍
+    size_t max_objects;
+    char *base;                  // 对象区（按需分配物理页）
+    op_magazine_t *mags;
+    uint32_t max_mags;
+    op_cache_t *caches;
+    int num_caches;
+    CACHE_PADDED(size_t, next_obj);     // 对象区中下一个未切分的对象
+    CACHE_PADDED(uint32_t, next_mag);   // 弹匣数组中下一个未用的弹匣
+    CACHE_PADDED(uint64_t, full);       // depot：满弹匣栈
+    CACHE_PADDED(uint64_t, empty);      // depot：空弹匣栈
+};
+
+static inline void op_depot_push(obj_pool_t *pool, uint64_t *top, op_magazine_t *m) {
+    uint32_t idx = (uint32_t)(m - pool->mags) + 1;
+    uint64_t old = __atomic_load_n(top, __ATOMIC_RELAXED);
+    uint64_t val;
+    do {
+        m->next = (uint32_t)old;
+        val = ((old >> 32) + 1) << 32 | idx;
+    } while (!__atomic_compare_exchange_n(top, &old, val, 1, __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+}
+
+static inline op_magazine_t *op_depot_pop(obj_pool_t *pool, uint64_t *top) {
+    uint64_t old = __atomic_load_n(top, __ATOMIC_ACQUIRE);
+    uint64_t val;
+    do {
+        if ((uint32_t)old == 0) return NULL;
+        uint32_t next = __atomic_load_n(&pool->mags[(uint32_t)old - 1].next, __ATOMIC_RELAXED);
+        val = ((old >> 32) + 1) << 32 | next;
+    } while (!__atomic_compare_exchange_n(top, &old, val, 1, __ATOMIC_ACQUIRE,
+                                          __ATOMIC_ACQUIRE));
+    return &pool->mags[(uint32_t)old - 1];
+}
+
+// 取一个空弹匣：先找 depot，再用新的
+static inline op_magazine_t *op_empty_magazine(obj_pool_t *pool) {
+    op_magazine_t *m = op_depot_pop(pool, &pool->empty.value);
+    if (m) return m;
+    uint32_t idx = __atomic_fetch_add(&pool->next_mag.value, 1, __ATOMIC_RELAXED);
+    if (idx >= pool->max_mags) {
+        fprintf(stderr, "object pool: out of magazines\n");
+        exit(1);
+    }
+    m = &pool->mags[idx];
+    m->count = 0;
+    return m;
+}
+
+// 从对象区切一批新对象装入空弹匣，返回装入的个数
+static inline uint32_t op_carve(obj_pool_t *pool, op_magazine_t *m) {
+    size_t first = __atomic_fetch_add(&pool->next_obj.value, OP_MAG_SIZE, __ATOMIC_RELAXED);
+    if (first >= pool->max_objects) return 0;
+    size_t n = pool->max_objects - first < OP_MAG_SIZE ? pool->max_objects - first : OP_MAG_SIZE;
+    // 倒序装入，使连续分配得到地址递增的对象
+    for (size_t i = 0; i < n; i++) {
+        m->objs[i] = pool->base + (first + n - 1 - i) * pool->obj_size;
+    }
+    m->count = (uint32_t)n;
+    return m->count;
+}
+
+static inline int obj_pool_init(obj_pool_t *pool, size_t obj_size, size_t max_objects,
+                                int num_caches) {
+    memset(pool, 0, sizeof(*pool));
+    pool->obj_size = (obj_size + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+    pool->max_objects = max_objects;
+    pool->num_caches = num_caches;
+    // 每个缓存 2 个弹匣；满弹匣最多 max_objects / OP_MAG_SIZE 个，缓存刷新
+    // 可能再留下每个缓存 1 个未满的弹匣
+    pool->max_mags = (uint32_t)(max_objects / OP_MAG_SIZE) + 3 * num_caches + 1;
+
+    pool->base = mmap(NULL, pool->obj_size * max_objects, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (pool->base == MAP_FAILED) {
+        pool->base = NULL;
+        return -1;
+    }
+    pool->mags = aligned_alloc(CACHE_LINE_SIZE, pool->max_mags * sizeof(op_magazine_t));
+    pool->caches = aligned_alloc(CACHE_LINE_SIZE, num_caches * sizeof(op_cache_t));
+    if (!pool->mags || !pool->caches) return -1;
+
+    for (int i = 0; i < num_caches; i++) {
+        op_cache_t *c = &pool->caches[i];
+        c->pool = pool;
+        c->loaded = op_empty_magazine(pool);
+        c->previous = op_empty_magazine(pool);
+    }
+    return 0;
+}
+
+static inline void obj_pool_destroy(obj_pool_t *pool) {
+    if (pool->base) munmap(pool->base, pool->obj_size * pool->max_objects);
+    free(pool->mags);
+    free(pool->caches);
+    memset(pool, 0, sizeof(*pool));
+}
+
+static inline op_cache_t *obj_pool_cache(obj_pool_t *pool, int idx) {
+    return &pool->caches[idx % pool->num_caches];
+}
+
+// 慢速路径：loaded 为空
+static inline void *op_alloc_slow(op_cache_t *c) {
+    obj_pool_t *pool = c->pool;
+    op_magazine_t *tmp;
+
+    if (c->previous->count > 0) {
+        tmp = c->loaded;
+        c->loaded = c->previous;
+        c->previous = tmp;
+    } else {
+        op_magazine_t *full = op_depot_pop(pool, &pool->full.value);
+        if (full) {
+            op_depot_push(pool, &pool->empty.value, c->previous);
+            c->previous = c->loaded;
+            c->loaded = full;
+        } else if (op_carve(pool, c->loaded) == 0) {
+            return NULL;
+        }
+    }
+    return c->loaded->objs[--c->loaded->count];
+}
+
+static inline void *obj_pool_alloc(op_cache_t *c) {
+    op_magazine_t *m = c->loaded;
+    if (__builtin_expect(m->count > 0, 1)) return m->objs[--m->count];
+    return op_alloc_slow(c);
+}
+
+// 慢速路径：loaded 已满
+static inline void op_free_slow(op_cache_t *c, void *p) {
+    obj_pool_t *pool = c->pool;
+    op_magazine_t *tmp;
+
+    if (c->previous->count < OP_MAG_SIZE) {
+        tmp = c->loaded;
+        c->loaded = c->previous;
+        c->previous = tmp;
+    } else {
+        op_depot_push(pool, &pool->full.value, c->previous);
+        c->previous = c->loaded;
+        c->loaded = op_empty_magazine(pool);
+    }
+    c->loaded->objs[c->loaded->count++] = p;
+}
+
+static inline void obj_pool_free(op_cache_t *c, void *p) {
+    op_magazine_t *m = c->loaded;
+    if (__builtin_expect(m->count < OP_MAG_SIZE, 1)) {
+        m->objs[m->count++] = p;
+        return;
+    }
+    op_free_slow(c, p);
+}
+
+// 批量分配：整段从弹匣复制，返回实际得到的个数（对象区耗尽时少于 n）
+static inline size_t obj_pool_alloc_bulk(op_cache_t *c, void **out, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+        op_magazine_t *m = c->loaded;
+        size_t take = n - got < m->count ? n - got : m->count;
+        m->count -= (uint32_t)take;
+        memcpy(out + got, &m->objs[m->count], take * sizeof(void *));
+        got += take;
+        if (got < n) {
+            void *p = op_alloc_slow(c);
+            if (!p) break;
+            out[got++] = p;
+        }
+    }
+    return got;
+}
+
+static inline void obj_pool_free_bulk(op_cache_t *c, void *const *ptrs, size_t n) {
+    size_t done = 0;
+    while (done < n) {
+        op_magazine_t *m = c->loaded;
+        size_t put = n - done < OP_MAG_SIZE - m->count ? n - done : OP_MAG_SIZE - m->count;
+        memcpy(&m->objs[m->count], ptrs + done, put * sizeof(void *));
+        m->count += (uint32_t)put;
+        done += put;
+        if (done < n) op_free_slow(c, ptrs[done++]);
+    }
+}
+
+// 把缓存中的对象交还 depot（线程退出前调用），缓存之后仍可继续使用
+static inline void obj_pool_cache_flush(op_cache_t *c) {
+    obj_pool_t *pool = c->pool;
+    op_magazine_t *mags[2] = {c->loaded, c->previous};
+    for (int i = 0; i < 2; i++) {
+        if (mags[i]->count > 0) {
+            op_depot_push(pool, &pool->full.value, mags[i]);
+            mags[i] = op_empty_magazine(pool);
+        }
+    }
+    c->loaded = mags[0];
+    c->previous = mags[1];
+}
+
+#endif // OBJECT_POOL_H
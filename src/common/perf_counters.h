@@ -0,0 +1,106 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// perf_event_open 封装：在程序内部统计当前线程的硬件事件
+// 与 scripts/run_perf.sh 不同，可以只统计被测区间，并区分每个线程
+//
+// 事件不可用时（perf_event_paranoid 过高、虚拟机没有 PMU、
+// CPU 不支持该事件）fd 为 -1，读数返回 0，调用方据此输出 n/a
+
+// 通用缓存事件编码: cache | (op << 8) | (result << 16)
+#define PERF_CACHE_EVENT(cache, op, result) \
+    ((cache) | ((op) << 8) | ((result) << 16))
+
+#define PERF_L1D_READ_MISS \
+    PERF_CACHE_EVENT(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, \
+                     PERF_COUNT_HW_CACHE_RESULT_MISS)
+#define PERF_LLC_READ_MISS \
+    PERF_CACHE_EVENT(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, \
+                     PERF_COUNT_HW_CACHE_RESULT_MISS)
+
+typedef struct {
+    int fd;
+    const char *name;
+    uint64_t value;  // 最近一次 stop 的读数
+} perf_counter_t;
+
+static inline int perf_event_open_sys(struct perf_event_attr *attr, pid_t pid,
+                                      int cpu, int group_fd, unsigned long flags) {
+    return (int)syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+// 打开一个只统计用户态的计数器（当前线程，任意 CPU）
+static inline int perf_counter_open(perf_counter_t *c, const char *name,
+                                    uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    c->name = name;
+    c->value = 0;
+    c->fd = perf_event_open_sys(&attr, 0, -1, -1, 0);
+    return c->fd >= 0 ? 0 : -1;
+}
+
+static inline int perf_counter_valid(const perf_counter_t *c) {
+    return c->fd >= 0;
+}
+
+static inline void perf_counter_start(perf_counter_t *c) {
+    if (c->fd < 0) return;
+    ioctl(c->fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(c->fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static inline uint64_t perf_counter_stop(perf_counter_t *c) {
+    if (c->fd < 0) return 0;
+    ioctl(c->fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(c->fd, &c->value, sizeof(c->value)) != sizeof(c->value)) {
+        c->value = 0;
+    }
+    return c->value;
+}
+
+static inline void perf_counter_close(perf_counter_t *c) {
+    if (c->fd >= 0) close(c->fd);
+    c->fd = -1;
+}
+
+// 批量操作
+static inline void perf_counters_start(perf_counter_t *cs, int n) {
+    for (int i = 0; i < n; i++) perf_counter_start(&cs[i]);
+}
+
+static inline void perf_counters_stop(perf_counter_t *cs, int n) {
+    for (int i = 0; i < n; i++) perf_counter_stop(&cs[i]);
+}
+
+static inline void perf_counters_close(perf_counter_t *cs, int n) {
+    for (int i = 0; i < n; i++) perf_counter_close(&cs[i]);
+}
+
+// 格式化计数值，不可用时输出 n/a
+static inline const char *perf_counter_fmt(const perf_counter_t *c, char *buf, size_t len,
+                                           double scale) {
+    if (c->fd < 0) {
+        snprintf(buf, len, "n/a");
+    } else {
+        snprintf(buf, len, "%.2f", c->value * scale);
+    }
+    return buf;
+}
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,388 @@
+#ifndef TOPDOWN_H
+#define TOPDOWN_H
+
+#include <cpuid.h>
+#include "perf_counters.h"
+
+// Top-down 流水线槽位分析（TMA level 1 / level 2）
+//
+// 原始 cache-misses 只说明缺失多，不说明线程卡在哪里。top-down 把每个
+// 周期的发射/分派槽位分成四类：
+//   Retiring       有用的工作
+//   Bad Spec       被冲刷掉的错误推测
+//   Frontend Bound 前端没有提供 uop
+//   Backend Bound  后端资源（访存、执行单元）满
+// 两个线程放在同一核心时，一方 Backend(Memory) 高、另一方 Retiring 高
+// 通常互补；两方都 Backend(Core) 高则争用同一执行资源。
+//
+// 实现（按优先级探测，当前线程计数，读不到时自动降级）：
+//   intel-perf-metrics  Ice Lake 及之后的 slots + topdown-* 伪事件
+//   intel-legacy        Skylake 公式（4 槽宽），只有 level 1
+//   amd-zen4            Zen 4/5 de_no_dispatch_per_slot 等（6 槽宽），
+//                       另有 SMT contention 类：被同核另一线程占用的槽位
+//   generic-stalls      stalled-cycles-frontend/backend 占周期比例（近似）
+// 全部不可用时结果 level = 0，打印 n/a。
+//
+// 用法：main 中先调用 topdown_init()，每个被测线程在自己的上下文中
+// topdown_open / start / stop / read / close。
+
+typedef enum {
+    TD_NONE,
+    TD_INTEL_METRICS,
+    TD_INTEL_LEGACY,
+    TD_AMD_ZEN4,
+    TD_GENERIC
+} td_method_t;
+
+#define TD_MAX_EVENTS 10
+
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+} td_event_t;
+
+typedef struct {
+    int fds[TD_MAX_EVENTS];
+    int n;
+    uint64_t values[TD_MAX_EVENTS];  // 已按多路复用比例换算
+    int valid;
+} td_group_t;
+
+typedef struct {
+    td_group_t groups[2];
+    int level;
+} topdown_counters_t;
+
+// 所有比例为槽位占比 0..1，< 0 表示不可用
+typedef struct {
+    int level;
+    double retiring, bad_spec, frontend, backend;
+    double smt_contention;
+    double fe_latency, fe_bandwidth;
+    double branch_mispredict, machine_clears;
+    double be_memory, be_core;
+    double retire_light, retire_heavy;
+} topdown_result_t;
+
+static td_method_t td_method = TD_NONE;
+
+static const char *td_method_names[] = {
+    "none", "intel-perf-metrics", "intel-legacy", "amd-zen4", "generic-stalls (approx)"
+};
+
+// AMD 原始事件：event[7:0]、umask、cmask、event[11:8]
+#define TD_AMD_RAW(event, umask, cmask) \
+    (((event) & 0xffULL) | ((uint64_t)(umask) << 8) | ((uint64_t)(cmask) << 24) | \
+     (((uint64_t)(event) & 0xf00) << 24))
+#define TD_INTEL_RAW(event, umask) ((event) | ((umask) << 8))
+
+static inline int td_group_open(td_group_t *g, const td_event_t *events, int n) {
+    g->n = 0;
+    g->valid = 0;
+    for (int i = 0; i < n; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.disabled = i == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        int fd = perf_event_open_sys(&attr, 0, -1, i == 0 ? -1 : g->fds[0], 0);
+        if (fd < 0) {
+            for (int j = 0; j < g->n; j++) close(g->fds[j]);
+            g->n = 0;
+            return -1;
+        }
+        g->fds[g->n++] = fd;
+    }
+    return 0;
+}
+
+static inline void td_group_close(td_group_t *g) {
+    for (int i = 0; i < g->n; i++) close(g->fds[i]);
+    g->n = 0;
+}
+
+static inline void td_group_start(td_group_t *g) {
+    if (g->n == 0) return;
+    ioctl(g->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(g->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static inline void td_group_stop(td_group_t *g) {
+    uint64_t buf[3 + TD_MAX_EVENTS];
+
+    g->valid = 0;
+    if (g->n == 0) return;
+    ioctl(g->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (read(g->fds[0], buf, sizeof(buf)) < (ssize_t)((3 + g->n) * sizeof(uint64_t))) return;
+
+    // buf: nr, time_enabled, time_running, values[nr]
+    if (buf[2] == 0) return;
+    double scale = (double)buf[1] / buf[2];
+    for (int i = 0; i < g->n; i++) g->values[i] = (uint64_t)(buf[3 + i] * scale);
+    g->valid = 1;
+}
+
+// 混合架构下 P 核的 PMU 类型为 cpu_core，否则为通用 RAW
+static inline uint32_t td_core_pmu_type(void) {
+    FILE *f = fopen("/sys/bus/event_source/devices/cpu_core/type", "r");
+    unsigned type = PERF_TYPE_RAW;
+    if (f) {
+        if (fscanf(f, "%u", &type) != 1) type = PERF_TYPE_RAW;
+        fclose(f);
+    }
+    return type;
+}
+
+static inline int td_sysfs_event_exists(const char *event) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/bus/event_source/devices/cpu/events/%s", event);
+    if (access(path, F_OK) == 0) return 1;
+    snprintf(path, sizeof(path), "/sys/bus/event_source/devices/cpu_core/events/%s", event);
+    return access(path, F_OK) == 0;
+}
+
+// 按方法打开两组事件：第 0 组为 level 1，第 1 组为 level 2（可选）
+static inline int td_open_method(topdown_counters_t *tc, td_method_t method) {
+    uint32_t raw = td_core_pmu_type();
+    uint32_t hw = PERF_TYPE_HARDWARE;
+
+    tc->level = 0;
+    tc->groups[0].n = tc->groups[1].n = 0;
+
+    if (method == TD_INTEL_METRICS) {
+        // slots 必须是组长，topdown-* 伪事件读出的是换算成槽位数的值
+        td_event_t ev[9] = {
+            {raw, 0x0400}, {raw, 0x8000}, {raw, 0x8100}, {raw, 0x8200}, {raw, 0x8300},
+            {raw, 0x8400}, {raw, 0x8500}, {raw, 0x8600}, {raw, 0x8700}
+        };
+        if (td_sysfs_event_exists("topdown-heavy-ops") &&
+            td_group_open(&tc->groups[0], ev, 9) == 0) {
+            tc->level = 2;
+        } else if (td_group_open(&tc->groups[0], ev, 5) == 0) {
+            tc->level = 1;
+        }
+    } else if (method == TD_INTEL_LEGACY) {
+        td_event_t ev[5] = {
+            {hw, PERF_COUNT_HW_CPU_CYCLES},
+            {raw, TD_INTEL_RAW(0x0E, 0x01)},  // UOPS_ISSUED.ANY
+            {raw, TD_INTEL_RAW(0xC2, 0x02)},  // UOPS_RETIRED.RETIRE_SLOTS
+            {raw, TD_INTEL_RAW(0x9C, 0x01)},  // IDQ_UOPS_NOT_DELIVERED.CORE
+            {raw, TD_INTEL_RAW(0x0D, 0x01)}   // INT_MISC.RECOVERY_CYCLES
+        };
+        if (td_group_open(&tc->groups[0], ev, 5) == 0) tc->level = 1;
+    } else if (method == TD_AMD_ZEN4) {
+        td_event_t l1[6] = {
+            {hw, PERF_COUNT_HW_CPU_CYCLES},
+            {raw, TD_AMD_RAW(0x1A0, 0x01, 0)},  // de_no_dispatch_per_slot.no_ops_from_frontend
+            {raw, TD_AMD_RAW(0x1A0, 0x1E, 0)},  // de_no_dispatch_per_slot.backend_stalls
+            {raw, TD_AMD_RAW(0x1A0, 0x60, 0)},  // de_no_dispatch_per_slot.smt_contention
+            {raw, TD_AMD_RAW(0x0AA, 0x07, 0)},  // de_src_op_disp.all
+            {raw, TD_AMD_RAW(0x0C1, 0x00, 0)}   // ex_ret_ops
+        };
+        td_event_t l2[6] = {
+            {raw, TD_AMD_RAW(0x1A0, 0x01, 6)},  // 整周期 6 槽全空（前端延迟）
+            {raw, TD_AMD_RAW(0x0C3, 0x00, 0)},  // ex_ret_brn_misp
+            {raw, TD_AMD_RAW(0x096, 0x00, 0)},  // resyncs_or_nc_redirects
+            {raw, TD_AMD_RAW(0x0D6, 0xA2, 0)},  // ex_no_retire.load_not_complete
+            {raw, TD_AMD_RAW(0x0D6, 0x02, 0)},  // ex_no_retire.not_complete
+            {raw, TD_AMD_RAW(0x1C1, 0x00, 0)}   // ex_ret_ucode_ops
+        };
+        if (td_group_open(&tc->groups[0], l1, 6) == 0) {
+            tc->level = td_group_open(&tc->groups[1], l2, 6) == 0 ? 2 : 1;
+        }
+    } else if (method == TD_GENERIC) {
+        td_event_t ev[3] = {
+            {hw, PERF_COUNT_HW_CPU_CYCLES},
+            {hw, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+            {hw, PERF_COUNT_HW_STALLED_CYCLES_BACKEND}
+        };
+        if (td_group_open(&tc->groups[0], ev, 3) == 0) tc->level = 1;
+    }
+
+    return tc->level > 0 ? 0 : -1;
+}
+
+// 为当前线程打开 top-down 计数器，失败时 level = 0，之后的
+// start/stop/close 都是空操作
+static inline int topdown_open(topdown_counters_t *tc) {
+    memset(tc, 0, sizeof(*tc));
+    if (td_method == TD_NONE || td_open_method(tc, td_method) != 0) return -1;
+    return 0;
+}
+
+static inline void topdown_start(topdown_counters_t *tc) {
+    if (tc->level == 0) return;
+    td_group_start(&tc->groups[0]);
+    td_group_start(&tc->groups[1]);
+}
+
+static inline void topdown_stop(topdown_counters_t *tc) {
+    if (tc->level == 0) return;
+    td_group_stop(&tc->groups[0]);
+    td_group_stop(&tc->groups[1]);
+}
+
+static inline void topdown_close(topdown_counters_t *tc) {
+    if (tc->level == 0) return;
+    td_group_close(&tc->groups[0]);
+    td_group_close(&tc->groups[1]);
+}
+
+// 探测可用方法，在主线程调用一次
+static inline const char *topdown_init(void) {
+    unsigned eax, ebx, ecx, edx;
+    int intel = 0, amd = 0, family = 0, model = 0;
+
+    if (__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+        intel = ebx == 0x756e6547;  // "Genu"
+        amd = ebx == 0x68747541;    // "Auth"
+    }
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        family = (eax >> 8) & 0xf;
+        model = (eax >> 4) & 0xf;
+        if (family == 0xf) family += (eax >> 20) & 0xff;
+        if (family >= 6) model |= (eax >> 12) & 0xf0;
+    }
+
+    td_method_t candidates[3];
+    int n = 0;
+    if (intel && td_sysfs_event_exists("topdown-retiring")) candidates[n++] = TD_INTEL_METRICS;
+    if (intel && family == 6) candidates[n++] = TD_INTEL_LEGACY;
+    // Zen 4: family 19h model 10h-1Fh、60h 之后；Zen 5: family 1Ah
+    if (amd && ((family == 0x19 && ((model >= 0x10 && model <= 0x1f) || model >= 0x60)) ||
+                family >= 0x1a)) {
+        candidates[n++] = TD_AMD_ZEN4;
+    }
+
+    td_method = TD_NONE;
+    for (int i = 0; i <= n; i++) {
+        td_method_t m = i < n ? candidates[i] : TD_GENERIC;
+        topdown_counters_t tc;
+        if (td_open_method(&tc, m) == 0) {
+            td_method = m;
+            topdown_close(&tc);
+            break;
+        }
+    }
+    return td_method_names[td_method];
+}
+
+static inline void td_result_clear(topdown_result_t *r) {
+    r->level = 0;
+    r->retiring = r->bad_spec = r->frontend = r->backend = -1;
+    r->smt_contention = -1;
+    r->fe_latency = r->fe_bandwidth = -1;
+    r->branch_mispredict = r->machine_clears = -1;
+    r->be_memory = r->be_core = -1;
+    r->retire_light = r->retire_heavy = -1;
+}
+
+// 由最近一次 stop 的读数计算槽位占比
+static inline void topdown_read(const topdown_counters_t *tc, topdown_result_t *r) {
+    const td_group_t *g = &tc->groups[0];
+    const uint64_t *v = g->values;
+
+    td_result_clear(r);
+    if (tc->level == 0 || !g->valid) return;
+
+    if (td_method == TD_INTEL_METRICS) {
+        double total = (double)v[1] + v[2] + v[3] + v[4];
+        if (total == 0) return;
+        r->retiring = v[1] / total;
+        r->bad_spec = v[2] / total;
+        r->frontend = v[3] / total;
+        r->backend = v[4] / total;
+        r->level = 1;
+        if (tc->level >= 2) {
+            r->retire_heavy = v[5] / total;
+            r->retire_light = r->retiring - r->retire_heavy;
+            r->branch_mispredict = v[6] / total;
+            r->machine_clears = r->bad_spec - r->branch_mispredict;
+            r->fe_latency = v[7] / total;
+            r->fe_bandwidth = r->frontend - r->fe_latency;
+            r->be_memory = v[8] / total;
+            r->be_core = r->backend - r->be_memory;
+            r->level = 2;
+        }
+    } else if (td_method == TD_INTEL_LEGACY) {
+        double slots = 4.0 * v[0];
+        if (slots == 0) return;
+        r->frontend = v[3] / slots;
+        r->bad_spec = ((double)v[1] - v[2] + 4.0 * v[4]) / slots;
+        r->retiring = v[2] / slots;
+        r->backend = 1.0 - r->frontend - r->bad_spec - r->retiring;
+        r->level = 1;
+    } else if (td_method == TD_AMD_ZEN4) {
+        double slots = 6.0 * v[0];
+        if (slots == 0) return;
+        r->frontend = v[1] / slots;
+        r->backend = v[2] / slots;
+        r->smt_contention = v[3] / slots;
+        r->bad_spec = ((double)v[4] - v[5]) / slots;
+        r->retiring = v[5] / slots;
+        r->level = 1;
+        const td_group_t *g2 = &tc->groups[1];
+        const uint64_t *w = g2->values;
+        if (tc->level >= 2 && g2->valid) {
+            r->fe_latency = 6.0 * w[0] / slots;
+            r->fe_bandwidth = r->frontend - r->fe_latency;
+            double flushes = (double)w[1] + w[2];
+            r->branch_mispredict = flushes > 0 ? r->bad_spec * w[1] / flushes : 0;
+            r->machine_clears = r->bad_spec - r->branch_mispredict;
+            r->be_memory = w[4] > 0 ? r->backend * w[3] / w[4] : 0;
+            r->be_core = r->backend - r->be_memory;
+            r->retire_heavy = w[5] / slots;
+            r->retire_light = r->retiring - r->retire_heavy;
+            r->level = 2;
+        }
+    } else if (td_method == TD_GENERIC) {
+        if (v[0] == 0) return;
+        r->frontend = (double)v[1] / v[0];
+        r->backend = (double)v[2] / v[0];
+        r->level = 1;
+    }
+}
+
+static inline void td_print_pct(double v) {
+    if (v < 0) {
+        printf(" %7s", "n/a");
+    } else {
+        printf(" %6.1f%%", v * 100);
+    }
+}
+
+static inline void topdown_print_header(const char *label) {
+    printf("%-24s %7s %7s %7s %7s %7s\n", label, "Retire", "BadSpec", "FEBound",
+           "BEBound", "SMT");
+}
+
+// 一行 level 1，若有 level 2 再输出一行细分
+static inline void topdown_print_row(const char *label, const topdown_result_t *r) {
+    printf("%-24s", label);
+    if (r->level == 0) {
+        printf(" top-down events not available\n");
+        return;
+    }
+    td_print_pct(r->retiring);
+    td_print_pct(r->bad_spec);
+    td_print_pct(r->frontend);
+    td_print_pct(r->backend);
+    td_print_pct(r->smt_contention);
+    printf("\n");
+
+    if (r->level >= 2) {
+        printf("%-24s  FE lat %.1f%% bw %.1f%% | mispred %.1f%% clears %.1f%% |"
+               " BE mem %.1f%% core %.1f%% | heavy %.1f%%\n", "",
+               r->fe_latency * 100, r->fe_bandwidth * 100, r->branch_mispredict * 100,
+               r->machine_clears * 100, r->be_memory * 100, r->be_core * 100,
+               r->retire_heavy * 100);
+    }
+}
+
+#endif // TOPDOWN_H
@@ -0,0 +1,332 @@
+#ifndef WORK_STEAL_H
+#define WORK_STEAL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "cpu_bindind.h"
+#include "prefetch_utils.h"
+
+// 工作窃取运行时：Chase-Lev 双端队列 + 拓扑感知的窃取顺序
+//
+// 每个工作线程绑定到一个 CPU，拥有一个定长 Chase-Lev 双端队列：
+// 所有者在 bottom 端 push / take（LIFO，刚产生的任务数据还在缓存中），
+// 窃取者在 top 端 steal（FIFO，拿走最老、通常也是最大的任务）。
+// 实现按 Lê et al. "Correct and Efficient Work-Stealing for Weak Memory
+// Models" (PPoPP 2013) 的 C11 版本，队列满时 ws_spawn 直接内联执行任务。
+//
+// 窃取策略：
+//   WS_STEAL_RANDOM    每次随机选一个受害者（经典做法）
+//   WS_STEAL_TOPOLOGY  按层次依次尝试：同核心超线程兄弟（共享 L1/L2）、
+//                      同一 L3、其它；层内从随机位置开始轮询
+// L3 归属读取 /sys/devices/system/cpu/cpuN/cache/index3/id，读不到时
+// 视为同一 L3；超线程兄弟按 cpu_bindind.h 的 HT_PAIRS 编号（cpu % NUM_CORES）。
+//
+// 任务是用户结构体中嵌入的 ws_task_t，fork-join 通过计数器实现：
+//   int pending = 2;
+//   a.task = (ws_task_t){fn_a, &pending}; ws_spawn(w, &a.task);
+//   b.task = ...; ws_spawn(w, &b.task);
+//   ws_sync(w, &pending);      // 等待期间执行本地任务或窃取
+// 任务在 fn 返回后才把计数器减一，之后运行时不再访问任务结构体，
+// 因此任务可以放在 ws_sync 调用方的栈上。
+//
+// 用法：
+//   ws_pool_t pool;
+//   ws_pool_init(&pool, nthreads, PLACE_SPREAD, WS_STEAL_TOPOLOGY, NULL, NULL);
+//   ws_pool_run(&pool, &root.task);   // 由 0 号工作线程执行，返回时已完成
+//   ws_pool_destroy(&pool);
+
+// 配置参数
+#define WS_DEQUE_SIZE 4096       // 2 的幂
+#define WS_MAX_WORKERS NUM_HW_THREADS
+#define WS_SPIN_LIMIT 64         // 空闲自旋次数，之后 sched_yield
+
+typedef struct ws_worker ws_worker_t;
+typedef struct ws_task ws_task_t;
+
+struct ws_task {
+    void (*fn)(ws_worker_t *w, ws_task_t *t);
+    int *join;                   // 完成后减一，可以为 NULL
+};
+
+typedef struct {
+    CACHE_PADDED(int64_t, top);     // 窃取端
+    CACHE_PADDED(int64_t, bottom);  // 所有者端
+    ws_task_t *buf[WS_DEQUE_SIZE];
+} ws_deque_t;
+
+typedef enum { WS_STEAL_RANDOM, WS_STEAL_TOPOLOGY } ws_policy_t;
+
+typedef enum { WS_TIER_SIBLING, WS_TIER_L3, WS_TIER_REMOTE, WS_NUM_TIERS } ws_tier_t;
+
+static const char *ws_tier_names[WS_NUM_TIERS] = {"sibling", "same-L3", "remote"};
+
+typedef struct ws_pool ws_pool_t;
+
+struct ws_worker {
+    ws_deque_t deque;
+    ws_pool_t *pool;
+    int id;
+    int cpu;
+    uint32_t rng;
+    int victims[WS_NUM_TIERS][WS_MAX_WORKERS];  // 按层分组的受害者
+    int num_victims[WS_NUM_TIERS];
+    uint64_t tasks_run;
+    uint64_t steals[WS_NUM_TIERS];              // 按受害者所在层统计成功窃取
+    uint64_t steal_attempts;
+    void *user;                                 // 供 worker_init / worker_exit 使用
+} CACHE_ALIGNED;
+
+struct ws_pool {
+    ws_worker_t *workers;
+    pthread_t threads[WS_MAX_WORKERS];
+    int num_workers;
+    ws_policy_t policy;
+    void (*worker_init)(ws_worker_t *w);        // 在工作线程中、绑核之后调用
+    void (*worker_exit)(ws_worker_t *w);        // 在工作线程退出前调用
+    int ready;
+    volatile int stop;
+    ws_task_t *root;
+    int pending;
+};
+
+// ---------------------------------------------------------------
+// Chase-Lev 双端队列
+// ---------------------------------------------------------------
+
+// 所有者：压入底部，队列满时返回 -1
+static inline int ws_deque_push(ws_deque_t *d, ws_task_t *t) {
+    int64_t b = __atomic_load_n(&d->bottom.value, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&d->top.value, __ATOMIC_ACQUIRE);
+    if (b - top >= WS_DEQUE_SIZE) return -1;
+    __atomic_store_n(&d->buf[b & (WS_DEQUE_SIZE - 1)], t, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&d->bottom.value, b + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// 所有者：从底部取出，空时返回 NULL
+static inline ws_task_t *ws_deque_take(ws_deque_t *d) {
+    int64_t b = __atomic_load_n(&d->bottom.value, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&d->bottom.value, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&d->top.value, __ATOMIC_RELAXED);
+    ws_task_t *t = NULL;
+
+    if (top <= b) {
+        t = __atomic_load_n(&d->buf[b & (WS_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+        if (top == b) {
+            // 最后一个元素：与窃取者竞争
+            if (!__atomic_compare_exchange_n(&d->top.value, &top, top + 1, 0,
+                                             __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                t = NULL;
+            }
+            __atomic_store_n(&d->bottom.value, b + 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        __atomic_store_n(&d->bottom.value, b + 1, __ATOMIC_RELAXED);
+    }
+    return t;
+}
+
+// 窃取者：从顶部取出，空或竞争失败时返回 NULL
+static inline ws_task_t *ws_deque_steal(ws_deque_t *d) {
+    int64_t top = __atomic_load_n(&d->top.value, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&d->bottom.value, __ATOMIC_ACQUIRE);
+
+    if (top >= b) return NULL;
+    ws_task_t *t = __atomic_load_n(&d->buf[top & (WS_DEQUE_SIZE - 1)], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&d->top.value, &top, top + 1, 0,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    return t;
+}
+
+// ---------------------------------------------------------------
+// 拓扑
+// ---------------------------------------------------------------
+
+static inline int ws_l3_id(int cpu) {
+    char path[96];
+    int id = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index3/id", cpu);
+    FILE *f = fopen(path, "r");
+    if (f) {
+        if (fscanf(f, "%d", &id) != 1) id = 0;
+        fclose(f);
+    }
+    return id;
+}
+
+static inline ws_tier_t ws_classify(int cpu_a, int cpu_b, int l3_a, int l3_b) {
+    if (cpu_a % NUM_CORES == cpu_b % NUM_CORES) return WS_TIER_SIBLING;
+    return l3_a == l3_b ? WS_TIER_L3 : WS_TIER_REMOTE;
+}
+
+// ---------------------------------------------------------------
+// 调度
+// ---------------------------------------------------------------
+
+static inline uint32_t ws_rand(ws_worker_t *w) {
+    uint32_t x = w->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return w->rng = x;
+}
+
+static inline void ws_idle(int *spins) {
+    if (++*spins < WS_SPIN_LIMIT) {
+        __builtin_ia32_pause();
+    } else {
+        sched_yield();
+    }
+}
+
+static inline ws_task_t *ws_try_steal(ws_worker_t *w) {
+    ws_worker_t *workers = w->pool->workers;
+
+    if (w->pool->policy == WS_STEAL_RANDOM) {
+        int total = w->pool->num_workers - 1;
+        for (int k = 0; k < total; k++) {
+            uint32_t r = ws_rand(w) % total;
+            int tier = 0;
+            while (r >= (uint32_t)w->num_victims[tier]) r -= w->num_victims[tier++];
+            w->steal_attempts++;
+            ws_task_t *t = ws_deque_steal(&workers[w->victims[tier][r]].deque);
+            if (t) {
+                w->steals[tier]++;
+                return t;
+            }
+        }
+        return NULL;
+    }
+
+    for (int tier = 0; tier < WS_NUM_TIERS; tier++) {
+        int n = w->num_victims[tier];
+        if (n == 0) continue;
+        int start = ws_rand(w) % n;
+        for (int k = 0; k < n; k++) {
+            w->steal_attempts++;
+            ws_task_t *t = ws_deque_steal(&workers[w->victims[tier][(start + k) % n]].deque);
+            if (t) {
+                w->steals[tier]++;
+                return t;
+            }
+        }
+    }
+    return NULL;
+}
+
+static inline void ws_run_task(ws_worker_t *w, ws_task_t *t) {
+    int *join = t->join;   // fn 返回后任务结构体可能已失效
+    t->fn(w, t);
+    w->tasks_run++;
+    if (join) __atomic_fetch_sub(join, 1, __ATOMIC_RELEASE);
+}
+
+static inline void ws_spawn(ws_worker_t *w, ws_task_t *t) {
+    if (ws_deque_push(&w->deque, t) != 0) ws_run_task(w, t);
+}
+
+// 等待 *join 归零；期间执行本地任务，本地为空时窃取
+static inline void ws_sync(ws_worker_t *w, int *join) {
+    int spins = 0;
+    while (__atomic_load_n(join, __ATOMIC_ACQUIRE) > 0) {
+        ws_task_t *t = ws_deque_take(&w->deque);
+        if (!t) t = ws_try_steal(w);
+        if (t) {
+            ws_run_task(w, t);
+            spins = 0;
+        } else {
+            ws_idle(&spins);
+        }
+    }
+}
+
+static void *ws_worker_main(void *arg) {
+    ws_worker_t *w = (ws_worker_t *)arg;
+    ws_pool_t *pool = w->pool;
+    int spins = 0;
+
+    bind_to_cpu(w->cpu);
+    if (pool->worker_init) pool->worker_init(w);
+    __atomic_fetch_add(&pool->ready, 1, __ATOMIC_SEQ_CST);
+
+    while (!pool->stop) {
+        ws_task_t *t = ws_deque_take(&w->deque);
+        if (!t) t = ws_try_steal(w);
+        if (!t && w->id == 0) t = __atomic_exchange_n(&pool->root, NULL, __ATOMIC_ACQUIRE);
+        if (t) {
+            ws_run_task(w, t);
+            spins = 0;
+        } else {
+            ws_idle(&spins);
+        }
+    }
+
+    if (pool->worker_exit) pool->worker_exit(w);
+    return NULL;
+}
+
+// 创建 num_workers 个工作线程，第 i 个绑定到 placement_cpu(i, placement)
+static inline int ws_pool_init(ws_pool_t *pool, int num_workers, placement_t placement,
+                               ws_policy_t policy, void (*worker_init)(ws_worker_t *),
+                               void (*worker_exit)(ws_worker_t *)) {
+    int l3[WS_MAX_WORKERS];
+
+    if (num_workers < 1 || num_workers > WS_MAX_WORKERS) return -1;
+    memset(pool, 0, sizeof(*pool));
+    pool->workers = aligned_alloc(CACHE_LINE_SIZE, num_workers * sizeof(ws_worker_t));
+    if (!pool->workers) return -1;
+    memset(pool->workers, 0, num_workers * sizeof(ws_worker_t));
+    pool->num_workers = num_workers;
+    pool->policy = policy;
+    pool->worker_init = worker_init;
+    pool->worker_exit = worker_exit;
+
+    for (int i = 0; i < num_workers; i++) {
+        ws_worker_t *w = &pool->workers[i];
+        w->pool = pool;
+        w->id = i;
+        w->cpu = placement_cpu(i, placement);
+        w->rng = 0x9E3779B9u * (i + 1);
+        l3[i] = ws_l3_id(w->cpu);
+    }
+    for (int i = 0; i < num_workers; i++) {
+        ws_worker_t *w = &pool->workers[i];
+        for (int j = 0; j < num_workers; j++) {
+            if (j == i) continue;
+            ws_tier_t tier = ws_classify(w->cpu, pool->workers[j].cpu, l3[i], l3[j]);
+            w->victims[tier][w->num_victims[tier]++] = j;
+        }
+    }
+
+    for (int i = 0; i < num_workers; i++) {
+        pthread_create(&pool->threads[i], NULL, ws_worker_main, &pool->workers[i]);
+    }
+    while (__atomic_load_n(&pool->ready, __ATOMIC_ACQUIRE) < num_workers) usleep(100);
+    return 0;
+}
+
+// 提交根任务并等待其（及其派生的所有任务）完成
+static inline void ws_pool_run(ws_pool_t *pool, ws_task_t *root) {
+    pool->pending = 1;
+    root->join = &pool->pending;
+    __atomic_store_n(&pool->root, root, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) > 0) {
+        usleep(50);
+    }
+}
+
+static inline void ws_pool_destroy(ws_pool_t *pool) {
+    pool->stop = 1;
+    for (int i = 0; i < pool->num_workers; i++) pthread_join(pool->threads[i], NULL);
+    free(pool->workers);
+    memset(pool, 0, sizeof(*pool));
+}
+
+#endif // WORK_STEAL_H
@@ -0,0 +1,433 @@
+/*
+ * port_contention.c - 执行端口竞争测试（超线程计算任务配对）
+ *
+ * latency_hiding.c 的 compute_intensive() 是 libm 的 sin/cos/sqrt/log/exp
+ * 调用链，受延迟限制且主要是库函数开销，看不出具体争用的是哪类执行资源。
+ * 本测试为每种执行资源提供独立的内核：
+ *   整数 ALU、FP 加、FP 乘、FMA、向量 shuffle、除法器、load 端口、store 端口
+ * 每种资源有两个变体：
+ *   - lat: 单条依赖链，受指令延迟限制，大部分端口空闲
+ *   - tput: 8 条独立链，尽量占满该资源的所有端口
+ * 然后在同一核心的两个超线程上两两配对运行，得到配对矩阵：
+ * 值 = A 配对吞吐/A 单独吞吐 + B 配对吞吐/B 单独吞吐
+ *   ~2.0 表示互不干扰（适合放在同一核心），~1.0 表示完全争用同一资源。
+ *
+ * 内核用内联汇编编写，避免编译器合并或消除运算。
+ *
+ * 编译: gcc -O2 -pthread -o port_contention port_contention.c
+ * 运行: ./port_contention [--solo | --matrix | --diff-core | --all]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define OPS_PER_ITER 8          // 每次循环迭代执行的指令数
+#define CHUNK_ITERS 10000       // 每次调用内核的迭代数
+#define SOLO_ITERS 2000000      // 单独运行的迭代数
+#define PAIR_DURATION_US 100000 // 配对运行时长（微秒）
+#define LOAD_ARRAY_SIZE 4096    // load/store 内核的数组大小（L1 内）
+
+static uint64_t load_array[LOAD_ARRAY_SIZE / sizeof(uint64_t)] CACHE_ALIGNED;
+
+// 每个线程独立的 store 目标，避免两个线程写同一缓存行
+static uint64_t store_array[2][LOAD_ARRAY_SIZE / sizeof(uint64_t)] CACHE_ALIGNED;
+
+#define REPEAT8(s) s s s s s s s s
+
+// ---------------------------------------------------------------
+// 整数 ALU
+// ---------------------------------------------------------------
+
+static uint64_t k_int_lat(long iters, int tid) {
+    (void)tid;
+    uint64_t a = 1, b = 3;
+    for (long i = 0; i < iters; i++) {
+        __asm__ __volatile__(REPEAT8("add %1, %0\n\t") : "+r"(a) : "r"(b));
+    }
+    return a;
+}
+
+static uint64_t k_int_tput(long iters, int tid) {
+    (void)tid;
+    uint64_t a0 = 0, a1 = 1, a2 = 2, a3 = 3, a4 = 4, a5 = 5, a6 = 6, a7 = 7, b = 3;
+    for (long i = 0; i < iters; i++) {
+        __asm__ __volatile__(
+            "add %8, %0\n\t" "add %8, %1\n\t" "add %8, %2\n\t" "add %8, %3\n\t"
+            "add %8, %4\n\t" "add %8, %5\n\t" "add %8, %6\n\t" "add %8, %7\n\t"
+            : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3),
+              "+r"(a4), "+r"(a5), "+r"(a6), "+r"(a7)
+            : "r"(b));
+    }
+    return a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7;
+}
+
+// ---------------------------------------------------------------
+// 向量/浮点：同一模板，只是指令不同
+// ---------------------------------------------------------------
+
+#define DEFINE_VEC_LAT(name, insn, init, operand) \
+static uint64_t k_##name##_lat(long iters, int tid) { \
+    (void)tid; \
+    __m128d a = _mm_set1_pd(init), b = _mm_set1_pd(operand); \
+    for (long i = 0; i < iters; i++) { \
+        __asm__ __volatile__(REPEAT8(insn " %1, %0\n\t") : "+x"(a) : "x"(b)); \
+    } \
+    return (uint64_t)_mm_cvtsd_f64(a); \
+}
+
+#define DEFINE_VEC_TPUT(name, insn, init, operand) \
+static uint64_t k_##name##_tput(long iters, int tid) { \
+    (void)tid; \
+    __m128d a0 = _mm_set1_pd(init), a1 = a0, a2 = a0, a3 = a0; \
+    __m128d a4 = a0, a5 = a0, a6 = a0, a7 = a0, b = _mm_set1_pd(operand); \
+    for (long i = 0; i < iters; i++) { \
+        __asm__ __volatile__( \
+            insn " %8, %0\n\t" insn " %8, %1\n\t" insn " %8, %2\n\t" insn " %8, %3\n\t" \
+            insn " %8, %4\n\t" insn " %8, %5\n\t" insn " %8, %6\n\t" insn " %8, %7\n\t" \
+            : "+x"(a0), "+x"(a1), "+x"(a2), "+x"(a3), \
+              "+x"(a4), "+x"(a5), "+x"(a6), "+x"(a7) \
+            : "x"(b)); \
+    } \
+    a0 = _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3)); \
+    a4 = _mm_add_pd(_mm_add_pd(a4, a5), _mm_add_pd(a6, a7)); \
+    return (uint64_t)_mm_cvtsd_f64(_mm_add_pd(a0, a4)); \
+}
+
+#define DEFINE_VEC(name, insn, init, operand) \
+    DEFINE_VEC_LAT(name, insn, init, operand) \
+    DEFINE_VEC_TPUT(name, insn, init, operand)
+
+// 操作数选择保证数值不会溢出或变成非规格化数
+DEFINE_VEC(fadd, "addpd", 1.0, 1e-9)
+DEFINE_VEC(fmul, "mulpd", 1.0, 1.0000001)
+DEFINE_VEC(shuf, "pshufb", 1.0, 0.0)           // 整数 shuffle 端口
+DEFINE_VEC(div, "divpd", 1.0, 1.0000001)
+
+// FMA 需要三操作数形式：a += b * b
+static uint64_t k_fma_lat(long iters, int tid) {
+    (void)tid;
+    __m128d a = _mm_set1_pd(1.0), b = _mm_set1_pd(0.5);
+    for (long i = 0; i < iters; i++) {
+        __asm__ __volatile__(REPEAT8("vfmadd231pd %1, %1, %0\n\t") : "+x"(a) : "x"(b));
+    }
+    return (uint64_t)_mm_cvtsd_f64(a);
+}
+
+static uint64_t k_fma_tput(long iters, int tid) {
+    (void)tid;
+    __m128d a0 = _mm_set1_pd(1.0), a1 = a0, a2 = a0, a3 = a0;
+    __m128d a4 = a0, a5 = a0, a6 = a0, a7 = a0, b = _mm_set1_pd(0.5);
+    for (long i = 0; i < iters; i++) {
+        __asm__ __volatile__(
+            "vfmadd231pd %8, %8, %0\n\t" "vfmadd231pd %8, %8, %1\n\t"
+            "vfmadd231pd %8, %8, %2\n\t" "vfmadd231pd %8, %8, %3\n\t"
+            "vfmadd231pd %8, %8, %4\n\t" "vfmadd231pd %8, %8, %5\n\t"
+            "vfmadd231pd %8, %8, %6\n\t" "vfmadd231pd %8, %8, %7\n\t"
+            : "+x"(a0), "+x"(a1), "+x"(a2), "+x"(a3),
+              "+x"(a4), "+x"(a5), "+x"(a6), "+x"(a7)
+            : "x"(b));
+    }
+    a0 = _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3));
+    a4 = _mm_add_pd(_mm_add_pd(a4, a5), _mm_add_pd(a6, a7));
+    return (uint64_t)_mm_cvtsd_f64(_mm_add_pd(a0, a4));
+}
+
+// ---------------------------------------------------------------
+// load / store 端口
+// ---------------------------------------------------------------
+
+// 指针追逐：L1 load-to-use 延迟
+static uint64_t k_load_lat(long iters, int tid) {
+    (void)tid;
+    uint64_t *p = &load_array[0];
+    for (long i = 0; i < iters; i++) {
+        __asm__ __volatile__(REPEAT8("mov (%0), %0\n\t") : "+r"(p));
+    }
+    return (uint64_t)p;
+}
+
+static uint64_t k_load_tput(long iters, int tid) {
+    (void)tid;
+    uint64_t r0 = 0, r1 = 0, r2 = 0, r3 = 0, r4 = 0, r5 = 0, r6 = 0, r7 = 0, sum = 0;
+    const uint64_t *base = load_array;
+    for (long i = 0; i < iters; i++) {
+        __asm__ __volatile__(
+            "mov 0(%8), %0\n\t" "mov 64(%8), %1\n\t" "mov 128(%8), %2\n\t" "mov 192(%8), %3\n\t"
+            "mov 256(%8), %4\n\t" "mov 320(%8), %5\n\t" "mov 384(%8), %6\n\t" "mov 448(%8), %7\n\t"
+            : "=r"(r0), "=r"(r1), "=r"(r2), "=r"(r3),
+              "=r"(r4), "=r"(r5), "=r"(r6), "=r"(r7)
+            : "r"(base) : "memory");
+        sum += r0 ^ r7;
+    }
+    return sum + r1 + r2 + r3 + r4 + r5 + r6;
+}
+
+// 存储转发链：store 后立即 load 同一地址
+static uint64_t k_store_lat(long iters, int tid) {
+    uint64_t v = 1;
+    uint64_t *p = store_array[tid];
+    for (long i = 0; i < iters; i++) {
+        __asm__ __volatile__(REPEAT8("mov %0, (%1)\n\tmov (%1), %0\n\t")
+                             : "+r"(v) : "r"(p) : "memory");
+    }
+    return v;
+}
+
+static uint64_t k_store_tput(long iters, int tid) {
+    uint64_t v = 1;
+    uint64_t *p = store_array[tid];
+    for (long i = 0; i < iters; i++) {
+        __asm__ __volatile__(
+            "mov %0, 0(%1)\n\t" "mov %0, 64(%1)\n\t" "mov %0, 128(%1)\n\t" "mov %0, 192(%1)\n\t"
+            "mov %0, 256(%1)\n\t" "mov %0, 320(%1)\n\t" "mov %0, 384(%1)\n\t" "mov %0, 448(%1)\n\t"
+            :: "r"(v), "r"(p) : "memory");
+    }
+    return v;
+}
+
+// ---------------------------------------------------------------
+// 内核表
+// ---------------------------------------------------------------
+
+typedef uint64_t (*kernel_fn)(long iters, int tid);
+
+typedef struct {
+    const char *name;
+    kernel_fn fn;
+    const char *feature;  // 运行时需要的 CPU 特性，NULL 表示基线 x86-64
+    double solo_ops;      // 单独运行吞吐 (G ops/s)
+    int supported;
+} kernel_t;
+
+static kernel_t kernels[] = {
+    {"int-lat",   k_int_lat,   NULL, 0, 0},
+    {"int-tput",  k_int_tput,  NULL, 0, 0},
+    {"fadd-lat",  k_fadd_lat,  NULL, 0, 0},
+    {"fadd-tput", k_fadd_tput, NULL, 0, 0},
+    {"fmul-lat",  k_fmul_lat,  NULL, 0, 0},
+    {"fmul-tput", k_fmul_tput, NULL, 0, 0},
+    {"fma-lat",   k_fma_lat,   "fma", 0, 0},
+    {"fma-tput",  k_fma_tput,  "fma", 0, 0},
+    {"shuf-lat",  k_shuf_lat,  "ssse3", 0, 0},
+    {"shuf-tput", k_shuf_tput, "ssse3", 0, 0},
+    {"div-lat",   k_div_lat,   NULL, 0, 0},
+    {"div-tput",  k_div_tput,  NULL, 0, 0},
+    {"load-lat",  k_load_lat,  NULL, 0, 0},
+    {"load-tput", k_load_tput, NULL, 0, 0},
+    {"store-lat", k_store_lat, NULL, 0, 0},
+    {"store-tput", k_store_tput, NULL, 0, 0},
+};
+#define NUM_KERNELS (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+static void detect_features(void) {
+    __builtin_cpu_init();
+    for (int i = 0; i < NUM_KERNELS; i++) {
+        const char *f = kernels[i].feature;
+        if (f == NULL) {
+            kernels[i].supported = 1;
+        } else if (strcmp(f, "fma") == 0) {
+            kernels[i].supported = __builtin_cpu_supports("fma");
+        } else if (strcmp(f, "ssse3") == 0) {
+            kernels[i].supported = __builtin_cpu_supports("ssse3");
+        }
+    }
+}
+
+static void init_load_chain(void) {
+    // 环形指针链：每个元素指向下一个缓存行
+    size_t n = LOAD_ARRAY_SIZE / sizeof(uint64_t);
+    for (size_t i = 0; i < n; i += 8) {
+        load_array[i] = (uint64_t)&load_array[(i + 8) % n];
+    }
+}
+
+// 单独运行每个内核
+static void run_solo(void) {
+    printf("\n=== Solo Kernel Throughput (CPU 0) ===\n");
+    printf("%-12s %10s %12s %10s\n", "Kernel", "Time(s)", "G ops/s", "ns/op");
+    printf("----------------------------------------------\n");
+
+    bind_to_cpu(0);
+
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        if (!kernels[k].supported) {
+            printf("%-12s %10s\n", kernels[k].name, "unsupported");
+            continue;
+        }
+        kernels[k].fn(SOLO_ITERS / 10, 0);  // 预热
+
+        double start = get_time_sec();
+        uint64_t result = kernels[k].fn(SOLO_ITERS, 0);
+        double elapsed = get_time_sec() - start;
+
+        double ops = (double)SOLO_ITERS * OPS_PER_ITER;
+        kernels[k].solo_ops = ops / elapsed / 1e9;
+        printf("%-12s %10.4f %12.3f %10.3f  (result=%lu)\n", kernels[k].name, elapsed,
+               kernels[k].solo_ops, elapsed / ops * 1e9, result % 1000);
+    }
+}
+
+// ---------------------------------------------------------------
+// 配对运行
+// ---------------------------------------------------------------
+
+typedef struct {
+    int cpu_id;
+    int thread_id;
+    int kernel;
+    volatile int *ready;
+    volatile int *start;
+    volatile int *stop;
+    double ops;
+    double elapsed_time;
+} thread_arg_t;
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+    kernel_fn fn = kernels[targ->kernel].fn;
+    long chunks = 0;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __asm__ __volatile__("pause" ::: "memory");
+    }
+
+    double start = get_time_sec();
+    while (*targ->stop == 0) {
+        fn(CHUNK_ITERS, targ->thread_id);
+        chunks++;
+    }
+    targ->elapsed_time = get_time_sec() - start;
+    targ->ops = (double)chunks * CHUNK_ITERS * OPS_PER_ITER;
+
+    return NULL;
+}
+
+// 返回配对后两个线程相对单独运行的吞吐之和
+static double run_pair(int cpu1, int cpu2, int ka, int kb) {
+    pthread_t threads[2];
+    thread_arg_t args[2];
+    volatile int ready = 0;
+    volatile int start = 0;
+    volatile int stop = 0;
+
+    args[0] = (thread_arg_t){
+        .cpu_id = cpu1, .thread_id = 0, .kernel = ka,
+        .ready = &ready, .start = &start, .stop = &stop
+    };
+    args[1] = (thread_arg_t){
+        .cpu_id = cpu2, .thread_id = 1, .kernel = kb,
+        .ready = &ready, .start = &start, .stop = &stop
+    };
+
+    pthread_create(&threads[0], NULL, worker_thread, &args[0]);
+    pthread_create(&threads[1], NULL, worker_thread, &args[1]);
+
+    while (ready < 2) usleep(100);
+    start = 1;
+    usleep(PAIR_DURATION_US);
+    stop = 1;
+
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    double a = args[0].ops / args[0].elapsed_time / 1e9 / kernels[ka].solo_ops;
+    double b = args[1].ops / args[1].elapsed_time / 1e9 / kernels[kb].solo_ops;
+    return a + b;
+}
+
+static void run_matrix(int cpu1, int cpu2, const char *desc) {
+    double best = 0, worst = 3;
+    int best_a = 0, best_b = 0, worst_a = 0, worst_b = 0;
+
+    printf("\n=== Pairing Matrix: %s ===\n", desc);
+    printf("Cell = pairA/soloA + pairB/soloB (2.0 = no interference)\n\n");
+
+    // 列用内核编号，行首给出编号和名称
+    printf("%-15s", "");
+    for (int b = 0; b < NUM_KERNELS; b++) {
+        if (kernels[b].supported) printf(" %5d", b);
+    }
+    printf("\n");
+
+    for (int a = 0; a < NUM_KERNELS; a++) {
+        if (!kernels[a].supported) continue;
+        printf("%2d %-12s", a, kernels[a].name);
+        for (int b = 0; b < NUM_KERNELS; b++) {
+            if (!kernels[b].supported) continue;
+            if (b < a) {
+                printf(" %5s", "");
+                continue;
+            }
+            double v = run_pair(cpu1, cpu2, a, b);
+            printf(" %5.2f", v);
+            fflush(stdout);
+            if (v > best) { best = v; best_a = a; best_b = b; }
+            if (v < worst) { worst = v; worst_a = a; worst_b = b; }
+        }
+        printf("\n");
+    }
+
+    printf("\nBest pair:  %s + %s (%.2f)\n", kernels[best_a].name, kernels[best_b].name, best);
+    printf("Worst pair: %s + %s (%.2f)\n", kernels[worst_a].name, kernels[worst_b].name, worst);
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--solo | --matrix | --diff-core | --all]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --solo       Solo throughput of every kernel\n");
+    printf("  --matrix     Pairing matrix on HT siblings (CPU 0,8)\n");
+    printf("  --diff-core  Pairing matrix on different cores (CPU 0,1), control\n");
+    printf("  --all        Run all tests\n");
+}
+
+int main(int argc, char *argv[]) {
+    detect_features();
+    init_load_chain();
+
+    printf("=== Execution Port Contention Test ===\n");
+    printf("Ops per iteration: %d, solo iterations: %d\n", OPS_PER_ITER, SOLO_ITERS);
+    printf("Pair duration: %d ms\n", PAIR_DURATION_US / 1000);
+
+    const char *mode = argc > 1 ? argv[1] : "--all";
+
+    if (strcmp(mode, "--solo") == 0) {
+        run_solo();
+    } else if (strcmp(mode, "--matrix") == 0) {
+        run_solo();
+        run_matrix(0, 8, "Same Core HT (CPU 0,8)");
+    } else if (strcmp(mode, "--diff-core") == 0) {
+        run_solo();
+        run_matrix(0, 1, "Different Cores (CPU 0,1)");
+    } else if (strcmp(mode, "--all") == 0) {
+        run_solo();
+        run_matrix(0, 8, "Same Core HT (CPU 0,8)");
+        run_matrix(0, 1, "Different Cores (CPU 0,1)");
+
+        printf("\n=== Analysis ===\n");
+        printf("- lat kernels leave most ports idle: they pair well with anything\n");
+        printf("- tput kernels on the same resource (diagonal) approach 1.0\n");
+        printf("- FP add/mul/FMA share the same FP pipes on most cores\n");
+        printf("- The divider is a single unpipelined unit: div-tput + div-* is worst\n");
+        printf("- Different cores should be ~2.0 everywhere (control)\n");
+        printf("\nSMT placement: pair threads whose dominant resources differ,\n");
+        printf("e.g. integer/branchy code with FP-heavy code, or any code with\n");
+        printf("a latency-bound (pointer chasing, long dependency chain) thread.\n");
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
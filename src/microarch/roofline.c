@@ -0,0 +1,608 @@
+/*
+ * roofline.c - 算术强度滑块内核与 Roofline 生成
+ *
+ * 仓库里只有纯访存内核和纯计算内核，本测试提供中间的连续过渡：
+ * 每装载 1 字节执行多少 FLOP（算术强度 0.01..100）可调，
+ * 工作集分别落在 L1 / L2 / L3 / DRAM，向量化并可多线程运行。
+ *
+ * 内核结构（以向量为单位，每组 period 个向量）：
+ *   - 前 period-1 个向量只装载并按位或（不计 FLOP）
+ *   - 最后一个向量参与 fmas 次 FMA（每次 2*lanes FLOP）
+ *   算术强度 = fmas / (4 * period) FLOP/byte，与向量宽度无关
+ *
+ * 输出实测 Roofline：峰值 GFLOPS 和各级带宽上限，并把仓库中已有
+ * 基准的内核（矩阵乘法各版本、顺序/随机流、latency_hiding 计算）
+ * 作为点放到图上。最后输出机器可读的 CSV。
+ *
+ * 点的算术强度按指令装载字节计算（L1 口径）；若 perf 计数器可用，
+ * 另外按 LLC 缺失 * 64 字节给出 DRAM 口径的强度。
+ *
+ * 编译: gcc -O2 -pthread -o roofline roofline.c -lm
+ * 运行: ./roofline [--sweep | --roofline | --points | --all] [--threads N] [--csv FILE]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <math.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+#include "../common/perf_counters.h"
+
+// 配置参数
+#define TARGET_BYTES (512ULL * 1024 * 1024)  // 每个配置至少装载的字节数
+#define MAX_THREADS NUM_HW_THREADS
+#define MAX_POINTS 64
+
+typedef struct {
+    const char *name;
+    size_t bytes;  // 每线程工作集
+    int shared;    // 共享级别：总工作集按线程数均分
+} level_t;
+
+static const level_t levels[] = {
+    {"L1",   16 * 1024,          0},
+    {"L2",   512 * 1024,         0},
+    {"L3",   8 * 1024 * 1024,    1},
+    {"DRAM", 256 * 1024 * 1024,  1},
+};
+#define NUM_LEVELS (int)(sizeof(levels) / sizeof(levels[0]))
+
+static const double intensities[] = {
+    0.01, 0.03, 0.1, 0.25, 0.5, 1, 2, 4, 8, 16, 32, 64, 100
+};
+#define NUM_INTENSITIES (int)(sizeof(intensities) / sizeof(intensities[0]))
+
+static int num_threads = 1;
+static int has_avx2_fma;
+
+// ---------------------------------------------------------------
+// 滑块内核
+// ---------------------------------------------------------------
+
+typedef struct {
+    int period;  // 每组向量数
+    int fmas;    // 每组 FMA 次数：1/2/4 或 8 的倍数
+} slider_t;
+
+static slider_t slider_for(double intensity) {
+    slider_t s;
+    double f = intensity * 4;  // period = 1 时每组 FMA 数
+    if (f >= 8) {
+        s.period = 1;
+        s.fmas = (int)(f / 8 + 0.5) * 8;
+    } else if (f >= 1) {
+        s.period = 1;
+        s.fmas = f >= 4 ? 4 : (f >= 2 ? 2 : 1);
+    } else {
+        s.fmas = 1;
+        s.period = (int)(1.0 / f + 0.5);
+    }
+    return s;
+}
+
+static double slider_intensity(slider_t s) {
+    return (double)s.fmas / (4.0 * s.period);
+}
+
+// 8 组展开，第 k 组的 FMA 从第 k 个累加器开始轮转，
+// 低强度时 8 条依赖链交错，高强度时每 8 次 FMA 占满所有累加器
+#define SLIDER_GROUP(k) { \
+    const VI *p = v + g + (k) * period; \
+    for (int j = 0; j < period - 1; j++) orsum |= p[j]; \
+    VD x = (VD)p[period - 1]; \
+    if (fmas < 8) { \
+        acc[(k) & 7] = acc[(k) & 7] * x + c; \
+        if (fmas > 1) acc[((k) + 1) & 7] = acc[((k) + 1) & 7] * x + c; \
+        if (fmas > 2) { \
+            acc[((k) + 2) & 7] = acc[((k) + 2) & 7] * x + c; \
+            acc[((k) + 3) & 7] = acc[((k) + 3) & 7] * x + c; \
+        } \
+    } else { \
+        for (int f = 0; f < fmas; f += 8) { \
+            acc[0] = acc[0] * x + c; acc[1] = acc[1] * x + c; \
+            acc[2] = acc[2] * x + c; acc[3] = acc[3] * x + c; \
+            acc[4] = acc[4] * x + c; acc[5] = acc[5] * x + c; \
+            acc[6] = acc[6] * x + c; acc[7] = acc[7] * x + c; \
+        } \
+    } \
+}
+
+#define DEFINE_SLIDER(name, ATTR, VD_T, VI_T) \
+ATTR static double name(const void *buf, size_t bytes, slider_t s, int passes) { \
+    typedef VD_T VD; \
+    typedef VI_T VI; \
+    const VI *v = (const VI *)buf; \
+    size_t nvec = bytes / sizeof(VI); \
+    size_t block = (size_t)s.period * 8; \
+    int period = s.period, fmas = s.fmas; \
+    VD acc[8]; \
+    VD c = (VD){0} + 1e-9; \
+    VI orsum = (VI){0}; \
+    for (int i = 0; i < 8; i++) acc[i] = (VD){0} + 1.0; \
+    for (int pass = 0; pass < passes; pass++) { \
+        for (size_t g = 0; g + block <= nvec; g += block) { \
+            SLIDER_GROUP(0) SLIDER_GROUP(1) SLIDER_GROUP(2) SLIDER_GROUP(3) \
+            SLIDER_GROUP(4) SLIDER_GROUP(5) SLIDER_GROUP(6) SLIDER_GROUP(7) \
+        } \
+    } \
+    VD total = acc[0] + acc[1] + acc[2] + acc[3] + acc[4] + acc[5] + acc[6] + acc[7]; \
+    return total[0] + (double)(orsum[0] & 1); \
+}
+
+typedef double v2d __attribute__((vector_size(16)));
+typedef long long v2i __attribute__((vector_size(16)));
+typedef double v4d __attribute__((vector_size(32)));
+typedef long long v4i __attribute__((vector_size(32)));
+
+DEFINE_SLIDER(slider_sse2, , v2d, v2i)
+DEFINE_SLIDER(slider_avx2, __attribute__((target("avx2,fma"))), v4d, v4i)
+
+// 一次完整运行实际装载的字节数和 FLOP 数
+static void slider_work(size_t bytes, slider_t s, int passes, double *loaded, double *flops) {
+    size_t vec_bytes = has_avx2_fma ? 32 : 16;
+    size_t block_bytes = (size_t)s.period * 8 * vec_bytes;
+    size_t blocks = bytes / block_bytes;
+    *loaded = (double)blocks * block_bytes * passes;
+    *flops = (double)blocks * 8 * s.fmas * (vec_bytes / 8) * 2 * passes;
+}
+
+// ---------------------------------------------------------------
+// 多线程运行
+// ---------------------------------------------------------------
+
+typedef struct {
+    int cpu_id;
+    size_t bytes;
+    slider_t slider;
+    int passes;
+    double *buffer;
+    volatile int *ready;
+    volatile int *start;
+    double result;
+    double elapsed_time;
+} thread_arg_t;
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+
+    bind_to_cpu(targ->cpu_id);
+
+    // 在本线程首次写入，保证页面分配在本地
+    for (size_t i = 0; i < targ->bytes / sizeof(double); i++) {
+        targ->buffer[i] = 1.0;
+    }
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __asm__ __volatile__("pause" ::: "memory");
+    }
+
+    double start = get_time_sec();
+    if (has_avx2_fma) {
+        targ->result = slider_avx2(targ->buffer, targ->bytes, targ->slider, targ->passes);
+    } else {
+        targ->result = slider_sse2(targ->buffer, targ->bytes, targ->slider, targ->passes);
+    }
+    targ->elapsed_time = get_time_sec() - start;
+
+    return NULL;
+}
+
+typedef struct {
+    double intensity;
+    double gflops;
+    double gbytes;  // GB/s
+} measurement_t;
+
+static measurement_t run_slider(const level_t *level, double intensity) {
+    pthread_t threads[MAX_THREADS];
+    thread_arg_t args[MAX_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+
+    size_t bytes = level->shared ? level->bytes / num_threads : level->bytes;
+    bytes &= ~(size_t)4095;
+    slider_t s = slider_for(intensity);
+    int passes = (int)(TARGET_BYTES / num_threads / bytes);
+    if (passes < 1) passes = 1;
+
+    for (int t = 0; t < num_threads; t++) {
+        double *buffer = aligned_alloc(CACHE_LINE_SIZE, bytes);
+        if (!buffer) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, PLACE_SPREAD), .bytes = bytes, .slider = s,
+            .passes = passes, .buffer = buffer, .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < num_threads) usleep(100);
+
+    double wall_start = get_time_sec();
+    start = 1;
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+        free(args[t].buffer);
+    }
+    double wall_elapsed = get_time_sec() - wall_start;
+
+    double loaded, flops;
+    slider_work(bytes, s, passes, &loaded, &flops);
+
+    return (measurement_t){
+        .intensity = slider_intensity(s),
+        .gflops = flops * num_threads / wall_elapsed / 1e9,
+        .gbytes = loaded * num_threads / wall_elapsed / 1e9,
+    };
+}
+
+// ---------------------------------------------------------------
+// Roofline 上限与扫描
+// ---------------------------------------------------------------
+
+static double peak_gflops;
+static double level_bw[NUM_LEVELS];
+
+typedef struct {
+    char name[48];
+    double intensity;       // L1 口径 FLOP/byte，INFINITY 表示无访存
+    double dram_intensity;  // DRAM 口径，< 0 表示不可用
+    double gflops;
+    const char *note;
+} point_t;
+
+static point_t points[MAX_POINTS];
+static int num_points;
+
+static measurement_t sweep[NUM_INTENSITIES][NUM_LEVELS];
+static int sweep_done;
+
+static void add_point(const char *name, double intensity, double dram_intensity,
+                      double gflops, const char *note) {
+    if (num_points >= MAX_POINTS) return;
+    point_t *p = &points[num_points++];
+    snprintf(p->name, sizeof(p->name), "%s", name);
+    p->intensity = intensity;
+    p->dram_intensity = dram_intensity;
+    p->gflops = gflops;
+    p->note = note;
+}
+
+static void measure_ceilings(void) {
+    printf("\n=== Roofline Ceilings (%d thread%s) ===\n", num_threads, num_threads > 1 ? "s" : "");
+
+    measurement_t peak = run_slider(&levels[0], 100);
+    peak_gflops = peak.gflops;
+    printf("Peak compute (L1, intensity %.0f): %.2f GFLOPS\n", peak.intensity, peak_gflops);
+
+    for (int l = 0; l < NUM_LEVELS; l++) {
+        measurement_t m = run_slider(&levels[l], 0.01);
+        level_bw[l] = m.gbytes;
+        printf("%-5s bandwidth (intensity %.3f): %.2f GB/s\n", levels[l].name, m.intensity, m.gbytes);
+    }
+
+    printf("\nRidge points (FLOP/byte where compute becomes the limit):\n");
+    for (int l = 0; l < NUM_LEVELS; l++) {
+        printf("  %-5s %.2f\n", levels[l].name, peak_gflops / level_bw[l]);
+    }
+}
+
+static void run_sweep(void) {
+    printf("\n=== Arithmetic Intensity Sweep (%d thread%s) ===\n",
+           num_threads, num_threads > 1 ? "s" : "");
+    printf("Cells: GFLOPS (GB/s)\n\n");
+
+    printf("%-10s", "FLOP/byte");
+    for (int l = 0; l < NUM_LEVELS; l++) printf(" %22s", levels[l].name);
+    printf("\n");
+    printf("--------------------------------------------------------------------------------------------------\n");
+
+    for (int i = 0; i < NUM_INTENSITIES; i++) {
+        double actual = slider_intensity(slider_for(intensities[i]));
+        printf("%-10.3f", actual);
+        for (int l = 0; l < NUM_LEVELS; l++) {
+            measurement_t m = run_slider(&levels[l], intensities[i]);
+            sweep[i][l] = m;
+            char cell[32];
+            snprintf(cell, sizeof(cell), "%.2f (%.1f)", m.gflops, m.gbytes);
+            printf(" %22s", cell);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    sweep_done = 1;
+}
+
+// ---------------------------------------------------------------
+// 已有基准作为点（单线程，与原程序相同的内核）
+// ---------------------------------------------------------------
+
+#define MM_N 512
+#define MM_BLOCK 64
+#define STREAM_SIZE (128 * 1024 * 1024)
+#define RANDOM_SIZE (64 * 1024 * 1024)
+#define RANDOM_COUNT 10000000
+#define COMPUTE_ITERATIONS 2000000
+
+// matrix_prefetch.c 的朴素版本
+static void mm_naive(const double *A, const double *B, double *C) {
+    for (int i = 0; i < MM_N; i++) {
+        for (int j = 0; j < MM_N; j++) {
+            double sum = 0;
+            for (int k = 0; k < MM_N; k++) {
+                sum += A[i * MM_N + k] * B[k * MM_N + j];
+            }
+            C[i * MM_N + j] = sum;
+        }
+    }
+}
+
+// matrix_prefetch.c 的分块版本
+static void mm_blocked(const double *A, const double *B, double *C) {
+    for (int ii = 0; ii < MM_N; ii += MM_BLOCK) {
+        for (int jj = 0; jj < MM_N; jj += MM_BLOCK) {
+            for (int kk = 0; kk < MM_N; kk += MM_BLOCK) {
+                for (int i = ii; i < ii + MM_BLOCK; i++) {
+                    for (int j = jj; j < jj + MM_BLOCK; j++) {
+                        double sum = C[i * MM_N + j];
+                        for (int k = kk; k < kk + MM_BLOCK; k++) {
+                            sum += A[i * MM_N + k] * B[k * MM_N + j];
+                        }
+                        C[i * MM_N + j] = sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 运行一个点：计时 + LLC 缺失（若可用）
+typedef double (*point_fn)(void *ctx);
+
+static void measure_point(const char *name, point_fn fn, void *ctx, double flops,
+                          double loaded_bytes, const char *note) {
+    perf_counter_t llc;
+    perf_counter_open(&llc, "LLC-miss", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+    perf_counter_start(&llc);
+    double start = get_time_sec();
+    double result = fn(ctx);
+    double elapsed = get_time_sec() - start;
+    perf_counter_stop(&llc);
+
+    double dram_intensity = -1;
+    if (perf_counter_valid(&llc) && llc.value > 0) {
+        dram_intensity = flops / (llc.value * (double)CACHE_LINE_SIZE);
+    }
+    perf_counter_close(&llc);
+
+    double intensity = loaded_bytes > 0 ? flops / loaded_bytes : INFINITY;
+    double gflops = flops / elapsed / 1e9;
+    add_point(name, intensity, dram_intensity, gflops, note);
+
+    char dram[32];
+    if (dram_intensity < 0) {
+        snprintf(dram, sizeof(dram), "n/a");
+    } else {
+        snprintf(dram, sizeof(dram), "%.3f", dram_intensity);
+    }
+    printf("%-26s %10.3f %10s %10.3f  (time %.3fs, result %.3g)\n", name, intensity,
+           dram, gflops, elapsed, result);
+}
+
+typedef struct {
+    double *A, *B, *C;
+    int blocked;
+} mm_ctx_t;
+
+static double point_matmul(void *ctx) {
+    mm_ctx_t *m = (mm_ctx_t *)ctx;
+    memset(m->C, 0, MM_N * MM_N * sizeof(double));
+    if (m->blocked) {
+        mm_blocked(m->A, m->B, m->C);
+    } else {
+        mm_naive(m->A, m->B, m->C);
+    }
+    return m->C[0];
+}
+
+// sequential_prefetch.c 的顺序求和（double 版本，每元素 1 FLOP）
+static double point_stream(void *ctx) {
+    const double *a = (const double *)ctx;
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t n = STREAM_SIZE / sizeof(double);
+    for (size_t i = 0; i < n; i += 4) {
+        s0 += a[i]; s1 += a[i + 1]; s2 += a[i + 2]; s3 += a[i + 3];
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+// random_prefetch.c 的随机访问（每次访问 1 FLOP）
+static double point_random(void *ctx) {
+    const double *a = (const double *)ctx;
+    size_t elements = RANDOM_SIZE / sizeof(double);
+    uint64_t seed = 12345;
+    double sum = 0;
+    for (size_t i = 0; i < RANDOM_COUNT; i++) {
+        seed = seed * 1103515245 + 12345;
+        sum += a[(seed >> 16) % elements];
+    }
+    return sum;
+}
+
+// latency_hiding.c 的 compute_intensive()
+static double point_compute(void *ctx) {
+    (void)ctx;
+    double result = 1.0;
+    for (long i = 0; i < COMPUTE_ITERATIONS; i++) {
+        result = sin(result) * cos(result) + sqrt(fabs(result) + 1.0);
+        result = log(fabs(result) + 1.0) * exp(-fabs(result) * 0.001);
+    }
+    return result;
+}
+
+static void run_points(void) {
+    printf("\n=== Existing Benchmarks as Roofline Points (1 thread) ===\n");
+    printf("%-26s %10s %10s %10s\n", "Kernel", "FLOP/B(L1)", "FLOP/B(DR)", "GFLOPS");
+    printf("------------------------------------------------------------\n");
+
+    bind_to_cpu(0);
+
+    mm_ctx_t mm;
+    size_t mm_bytes = MM_N * MM_N * sizeof(double);
+    mm.A = aligned_alloc(CACHE_LINE_SIZE, mm_bytes);
+    mm.B = aligned_alloc(CACHE_LINE_SIZE, mm_bytes);
+    mm.C = aligned_alloc(CACHE_LINE_SIZE, mm_bytes);
+    double *stream = aligned_alloc(CACHE_LINE_SIZE, STREAM_SIZE);
+    if (!mm.A || !mm.B || !mm.C || !stream) {
+        perror("Memory allocation failed");
+        return;
+    }
+    for (int i = 0; i < MM_N * MM_N; i++) {
+        mm.A[i] = 1.0 + (i % 100) * 0.01;
+        mm.B[i] = 2.0 + (i % 100) * 0.01;
+    }
+    for (size_t i = 0; i < STREAM_SIZE / sizeof(double); i++) stream[i] = 1.0;
+
+    // 矩阵乘法：内层每次迭代 2 FLOP，装载 A、B 各 8 字节
+    double mm_flops = 2.0 * MM_N * MM_N * MM_N;
+    double mm_loaded = 16.0 * MM_N * MM_N * MM_N;
+    mm.blocked = 0;
+    measure_point("matmul_naive", point_matmul, &mm, mm_flops, mm_loaded, NULL);
+    mm.blocked = 1;
+    measure_point("matmul_blocked", point_matmul, &mm, mm_flops, mm_loaded, NULL);
+
+    measure_point("sequential_stream", point_stream, stream,
+                  (double)STREAM_SIZE / sizeof(double), STREAM_SIZE, NULL);
+    measure_point("random_access", point_random, stream,
+                  RANDOM_COUNT, RANDOM_COUNT * sizeof(double), NULL);
+
+    // libm 调用无法精确计数，每次调用按 1 FLOP 计（下限）
+    measure_point("latency_hiding_compute", point_compute, NULL,
+                  COMPUTE_ITERATIONS * 15.0, 0, "libm calls counted as 1 flop");
+
+    free(mm.A);
+    free(mm.B);
+    free(mm.C);
+    free(stream);
+}
+
+// ---------------------------------------------------------------
+// 机器可读输出
+// ---------------------------------------------------------------
+
+static void write_csv(FILE *f) {
+    fprintf(f, "type,name,intensity_l1,intensity_dram,gflops,gbytes_per_sec,threads,note\n");
+    if (peak_gflops > 0) {
+        fprintf(f, "ceiling,peak_compute,,,%.4f,,%d,\n", peak_gflops, num_threads);
+        for (int l = 0; l < NUM_LEVELS; l++) {
+            fprintf(f, "ceiling,%s_bandwidth,,,,%.4f,%d,\n", levels[l].name, level_bw[l], num_threads);
+        }
+    }
+    if (sweep_done) {
+        for (int i = 0; i < NUM_INTENSITIES; i++) {
+            for (int l = 0; l < NUM_LEVELS; l++) {
+                measurement_t *m = &sweep[i][l];
+                fprintf(f, "slider,%s,%.6f,,%.4f,%.4f,%d,\n", levels[l].name, m->intensity,
+                        m->gflops, m->gbytes, num_threads);
+            }
+        }
+    }
+    for (int i = 0; i < num_points; i++) {
+        point_t *p = &points[i];
+        char dram[32] = "";
+        if (p->dram_intensity >= 0) snprintf(dram, sizeof(dram), "%.6f", p->dram_intensity);
+        if (isinf(p->intensity)) {
+            fprintf(f, "point,%s,inf,%s,%.4f,,1,%s\n", p->name, dram, p->gflops,
+                    p->note ? p->note : "");
+        } else {
+            fprintf(f, "point,%s,%.6f,%s,%.4f,,1,%s\n", p->name, p->intensity, dram,
+                    p->gflops, p->note ? p->note : "");
+        }
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--sweep | --roofline | --points | --all] [--threads N] [--csv FILE]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --sweep      GFLOPS vs arithmetic intensity for every cache level\n");
+    printf("  --roofline   Measure peak compute and per-level bandwidth ceilings\n");
+    printf("  --points     Place existing benchmark kernels on the roofline\n");
+    printf("  --all        Ceilings + sweep + points + CSV\n");
+    printf("  --threads N  Worker threads for sweep/ceilings (spread placement)\n");
+    printf("  --csv FILE   Also write CSV to FILE\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    const char *csv_path = NULL;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            num_threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            csv_path = argv[i + 1];
+        }
+    }
+    if (num_threads < 1 || num_threads > MAX_THREADS) {
+        fprintf(stderr, "Invalid thread count: %d\n", num_threads);
+        return 1;
+    }
+
+    __builtin_cpu_init();
+    has_avx2_fma = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+
+    printf("=== Arithmetic Intensity Slider and Roofline ===\n");
+    printf("Vector kernel: %s\n", has_avx2_fma ? "AVX2 + FMA (4 doubles)" : "SSE2 (2 doubles)");
+    printf("Threads: %d, placement: %s\n", num_threads, placement_name(PLACE_SPREAD));
+    printf("Working sets:");
+    for (int l = 0; l < NUM_LEVELS; l++) {
+        printf(" %s=%zuKB%s", levels[l].name, levels[l].bytes / 1024,
+               levels[l].shared ? "(total)" : "(per thread)");
+    }
+    printf("\n");
+
+    if (strcmp(mode, "--sweep") == 0) {
+        run_sweep();
+    } else if (strcmp(mode, "--roofline") == 0) {
+        measure_ceilings();
+    } else if (strcmp(mode, "--points") == 0) {
+        run_points();
+    } else if (strcmp(mode, "--all") == 0) {
+        measure_ceilings();
+        run_sweep();
+        run_points();
+
+        printf("\n=== Analysis ===\n");
+        printf("- Left of the ridge point a kernel is bandwidth-bound at that level\n");
+        printf("- Points far below both ceilings are latency-bound (random access)\n");
+        printf("  or dependency-bound (naive matmul, libm chain)\n");
+        printf("- Blocking raises DRAM-level intensity; L1-level intensity is unchanged\n");
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("\n--- CSV ---\n");
+    write_csv(stdout);
+    if (csv_path) {
+        FILE *f = fopen(csv_path, "w");
+        if (!f) {
+            perror("fopen csv");
+            return 1;
+        }
+        write_csv(f);
+        fclose(f);
+        printf("CSV saved to %s\n", csv_path);
+    }
+
+    return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * set_conflict.c - 缓存组冲突与 4K 混叠测试
+ *
+ * matrix_prefetch.c 中 N=1024 的 double 矩阵按列访问 B 时，
+ * 相邻元素相距 8KB，全部映射到 L1 的同一组。本测试量化这种冲突：
+ *
+ * 1. 组冲突：在 K 个相距 stride 字节的地址间做随机顺序的指针追逐，
+ *    stride 为 2 的幂或接近 2 的幂（±64B）。当 K 超过某级缓存的
+ *    相联度时延迟跳变，由此测出各级缓存的有效相联度。
+ * 2. 4K 混叠：dst[i] = src[i] + 1，dst = src + 4096*k + delta。
+ *    load src[i] 的低 12 位与 delta/4 次迭代前的 store dst[i - delta/4]
+ *    相同；delta 很小时该 store 尚未完成，load 被误判为存储转发依赖而停顿。
+ *
+ * 编译: gcc -O2 -o set_conflict set_conflict.c
+ * 运行: ./set_conflict [--assoc | --near-pow2 | --alias | --all]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define MAX_WAYS 64            // 最多同时冲突的地址数
+#define CHASE_STEPS 500000     // 每个配置的指针追逐步数
+#define JUMP_RATIO 1.4         // 延迟超过前一个平台 1.4 倍视为跳变
+#define ALIAS_ELEMENTS 1024    // 4KB float，src/dst 都在 L1 内
+#define ALIAS_REPEAT 20000
+#define PAGE_SIZE_4K 4096
+
+static char *region;
+static size_t region_size;
+
+// 在 K 个相距 stride 的地址上构造随机环形链表
+// 每个节点的第一个字存放下一节点地址
+static void **build_chain(size_t stride, int k) {
+    int order[MAX_WAYS];
+    uint64_t seed = 12345 + stride + k;
+
+    for (int i = 0; i < k; i++) order[i] = i;
+    for (int i = k - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        int j = (seed >> 16) % (i + 1);
+        int tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    for (int i = 0; i < k; i++) {
+        void **node = (void **)(region + (size_t)order[i] * stride);
+        *node = region + (size_t)order[(i + 1) % k] * stride;
+    }
+    return (void **)(region + (size_t)order[0] * stride);
+}
+
+// 依赖链：每次 load 的地址来自上一次 load，测得的是纯延迟
+static double chase_latency(size_t stride, int k) {
+    void **p = build_chain(stride, k);
+
+    // 预热：把所有节点装入缓存
+    for (int i = 0; i < k * 4; i++) p = (void **)*p;
+
+    double start = get_time_sec();
+    for (int i = 0; i < CHASE_STEPS; i++) {
+        p = (void **)*p;
+    }
+    double elapsed = get_time_sec() - start;
+
+    // 防止编译器消除循环
+    COMPILER_BARRIER();
+    if (p == NULL) printf("unreachable\n");
+
+    return elapsed / CHASE_STEPS * 1e9;
+}
+
+// 扫描的 K：1..24 逐个测试，之后按 8 递增
+static const int way_counts[] = {
+    1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+    17, 18, 19, 20, 21, 22, 23, 24, 32, 40, 48, 56, 64
+};
+#define NUM_WAY_COUNTS (int)(sizeof(way_counts) / sizeof(way_counts[0]))
+
+// 扫描 K，输出延迟曲线和跳变点
+static void sweep_ways(size_t stride) {
+    double lat[NUM_WAY_COUNTS];
+    int jumps[8];
+    int num_jumps = 0;
+    double plateau;
+
+    printf("\nStride %zu bytes (%s):\n", stride,
+           (stride & (stride - 1)) == 0 ? "power of two" : "near power of two");
+    printf("  K: ");
+    for (int i = 0; i < NUM_WAY_COUNTS; i++) {
+        lat[i] = chase_latency(stride, way_counts[i]);
+        printf("%d=%.1f ", way_counts[i], lat[i]);
+    }
+    printf("(ns)\n");
+
+    // 跳变需要持续（下一个 K 也超过阈值），过滤单点噪声
+    plateau = lat[0];
+    for (int i = 1; i < NUM_WAY_COUNTS && num_jumps < 8; i++) {
+        double threshold = plateau * JUMP_RATIO;
+        if (lat[i] > threshold && (i + 1 == NUM_WAY_COUNTS || lat[i + 1] > threshold)) {
+            jumps[num_jumps++] = way_counts[i - 1];
+            plateau = lat[i];
+        }
+    }
+
+    printf("  Latency jumps after K = ");
+    if (num_jumps == 0) printf("none (no conflict within %d ways)", MAX_WAYS);
+    for (int i = 0; i < num_jumps; i++) {
+        printf("%d%s", jumps[i], i + 1 < num_jumps ? ", " : "");
+    }
+    printf("\n");
+}
+
+// 2 的幂步长：每一级跳变点即该级缓存的有效相联度
+static void run_assoc_test(void) {
+    static const size_t strides[] = {
+        4096, 8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576
+    };
+    int n = sizeof(strides) / sizeof(strides[0]);
+
+    printf("\n=== Set Conflict: Power-of-Two Strides ===\n");
+    printf("Random-order pointer chase over K addresses, %d steps each\n", CHASE_STEPS);
+
+    for (int i = 0; i < n; i++) {
+        sweep_ways(strides[i]);
+    }
+}
+
+// 接近 2 的幂的步长：地址分散到不同组，冲突应消失
+static void run_near_pow2_test(void) {
+    static const size_t strides[] = {
+        4096 + 64, 8192 + 64, 8192 - 64, 65536 + 64, 1048576 + 64
+    };
+    int n = sizeof(strides) / sizeof(strides[0]);
+
+    printf("\n=== Set Conflict: Near Power-of-Two Strides (padding) ===\n");
+
+    for (int i = 0; i < n; i++) {
+        sweep_ways(strides[i]);
+    }
+}
+
+// dst[i] = src[i] + 1，返回每元素耗时 (ns)
+static double alias_copy(float *dst, const float *src) {
+    double start = get_time_sec();
+    for (int r = 0; r < ALIAS_REPEAT; r++) {
+        for (int i = 0; i < ALIAS_ELEMENTS; i++) {
+            dst[i] = src[i] + 1.0f;
+        }
+        COMPILER_BARRIER();
+    }
+    double elapsed = get_time_sec() - start;
+    return elapsed / ((double)ALIAS_REPEAT * ALIAS_ELEMENTS) * 1e9;
+}
+
+static void run_alias_test(void) {
+    static const int deltas[] = {
+        0, 4, 8, 16, 32, 48, 64, 128, 256, 512, 1024, 2048
+    };
+    int n = sizeof(deltas) / sizeof(deltas[0]);
+    // src 在前，dst = src + 4096*pages + delta（跨页，低 12 位仅差 delta），
+    // 使较早迭代的 store 与后面的 load 低 12 位相同
+    static const int page_gaps[] = {1, 4};
+
+    printf("\n=== 4K Aliasing: dst[i] = src[i] + 1 ===\n");
+    printf("dst = src + pages*4096 + delta, %d floats, %d repeats\n",
+           ALIAS_ELEMENTS, ALIAS_REPEAT);
+    printf("%-10s", "Delta(B)");
+    for (size_t g = 0; g < sizeof(page_gaps) / sizeof(page_gaps[0]); g++) {
+        char col[32];
+        snprintf(col, sizeof(col), "+%dpage ns/elem", page_gaps[g]);
+        printf(" %-16s", col);
+    }
+    printf("\n");
+    printf("--------------------------------------------\n");
+
+    for (int i = 0; i < n; i++) {
+        printf("%-10d", deltas[i]);
+        for (size_t g = 0; g < sizeof(page_gaps) / sizeof(page_gaps[0]); g++) {
+            float *src = (float *)region;
+            float *dst = (float *)(region + page_gaps[g] * PAGE_SIZE_4K + deltas[i]);
+            alias_copy(dst, src);  // 预热
+            printf(" %-16.3f", alias_copy(dst, src));
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    // 最大步长 * 最大冲突数
+    region_size = (size_t)(1048576 + 64) * MAX_WAYS + PAGE_SIZE_4K;
+    region = aligned_alloc(PAGE_SIZE_4K, region_size);
+    if (!region) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+    memset(region, 0, region_size);
+
+    bind_to_cpu(0);
+
+    printf("=== Cache Set Conflict and 4K Aliasing Test ===\n");
+    printf("L1 D-Cache: 32 KB, 8-way -> addresses 4KB apart share a set\n");
+    printf("L2 Cache: 1 MB, 8-way -> addresses 128KB apart share a set\n");
+    printf("Max conflicting addresses: %d\n", MAX_WAYS);
+
+    const char *mode = argc > 1 ? argv[1] : "--all";
+
+    if (strcmp(mode, "--assoc") == 0) {
+        run_assoc_test();
+    } else if (strcmp(mode, "--near-pow2") == 0) {
+        run_near_pow2_test();
+    } else if (strcmp(mode, "--alias") == 0) {
+        run_alias_test();
+    } else if (strcmp(mode, "--all") == 0) {
+        run_assoc_test();
+        run_near_pow2_test();
+        run_alias_test();
+
+        printf("\n=== Analysis ===\n");
+        printf("Set conflict:\n");
+        printf("- For stride 4KB the first jump is the L1 associativity\n");
+        printf("- Strides that are multiples of the L2 set period (128KB) also\n");
+        printf("  show the L2 associativity as a second jump\n");
+        printf("- Near-power-of-two strides spread lines over sets: no early jump\n");
+        printf("4K aliasing:\n");
+        printf("- Small non-zero delta is slowest: each load matches the low 12 bits\n");
+        printf("  of a store delta/4 iterations earlier that is still in flight\n");
+        printf("- delta = 0 aliases only the store of the same iteration (issued\n");
+        printf("  after the load), and large delta leaves the store time to retire\n");
+        printf("\nPadding rules:\n");
+        printf("- Row pitch of 2D arrays should not be a multiple of 4KB;\n");
+        printf("  add one cache line (e.g. N=1024 doubles -> pitch 1032)\n");
+        printf("- Offset paired src/dst buffers by a few cache lines modulo 4KB\n");
+    } else {
+        printf("Usage: %s [--assoc | --near-pow2 | --alias | --all]\n", argv[0]);
+        free(region);
+        return 1;
+    }
+
+    free(region);
+    return 0;
+}
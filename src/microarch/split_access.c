@@ -0,0 +1,516 @@
+/*
+ * split_access.c - 跨缓存行/跨页非对齐访问代价测试
+ *
+ * 仓库中的缓冲区都用 CACHE_ALIGNED / aligned_alloc(64) 对齐，
+ * 但打包的线上协议结构体经常跨越缓存行甚至页边界。本测试在缓存行内
+ * 每一个字节偏移上测量 4/8 字节标量和 16/32/64 字节 SIMD 访问的：
+ * - load 吞吐（独立访问）
+ * - load 延迟（下一次地址依赖本次读到的值）
+ * - store 吞吐
+ * - 原子 RMW 吞吐（lock xadd，4/8 字节）
+ * 另外测试跨 4KB 页的访问，以及超线程兄弟线程同时做同样访问时的代价。
+ *
+ * 所有数据都在 L1 内，测得的差异只来自对齐本身。
+ *
+ * 编译: gcc -O2 -pthread -o split_access split_access.c
+ * 运行: ./split_access [--load | --latency | --store | --atomic | --page | --smt | --all]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define PAGE_SIZE_4K 4096
+#define NUM_LINES 256           // 16KB，L1 内
+#define NUM_PAGES 8             // 跨页测试使用的页数
+#define TOTAL_ACCESSES 2000000  // 每个配置的访问次数
+// 跨行原子操作会触发 split lock，内核可能对每次发生做限速，
+// 因此只做少量操作
+#define ATOMIC_ACCESSES 200000
+#define ATOMIC_SPLIT_ACCESSES 200
+
+static const int access_sizes[] = {4, 8, 16, 32, 64};
+#define NUM_SIZES (int)(sizeof(access_sizes) / sizeof(access_sizes[0]))
+
+typedef enum {
+    OP_LOAD,
+    OP_LATENCY,
+    OP_STORE,
+    OP_ATOMIC
+} op_t;
+
+static const char *op_names[] = {
+    "Load throughput", "Load latency", "Store throughput", "Atomic RMW throughput"
+};
+
+static char *buffer1;
+static char *buffer2;
+static int has_avx2;
+static int has_avx512;
+
+// ---------------------------------------------------------------
+// 各宽度的访问原语
+// ---------------------------------------------------------------
+
+static inline uint64_t load4(const char *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline uint64_t load8(const char *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline void store4(char *p, uint64_t v) { uint32_t x = (uint32_t)v; memcpy(p, &x, 4); }
+static inline void store8(char *p, uint64_t v) { memcpy(p, &v, 8); }
+
+// SIMD load 只返回 lane 0，用内联汇编做完整宽度的 load，
+// 否则编译器会把它缩窄成只读前 4 字节的标量 load
+static inline uint64_t load16(const char *p) {
+    __m128i v;
+    __asm__ volatile("movdqu %1, %0" : "=x"(v) : "m"(*(const __m128i_u *)p));
+    return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+static inline void store16(char *p, uint64_t v) {
+    _mm_storeu_si128((__m128i *)p, _mm_set1_epi32((int)v));
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t load32(const char *p) {
+    __m256i v;
+    __asm__ volatile("vmovdqu %1, %0" : "=x"(v) : "m"(*(const __m256i_u *)p));
+    return (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(v));
+}
+
+__attribute__((target("avx2")))
+static inline void store32(char *p, uint64_t v) {
+    _mm256_storeu_si256((__m256i *)p, _mm256_set1_epi32((int)v));
+}
+
+__attribute__((target("avx512f")))
+static inline uint64_t load64(const char *p) {
+    __m512i v;
+    __asm__ volatile("vmovdqu64 %1, %0" : "=v"(v) : "m"(*(const __m512i_u *)p));
+    return (uint32_t)_mm_cvtsi128_si32(_mm512_castsi512_si128(v));
+}
+
+__attribute__((target("avx512f")))
+static inline void store64(char *p, uint64_t v) {
+    _mm512_storeu_si512((void *)p, _mm512_set1_epi32((int)v));
+}
+
+// 吞吐：4 个独立累加器，访问之间没有依赖
+#define DEFINE_LOAD_TPUT(W, ATTR) \
+ATTR static uint64_t load_tput_##W(const char *p, size_t stride, int n, long reps) { \
+    uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0; \
+    for (long r = 0; r < reps; r++) { \
+        for (int i = 0; i < n; i += 4) { \
+            a0 += load##W(p + (i + 0) * stride); \
+            a1 += load##W(p + (i + 1) * stride); \
+            a2 += load##W(p + (i + 2) * stride); \
+            a3 += load##W(p + (i + 3) * stride); \
+        } \
+        COMPILER_BARRIER(); \
+    } \
+    return a0 + a1 + a2 + a3; \
+}
+
+// 延迟：读到的值就是下一个节点的下标
+#define DEFINE_LOAD_LAT(W, ATTR) \
+ATTR static uint64_t load_lat_##W(const char *p, size_t stride, int n, long reps) { \
+    uint64_t idx = 0; \
+    long steps = reps * n; \
+    for (long s = 0; s < steps; s++) { \
+        idx = load##W(p + idx * stride); \
+    } \
+    return idx; \
+}
+
+#define DEFINE_STORE_TPUT(W, ATTR) \
+ATTR static uint64_t store_tput_##W(const char *p, size_t stride, int n, long reps) { \
+    char *q = (char *)p; \
+    for (long r = 0; r < reps; r++) { \
+        for (int i = 0; i < n; i++) { \
+            store##W(q + i * stride, (uint64_t)r); \
+        } \
+        COMPILER_BARRIER(); \
+    } \
+    return 0; \
+}
+
+#define DEFINE_KERNELS(W, ATTR) \
+    DEFINE_LOAD_TPUT(W, ATTR) \
+    DEFINE_LOAD_LAT(W, ATTR) \
+    DEFINE_STORE_TPUT(W, ATTR)
+
+DEFINE_KERNELS(4, )
+DEFINE_KERNELS(8, )
+DEFINE_KERNELS(16, )
+DEFINE_KERNELS(32, __attribute__((target("avx2"))))
+DEFINE_KERNELS(64, __attribute__((target("avx512f"))))
+
+static uint64_t atomic_tput_4(const char *p, size_t stride, int n, long reps) {
+    for (long r = 0; r < reps; r++) {
+        for (int i = 0; i < n; i++) {
+            __atomic_fetch_add((uint32_t *)(p + i * stride), 1, __ATOMIC_SEQ_CST);
+        }
+    }
+    return 0;
+}
+
+static uint64_t atomic_tput_8(const char *p, size_t stride, int n, long reps) {
+    for (long r = 0; r < reps; r++) {
+        for (int i = 0; i < n; i++) {
+            __atomic_fetch_add((uint64_t *)(p + i * stride), 1, __ATOMIC_SEQ_CST);
+        }
+    }
+    return 0;
+}
+
+typedef uint64_t (*kernel_fn)(const char *, size_t, int, long);
+
+static kernel_fn pick_kernel(op_t op, int size) {
+    static const kernel_fn table[3][NUM_SIZES] = {
+        {load_tput_4, load_tput_8, load_tput_16, load_tput_32, load_tput_64},
+        {load_lat_4, load_lat_8, load_lat_16, load_lat_32, load_lat_64},
+        {store_tput_4, store_tput_8, store_tput_16, store_tput_32, store_tput_64},
+    };
+    int s;
+    for (s = 0; s < NUM_SIZES; s++) {
+        if (access_sizes[s] == size) break;
+    }
+    if (s == NUM_SIZES) return NULL;
+    if (size == 32 && !has_avx2) return NULL;
+    if (size == 64 && !has_avx512) return NULL;
+
+    if (op == OP_ATOMIC) {
+        if (size == 4) return atomic_tput_4;
+        if (size == 8) return atomic_tput_8;
+        return NULL;
+    }
+    return table[op][s];
+}
+
+// ---------------------------------------------------------------
+// 测量
+// ---------------------------------------------------------------
+
+// 访问布局：第 i 次访问地址为 base + start + i * stride
+typedef struct {
+    size_t start;
+    size_t stride;
+    int n;
+} layout_t;
+
+static layout_t line_layout(int offset) {
+    return (layout_t){ .start = offset, .stride = CACHE_LINE_SIZE, .n = NUM_LINES };
+}
+
+// 访问正好跨越页边界，前后各一半
+static layout_t page_layout(int size) {
+    return (layout_t){
+        .start = PAGE_SIZE_4K - size / 2, .stride = PAGE_SIZE_4K, .n = NUM_PAGES
+    };
+}
+
+static int is_split(const layout_t *l, int size) {
+    return (l->start % CACHE_LINE_SIZE) + size > CACHE_LINE_SIZE;
+}
+
+// 为延迟测试在每个访问位置写入下一个节点的下标（环形）
+static void prepare_chain(char *base, const layout_t *l, int size) {
+    for (int i = 0; i < l->n; i++) {
+        char *p = base + l->start + i * l->stride;
+        memset(p, 0, size);
+        store4(p, (uint64_t)((i + 1) % l->n));
+    }
+}
+
+// 按访问次数安排 (位置数 n, 轮数 reps)：访问次数少于布局的位置数时
+// （跨行原子操作）只用前 total 个位置，保证总访问次数符合配置
+static long plan_accesses(op_t op, int size, const layout_t *l, int *n) {
+    long total = TOTAL_ACCESSES;
+    if (op == OP_ATOMIC) {
+        total = is_split(l, size) ? ATOMIC_SPLIT_ACCESSES : ATOMIC_ACCESSES;
+    }
+    *n = total < l->n ? (int)total : l->n;
+    return total / *n;
+}
+
+// 返回 ns/access，不支持的组合返回负数
+static double measure(op_t op, int size, char *base, const layout_t *l) {
+    kernel_fn fn = pick_kernel(op, size);
+    if (!fn) return -1;
+
+    int n;
+    long reps = plan_accesses(op, size, l, &n);
+
+    if (op == OP_LATENCY) prepare_chain(base, l, size);
+
+    const char *p = base + l->start;
+    fn(p, l->stride, n, reps > 8 ? reps / 8 : 1);  // 预热
+
+    double start = get_time_sec();
+    uint64_t result = fn(p, l->stride, n, reps);
+    double elapsed = get_time_sec() - start;
+
+    COMPILER_BARRIER();
+    if (result == UINT64_MAX) printf("unreachable\n");
+
+    return elapsed / ((double)reps * n) * 1e9;
+}
+
+static void print_cell(double ns) {
+    if (ns < 0) {
+        printf(" %8s", "-");
+    } else if (ns >= 1000) {
+        printf(" %7.0fu", ns / 1000);  // 微秒级（split lock）
+    } else {
+        printf(" %8.3f", ns);
+    }
+}
+
+static void print_size_header(const char *first) {
+    printf("%-10s", first);
+    for (int s = 0; s < NUM_SIZES; s++) {
+        char col[16];
+        snprintf(col, sizeof(col), "%dB", access_sizes[s]);
+        printf(" %8s", col);
+    }
+    printf("   (ns/access)\n");
+    printf("-------------------------------------------------------------\n");
+}
+
+// 缓存行内每个字节偏移
+static void run_offset_table(op_t op) {
+    printf("\n=== %s vs Offset in Line ===\n", op_names[op]);
+    print_size_header("Offset");
+
+    double aligned[NUM_SIZES];
+    for (int off = 0; off < CACHE_LINE_SIZE; off++) {
+        printf("%-10d", off);
+        for (int s = 0; s < NUM_SIZES; s++) {
+            layout_t l = line_layout(off);
+            double ns = measure(op, access_sizes[s], buffer1, &l);
+            if (off == 0) aligned[s] = ns;
+            print_cell(ns);
+        }
+        printf("\n");
+    }
+
+    // 汇总：跨行访问相对对齐访问的平均代价
+    printf("%-10s", "split/al");
+    for (int s = 0; s < NUM_SIZES; s++) {
+        double sum = 0;
+        int cnt = 0;
+        for (int off = CACHE_LINE_SIZE - access_sizes[s] + 1;
+             off < CACHE_LINE_SIZE && aligned[s] > 0; off++) {
+            layout_t l = line_layout(off);
+            sum += measure(op, access_sizes[s], buffer1, &l);
+            cnt++;
+        }
+        if (cnt == 0) {
+            printf(" %8s", "-");
+        } else {
+            printf(" %7.2fx", sum / cnt / aligned[s]);
+        }
+    }
+    printf("\n");
+}
+
+// 跨页 vs 跨行 vs 对齐
+static void run_page_table(void) {
+    printf("\n=== Page-Crossing Splits ===\n");
+
+    for (op_t op = OP_LOAD; op <= OP_ATOMIC; op++) {
+        printf("\n%s:\n", op_names[op]);
+        print_size_header("Layout");
+
+        // line-split 取跨行的中点位置：访问前后各一半
+        const char *labels[] = {"aligned", "line-split", "page-split"};
+        for (int row = 0; row < 3; row++) {
+            printf("%-10s", labels[row]);
+            for (int s = 0; s < NUM_SIZES; s++) {
+                int size = access_sizes[s];
+                layout_t l;
+                if (row == 0) {
+                    l = line_layout(0);
+                } else if (row == 1) {
+                    l = line_layout(CACHE_LINE_SIZE - size / 2);
+                } else {
+                    l = page_layout(size);
+                }
+                print_cell(measure(op, size, buffer1, &l));
+            }
+            printf("\n");
+        }
+    }
+}
+
+// ---------------------------------------------------------------
+// 超线程兄弟线程同时做相同访问
+// ---------------------------------------------------------------
+
+typedef struct {
+    int cpu_id;
+    op_t op;
+    int size;
+    layout_t layout;
+    volatile int *ready;
+    volatile int *stop;
+} sibling_arg_t;
+
+static void *sibling_thread(void *arg) {
+    sibling_arg_t *sarg = (sibling_arg_t *)arg;
+    kernel_fn fn = pick_kernel(sarg->op, sarg->size);
+    // 跨行原子操作每批只做 ATOMIC_SPLIT_ACCESSES 次，及时看到 stop
+    int n;
+    long reps = plan_accesses(sarg->op, sarg->size, &sarg->layout, &n);
+    if (reps > 64) reps = 64;
+
+    bind_to_cpu(sarg->cpu_id);
+    if (sarg->op == OP_LATENCY) prepare_chain(buffer2, &sarg->layout, sarg->size);
+
+    __atomic_fetch_add(sarg->ready, 1, __ATOMIC_SEQ_CST);
+    while (*sarg->stop == 0 && fn) {
+        fn(buffer2 + sarg->layout.start, sarg->layout.stride, n, reps);
+    }
+    return NULL;
+}
+
+static double measure_with_sibling(op_t op, int size, const layout_t *l, int sibling_cpu) {
+    pthread_t thread;
+    volatile int ready = 0;
+    volatile int stop = 0;
+    sibling_arg_t sarg = {
+        .cpu_id = sibling_cpu, .op = op, .size = size, .layout = *l,
+        .ready = &ready, .stop = &stop
+    };
+
+    pthread_create(&thread, NULL, sibling_thread, &sarg);
+    while (ready < 1) usleep(100);
+
+    double ns = measure(op, size, buffer1, l);
+
+    stop = 1;
+    pthread_join(thread, NULL);
+    return ns;
+}
+
+static void run_smt_table(void) {
+    static const int offsets[] = {0, 1, 32, 60, 63};
+    int num_offsets = sizeof(offsets) / sizeof(offsets[0]);
+
+    bind_to_cpu(0);
+
+    for (op_t op = OP_LOAD; op <= OP_ATOMIC; op++) {
+        printf("\n=== %s: alone vs HT sibling (CPU 8) doing the same ===\n", op_names[op]);
+        print_size_header("Offset");
+
+        for (int i = 0; i <= num_offsets; i++) {
+            for (int with_sibling = 0; with_sibling <= 1; with_sibling++) {
+                char label[32];
+                if (i < num_offsets) {
+                    snprintf(label, sizeof(label), "%d%s", offsets[i], with_sibling ? "+HT" : "");
+                } else {
+                    snprintf(label, sizeof(label), "page%s", with_sibling ? "+HT" : "");
+                }
+                printf("%-10s", label);
+
+                for (int s = 0; s < NUM_SIZES; s++) {
+                    int size = access_sizes[s];
+                    layout_t l = i < num_offsets ? line_layout(offsets[i]) : page_layout(size);
+                    double ns = with_sibling ? measure_with_sibling(op, size, &l, 8)
+                                             : measure(op, size, buffer1, &l);
+                    print_cell(ns);
+                }
+                printf("\n");
+            }
+        }
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--load | --latency | --store | --atomic | --page | --smt | --all]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --load      Load throughput at every byte offset in a line\n");
+    printf("  --latency   Dependent load latency at every byte offset\n");
+    printf("  --store     Store throughput at every byte offset\n");
+    printf("  --atomic    lock xadd throughput (4/8 bytes) at every byte offset\n");
+    printf("  --page      Aligned vs line-split vs page-split\n");
+    printf("  --smt       Selected offsets alone vs with HT sibling (CPU 0,8)\n");
+    printf("  --all       Run all tests\n");
+}
+
+int main(int argc, char *argv[]) {
+    // 跨页布局需要 NUM_PAGES + 1 页
+    size_t buf_size = (NUM_PAGES + 1) * PAGE_SIZE_4K;
+    buffer1 = aligned_alloc(PAGE_SIZE_4K, buf_size);
+    buffer2 = aligned_alloc(PAGE_SIZE_4K, buf_size);
+
+    if (!buffer1 || !buffer2) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+    memset(buffer1, 0, buf_size);
+    memset(buffer2, 0, buf_size);
+
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2");
+    has_avx512 = __builtin_cpu_supports("avx512f");
+
+    bind_to_cpu(0);
+
+    printf("=== Cache-Line Split and Misaligned Access Test ===\n");
+    printf("Working set: %d lines (L1 resident)\n", NUM_LINES);
+    printf("Access sizes: 4/8 scalar, 16 SSE, 32 AVX2%s, 64 AVX-512%s\n",
+           has_avx2 ? "" : " (unsupported)", has_avx512 ? "" : " (unsupported)");
+    printf("Split atomics use only %d ops (split lock may be throttled by the kernel)\n",
+           ATOMIC_SPLIT_ACCESSES);
+
+    const char *mode = argc > 1 ? argv[1] : "--all";
+
+    if (strcmp(mode, "--load") == 0) {
+        run_offset_table(OP_LOAD);
+    } else if (strcmp(mode, "--latency") == 0) {
+        run_offset_table(OP_LATENCY);
+    } else if (strcmp(mode, "--store") == 0) {
+        run_offset_table(OP_STORE);
+    } else if (strcmp(mode, "--atomic") == 0) {
+        run_offset_table(OP_ATOMIC);
+    } else if (strcmp(mode, "--page") == 0) {
+        run_page_table();
+    } else if (strcmp(mode, "--smt") == 0) {
+        run_smt_table();
+    } else if (strcmp(mode, "--all") == 0) {
+        run_offset_table(OP_LOAD);
+        run_offset_table(OP_LATENCY);
+        run_offset_table(OP_STORE);
+        run_offset_table(OP_ATOMIC);
+        run_page_table();
+        run_smt_table();
+
+        printf("\n=== Analysis ===\n");
+        printf("- Misaligned accesses inside one line are usually free\n");
+        printf("- Line splits cost roughly 2x for loads/stores (two L1 accesses)\n");
+        printf("- Page splits also need two TLB lookups and are much slower\n");
+        printf("- Split atomics take a bus lock: orders of magnitude slower,\n");
+        printf("  and they stall every other core, not just the HT sibling;\n");
+        printf("  a sibling doing split atomics slows even aligned atomics\n");
+        printf("- With an HT sibling, split accesses compete for the shared\n");
+        printf("  load/store ports and split registers\n");
+        printf("\nLayout rule: keep hot fields of packed structs from straddling\n");
+        printf("64-byte lines; never place atomics in packed structs.\n");
+    } else {
+        print_usage(argv[0]);
+        free(buffer1);
+        free(buffer2);
+        return 1;
+    }
+
+    free(buffer1);
+    free(buffer2);
+    return 0;
+}
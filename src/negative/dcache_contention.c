@@ -4,8 +4,11 @@
  * 演示同一核心的两个超线程由于访问不同内存区域，
  * 导致 L1 dcache 频繁竞争的负面效果。
  *
+ * 第二个参数 --mem-sample 开启数据地址采样（见 common/mem_sampler.h），
+ * 把采样到的访存延迟归因到 array1/array2，输出延迟直方图和热点热图。
+ *
  * 编译: gcc -O2 -pthread -o dcache_contention dcache_contention.c
- * 运行: ./dcache_contention [--same-core | --diff-core | --single]
+ * 运行: ./dcache_contention [--same-core | --diff-core | --single] [--mem-sample]
  */
 
 #define _GNU_SOURCE
@@ -16,6 +19,8 @@
 #include <stdint.h>
 #include "../common/cpu_bindind.h"
 #include "../common/prefetch_utils.h"
+#include "../common/energy.h"
+#include "../common/mem_sampler.h"
 
 // 配置参数
 #define ARRAY_SIZE (8 * 1024 * 1024)  // 8MB，远大于 L1 cache (32KB)
@@ -26,6 +31,9 @@
 static uint64_t *array1;
 static uint64_t *array2;
 
+// 是否开启数据地址采样
+static int mem_sample;
+
 // 线程参数
 typedef struct {
     int cpu_id;
@@ -72,7 +80,11 @@ static void *worker_thread(void *arg) {
         __asm__ __volatile__("pause" ::: "memory");
     }
 
+    mem_sampler_t ms;
+    if (mem_sample) mem_sampler_open(&ms);
+
     // 开始计时
+    if (mem_sample) mem_sampler_start(&ms);
     double start = get_time_sec();
 
     // 执行随机访问
@@ -80,6 +92,10 @@ static void *worker_thread(void *arg) {
 
     // 结束计时
     targ->elapsed_time = get_time_sec() - start;
+    if (mem_sample) {
+        mem_sampler_stop(&ms);
+        mem_sampler_close(&ms);
+    }
 
     return NULL;
 }
@@ -91,12 +107,31 @@ static void run_single_thread(void) {
     bind_to_cpu(0);
     print_cpu_bindind("SingleThread");
 
+    energy_meter_t em;
+    energy_sample_t es;
+    mem_sampler_t ms;
+    if (mem_sample) {
+        mem_sampler_open(&ms);
+        mem_sampler_start(&ms);
+    }
+    energy_start(&em);
     double start = get_time_sec();
     uint64_t result = random_access_pattern(array1, ARRAY_SIZE);
     double elapsed = get_time_sec() - start;
+    energy_stop(&em, &es);
+    if (mem_sample) {
+        mem_sampler_stop(&ms);
+        mem_sampler_close(&ms);
+    }
 
     printf("Result: %lu\n", result);
     printf("Time: %.4f seconds\n", elapsed);
+    energy_print(&es, (double)ITERATIONS * (ARRAY_SIZE / sizeof(uint64_t) / STRIDE));
+
+    if (mem_sample) {
+        mem_sampler_report("Single Thread");
+        mem_sampler_reset();
+    }
 }
 
 // 双线程测试
@@ -135,6 +170,9 @@ static void run_dual_thread(int cpu1, int cpu2, const char *desc) {
     }
 
     // 同时启动所有线程
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
     double wall_start = get_time_sec();
     start = 1;
 
@@ -142,6 +180,7 @@ static void run_dual_thread(int cpu1, int cpu2, const char *desc) {
     pthread_join(threads[0], NULL);
     pthread_join(threads[1], NULL);
     double wall_elapsed = get_time_sec() - wall_start;
+    energy_stop(&em, &es);
 
     // 打印结果
     printf("Thread 0: Result=%lu, Time=%.4f sec\n",
@@ -149,16 +188,23 @@ static void run_dual_thread(int cpu1, int cpu2, const char *desc) {
     printf("Thread 1: Result=%lu, Time=%.4f sec\n",
            args[1].result, args[1].elapsed_time);
     printf("Wall time: %.4f seconds\n", wall_elapsed);
+    energy_print(&es, 2.0 * ITERATIONS * (ARRAY_SIZE / sizeof(uint64_t) / STRIDE));
+
+    if (mem_sample) {
+        mem_sampler_report(desc);
+        mem_sampler_reset();
+    }
 }
 
 static void print_usage(const char *prog) {
-    printf("Usage: %s [--same-core | --diff-core | --single | --all]\n", prog);
+    printf("Usage: %s [--same-core | --diff-core | --single | --all] [--mem-sample]\n", prog);
     printf("\n");
     printf("Options:\n");
     printf("  --same-core  Two threads on same core (CPU 0,8) - HT siblings\n");
     printf("  --diff-core  Two threads on different cores (CPU 0,1)\n");
     printf("  --single     Single thread baseline\n");
     printf("  --all        Run all tests\n");
+    printf("  --mem-sample Attribute sampled load latencies to array1/array2\n");
 }
 
 int main(int argc, char *argv[]) {
@@ -176,6 +222,7 @@ int main(int argc, char *argv[]) {
     memset(array2, 0xAA, ARRAY_SIZE);
 
     printf("=== D-Cache Contention Test ===\n");
+    printf("Energy source: %s\n", energy_init());
     printf("Array size: %d MB each\n", ARRAY_SIZE / (1024 * 1024));
     printf("L1 D-Cache: 32 KB (shared by HT siblings)\n");
     printf("Stride: %d elements (%ld bytes)\n", STRIDE, STRIDE * sizeof(uint64_t));
@@ -183,6 +230,13 @@ int main(int argc, char *argv[]) {
 
     const char *mode = argc > 1 ? argv[1] : "--all";
 
+    if (argc > 2 && strcmp(argv[2], "--mem-sample") == 0) {
+        mem_sample = 1;
+        mem_sampler_register("array1", array1, ARRAY_SIZE);
+        mem_sampler_register("array2", array2, ARRAY_SIZE);
+        printf("Memory sampling: %s\n", mem_sampler_init());
+    }
+
     if (strcmp(mode, "--same-core") == 0) {
         // 同一核心的两个超线程 (CPU 0 和 8)
         run_dual_thread(0, 8, "Same Core HT (CPU 0,8) - Cache Contention");
@@ -15,6 +15,7 @@
 #include <pthread.h>
 #include <stdint.h>
 #include "../common/cpu_bindind.h"
+#include "../common/energy.h"
 
 #define ITERATIONS 50000000
 
@@ -184,12 +185,17 @@ static void run_single_thread(void) {
     bind_to_cpu(0);
     print_cpu_bindind("SingleThread");
 
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
     double start = get_time_sec();
     uint64_t result = run_func_group_a();
     double elapsed = get_time_sec() - start;
+    energy_stop(&em, &es);
 
     printf("Result: %lu\n", result);
     printf("Time: %.4f seconds\n", elapsed);
+    energy_print(&es, ITERATIONS);
 }
 
 static void run_dual_thread(int cpu1, int cpu2, const char *desc) {
@@ -215,20 +221,26 @@ static void run_dual_thread(int cpu1, int cpu2, const char *desc) {
 
     while (ready < 2) usleep(100);
 
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
     double wall_start = get_time_sec();
     start = 1;
 
     pthread_join(threads[0], NULL);
     pthread_join(threads[1], NULL);
     double wall_elapsed = get_time_sec() - wall_start;
+    energy_stop(&em, &es);
 
     printf("Thread-A: Result=%lu, Time=%.4f sec\n", args[0].result, args[0].elapsed_time);
     printf("Thread-B: Result=%lu, Time=%.4f sec\n", args[1].result, args[1].elapsed_time);
     printf("Wall time: %.4f seconds\n", wall_elapsed);
+    energy_print(&es, 2.0 * ITERATIONS);
 }
 
 int main(int argc, char *argv[]) {
     printf("=== I-Cache Contention Test ===\n");
+    printf("Energy source: %s\n", energy_init());
     printf("Functions per group: 100\n");
     printf("Iterations: %d\n", ITERATIONS);
     printf("L1 I-Cache: 32 KB (shared by HT siblings)\n");
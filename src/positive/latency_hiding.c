@@ -4,8 +4,14 @@
  * 演示超线程如何隐藏内存访问延迟：
  * 当一个线程等待内存时，另一个线程可以使用 CPU 资源。
  *
+ * 每个测量区间按线程输出 top-down 槽位分布（见 common/topdown.h），
+ * 单线程与配对运行对比即可看出配对后各线程的瓶颈如何变化。
+ *
+ * 每个线程同时记录核心周期和有效频率（见 common/freq_tracker.h），
+ * --cycles 模式把所有配置换算为 cycles/op，排除睿频变化的影响。
+ *
  * 编译: gcc -O2 -pthread -o latency_hiding latency_hiding.c -lm
- * 运行: ./latency_hiding [--same-core | --diff-core | --single | --all]
+ * 运行: ./latency_hiding [--same-core | --diff-core | --single | --cycles | --all]
  */
 
 #define _GNU_SOURCE
@@ -17,6 +23,9 @@
 #include <math.h>
 #include "../common/cpu_bindind.h"
 #include "../common/prefetch_utils.h"
+#include "../common/topdown.h"
+#include "../common/freq_tracker.h"
+#include "../common/energy.h"
 
 // 配置参数
 #define LARGE_ARRAY_SIZE (64 * 1024 * 1024)  // 64MB - 远超所有缓存
@@ -40,8 +49,36 @@ typedef struct {
     volatile int *start;
     uint64_t result;
     double elapsed_time;
+    topdown_result_t topdown;
+    freq_sample_t freq;
 } thread_arg_t;
 
+// 每个测量区间的周期记录，用于 cycles/op 汇总
+#define MAX_SUMMARY 8
+
+typedef struct {
+    char label[48];
+    double ops;
+    freq_sample_t freq;
+} summary_t;
+
+static summary_t summary[MAX_SUMMARY];
+static int num_summary;
+
+static void record_summary(const char *label, double ops, const freq_sample_t *fs) {
+    if (num_summary >= MAX_SUMMARY) return;
+    snprintf(summary[num_summary].label, sizeof(summary[num_summary].label), "%s", label);
+    summary[num_summary].ops = ops;
+    summary[num_summary].freq = *fs;
+    num_summary++;
+}
+
+static void print_freq(const char *name, uint64_t result, const freq_sample_t *fs) {
+    char ghz[16];
+    printf("%s Result=%lu, Time=%.4f sec, Cycles=%.1fM, GHz=%s\n", name, result,
+           fs->elapsed, fs->cycles / 1e6, freq_fmt_ghz(fs, ghz, sizeof(ghz)));
+}
+
 // 计算密集型任务 - 不访问内存，纯 CPU 运算
 static uint64_t compute_intensive(void) {
     double result = 1.0;
@@ -74,33 +111,66 @@ static uint64_t memory_intensive(void) {
 
 static void *worker_thread(void *arg) {
     thread_arg_t *targ = (thread_arg_t *)arg;
+    topdown_counters_t td;
 
     bind_to_cpu(targ->cpu_id);
     print_cpu_bindind(targ->type == THREAD_COMPUTE ? "Compute" : "Memory");
+    topdown_open(&td);
 
     __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
     while (*targ->start == 0) {
         __asm__ __volatile__("pause" ::: "memory");
     }
 
-    double start = get_time_sec();
+    freq_tracker_t ft;
+    topdown_start(&td);
+    freq_start(&ft, targ->cpu_id);
     targ->result = (targ->type == THREAD_COMPUTE) ?
                    compute_intensive() : memory_intensive();
-    targ->elapsed_time = get_time_sec() - start;
+    freq_stop(&ft, &targ->freq);
+    topdown_stop(&td);
+    targ->elapsed_time = targ->freq.elapsed;
 
+    topdown_read(&td, &targ->topdown);
+    topdown_close(&td);
     return NULL;
 }
 
+// 单线程区间（CPU 0）：计时、周期/频率并统计 top-down
+static uint64_t measure_single(uint64_t (*fn)(void), freq_sample_t *fs, topdown_result_t *r) {
+    topdown_counters_t td;
+    freq_tracker_t ft;
+
+    topdown_open(&td);
+    topdown_start(&td);
+    freq_start(&ft, 0);
+    uint64_t result = fn();
+    freq_stop(&ft, fs);
+    topdown_stop(&td);
+
+    topdown_read(&td, r);
+    topdown_close(&td);
+    return result;
+}
+
 // 单线程计算密集型
 static void run_single_compute(void) {
     printf("\n=== Single Thread - Compute Intensive ===\n");
     bind_to_cpu(0);
 
-    double start = get_time_sec();
-    uint64_t result = compute_intensive();
-    double elapsed = get_time_sec() - start;
-
-    printf("Result: %lu, Time: %.4f sec\n", result, elapsed);
+    freq_sample_t fs;
+    topdown_result_t td;
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
+    uint64_t result = measure_single(compute_intensive, &fs, &td);
+    energy_stop(&em, &es);
+
+    print_freq("Compute:", result, &fs);
+    record_summary("Single, compute", COMPUTE_ITERATIONS, &fs);
+    energy_print(&es, COMPUTE_ITERATIONS);
+    topdown_print_header("Top-down");
+    topdown_print_row("Compute (CPU 0)", &td);
 }
 
 // 单线程内存密集型
@@ -108,11 +178,19 @@ static void run_single_memory(void) {
     printf("\n=== Single Thread - Memory Intensive ===\n");
     bind_to_cpu(0);
 
-    double start = get_time_sec();
-    uint64_t result = memory_intensive();
-    double elapsed = get_time_sec() - start;
-
-    printf("Result: %lu, Time: %.4f sec\n", result, elapsed);
+    freq_sample_t fs;
+    topdown_result_t td;
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
+    uint64_t result = measure_single(memory_intensive, &fs, &td);
+    energy_stop(&em, &es);
+
+    print_freq("Memory:", result, &fs);
+    record_summary("Single, memory", MEMORY_ACCESSES, &fs);
+    energy_print(&es, MEMORY_ACCESSES);
+    topdown_print_header("Top-down");
+    topdown_print_row("Memory (CPU 0)", &td);
 }
 
 // 单线程串行执行两个任务
@@ -120,14 +198,19 @@ static void run_single_both(void) {
     printf("\n=== Single Thread - Both Tasks Serial ===\n");
     bind_to_cpu(0);
 
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
     double start = get_time_sec();
     uint64_t r1 = compute_intensive();
     uint64_t r2 = memory_intensive();
     double elapsed = get_time_sec() - start;
+    energy_stop(&em, &es);
 
     printf("Compute result: %lu\n", r1);
     printf("Memory result: %lu\n", r2);
     printf("Total time: %.4f sec\n", elapsed);
+    energy_print(&es, COMPUTE_ITERATIONS + MEMORY_ACCESSES);
 }
 
 // 双线程并行执行
@@ -154,16 +237,47 @@ static void run_dual_thread(int cpu1, int cpu2, const char *desc) {
 
     while (ready < 2) usleep(100);
 
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
     double wall_start = get_time_sec();
     start = 1;
 
     pthread_join(threads[0], NULL);
     pthread_join(threads[1], NULL);
     double wall_elapsed = get_time_sec() - wall_start;
+    energy_stop(&em, &es);
 
-    printf("Compute: Result=%lu, Time=%.4f sec\n", args[0].result, args[0].elapsed_time);
-    printf("Memory:  Result=%lu, Time=%.4f sec\n", args[1].result, args[1].elapsed_time);
+    print_freq("Compute:", args[0].result, &args[0].freq);
+    print_freq("Memory: ", args[1].result, &args[1].freq);
     printf("Wall time: %.4f seconds\n", wall_elapsed);
+    energy_print(&es, COMPUTE_ITERATIONS + MEMORY_ACCESSES);
+
+    char label[48];
+    snprintf(label, sizeof(label), "CPU %d,%d, compute", cpu1, cpu2);
+    record_summary(label, COMPUTE_ITERATIONS, &args[0].freq);
+    snprintf(label, sizeof(label), "CPU %d,%d, memory", cpu1, cpu2);
+    record_summary(label, MEMORY_ACCESSES, &args[1].freq);
+
+    topdown_print_header("Top-down");
+    snprintf(label, sizeof(label), "Compute (CPU %d)", cpu1);
+    topdown_print_row(label, &args[0].topdown);
+    snprintf(label, sizeof(label), "Memory (CPU %d)", cpu2);
+    topdown_print_row(label, &args[1].topdown);
+}
+
+// 与频率无关的对比：每次迭代/访问的核心周期
+static void print_cycles_summary(void) {
+    printf("\n=== Cycles per Operation ===\n");
+    printf("%-28s %10s %12s %8s\n", "Region", "Time(s)", "Cycles/op", "GHz");
+    printf("------------------------------------------------------------\n");
+    for (int i = 0; i < num_summary; i++) {
+        char ghz[16];
+        printf("%-28s %10.4f %12.1f %8s\n", summary[i].label, summary[i].freq.elapsed,
+               summary[i].freq.cycles / summary[i].ops,
+               freq_fmt_ghz(&summary[i].freq, ghz, sizeof(ghz)));
+    }
+    if (num_summary > 0) printf("Cycle source: %s\n", summary[0].freq.source);
 }
 
 int main(int argc, char *argv[]) {
@@ -181,6 +295,9 @@ int main(int argc, char *argv[]) {
     printf("Large array: %d MB\n", LARGE_ARRAY_SIZE / (1024 * 1024));
     printf("Compute iterations: %d\n", COMPUTE_ITERATIONS);
     printf("Memory accesses: %d\n", MEMORY_ACCESSES);
+    printf("Top-down method: %s\n", topdown_init());
+    printf("TSC frequency: %.2f GHz\n", freq_init());
+    printf("Energy source: %s\n", energy_init());
     printf("\nHypothesis:\n");
     printf("- HT on same core: Memory thread stalls -> Compute thread uses CPU\n");
     printf("- This 'latency hiding' should improve total throughput\n");
@@ -193,12 +310,19 @@ int main(int argc, char *argv[]) {
         run_dual_thread(0, 1, "Different Cores (CPU 0,1)");
     } else if (strcmp(mode, "--single") == 0) {
         run_single_both();
+    } else if (strcmp(mode, "--cycles") == 0) {
+        run_single_compute();
+        run_single_memory();
+        run_dual_thread(0, 8, "Same Core HT (CPU 0,8) - Latency Hiding");
+        run_dual_thread(0, 1, "Different Cores (CPU 0,1) - Full Parallelism");
+        print_cycles_summary();
     } else if (strcmp(mode, "--all") == 0) {
         run_single_compute();
         run_single_memory();
         run_single_both();
         run_dual_thread(0, 8, "Same Core HT (CPU 0,8) - Latency Hiding");
         run_dual_thread(0, 1, "Different Cores (CPU 0,1) - Full Parallelism");
+        print_cycles_summary();
 
         printf("\n=== Analysis ===\n");
         printf("Compare 'Single Both' time with 'Same Core HT' wall time:\n");
@@ -208,8 +332,21 @@ int main(int argc, char *argv[]) {
         printf("Compare 'Same Core HT' with 'Different Cores':\n");
         printf("- Different cores should be fastest (true parallelism)\n");
         printf("- Same core HT trades off resources but hides latency\n");
+        printf("\n");
+        printf("Top-down per thread:\n");
+        printf("- Memory thread alone is Backend Bound (memory); compute thread is\n");
+        printf("  mostly Retiring/Backend (core) -> complementary, good HT pair\n");
+        printf("- When paired on one core, slots lost to the sibling show up as\n");
+        printf("  SMT contention (AMD) or shift into Frontend/Backend Bound (Intel)\n");
+        printf("\n");
+        printf("Frequency:\n");
+        printf("- Turbo drops when more cores are busy; compare cycles/op, not time,\n");
+        printf("  to separate contention from frequency changes\n");
+        printf("\n");
+        printf("Energy: compare ops/J of 'Same Core HT' and 'Different Cores';\n");
+        printf("HT keeps the second core idle, so it can win on efficiency even when slower\n");
     } else {
-        printf("Usage: %s [--same-core | --diff-core | --single | --all]\n", argv[0]);
+        printf("Usage: %s [--same-core | --diff-core | --single | --cycles | --all]\n", argv[0]);
         free(large_array);
         return 1;
     }
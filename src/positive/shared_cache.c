@@ -16,6 +16,7 @@
 #include <stdint.h>
 #include "../common/cpu_bindind.h"
 #include "../common/prefetch_utils.h"
+#include "../common/energy.h"
 
 // 配置参数
 // 数组大小小于 L1 cache，确保数据能被缓存
@@ -78,14 +79,19 @@ static void run_single_thread(void) {
     bind_to_cpu(0);
     print_cpu_bindind("SingleThread");
 
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
     double start = get_time_sec();
     uint64_t result = sequential_access(0, ELEMENTS);
     double elapsed = get_time_sec() - start;
+    energy_stop(&em, &es);
 
     printf("Result: %lu\n", result);
     printf("Time: %.4f seconds\n", elapsed);
     printf("Throughput: %.2f M ops/sec\n",
            (double)(ELEMENTS * ITERATIONS) / elapsed / 1e6);
+    energy_print(&es, (double)(ELEMENTS * ITERATIONS));
 }
 
 // 双线程测试 - 每个线程处理一半数组
@@ -118,18 +124,23 @@ static void run_dual_thread(int cpu1, int cpu2, const char *desc) {
 
     while (ready < 2) usleep(100);
 
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
     double wall_start = get_time_sec();
     start = 1;
 
     pthread_join(threads[0], NULL);
     pthread_join(threads[1], NULL);
     double wall_elapsed = get_time_sec() - wall_start;
+    energy_stop(&em, &es);
 
     printf("Thread 0: Result=%lu, Time=%.4f sec\n", args[0].result, args[0].elapsed_time);
     printf("Thread 1: Result=%lu, Time=%.4f sec\n", args[1].result, args[1].elapsed_time);
     printf("Wall time: %.4f seconds\n", wall_elapsed);
     printf("Throughput: %.2f M ops/sec\n",
            (double)(ELEMENTS * ITERATIONS) / wall_elapsed / 1e6);
+    energy_print(&es, (double)(ELEMENTS * ITERATIONS));
 }
 
 int main(int argc, char *argv[]) {
@@ -139,6 +150,7 @@ int main(int argc, char *argv[]) {
     }
 
     printf("=== Shared Cache Cooperation Test ===\n");
+    printf("Energy source: %s\n", energy_init());
     printf("Array size: %d KB (fits in L1 cache)\n", ARRAY_SIZE / 1024);
     printf("Elements: %ld\n", ELEMENTS);
     printf("Iterations: %d\n", ITERATIONS);
@@ -3,8 +3,12 @@
  *
  * 测试预取指令是否能缓解超线程缓存竞争，以及两者结合的效果。
  *
+ * 超线程/多核运行时睿频会变化，每个配置同时给出每线程的核心周期和
+ * 有效频率（见 common/freq_tracker.h）。--cycles 模式按 cycles/元素
+ * 比较，排除频率差异，只留下资源争用本身。
+ *
  * 编译: gcc -O2 -pthread -o combined_test combined_test.c
- * 运行: ./combined_test
+ * 运行: ./combined_test [--time | --cycles]
  */
 
 #define _GNU_SOURCE
@@ -15,6 +19,8 @@
 #include <stdint.h>
 #include "../common/cpu_bindind.h"
 #include "../common/prefetch_utils.h"
+#include "../common/freq_tracker.h"
+#include "../common/energy.h"
 
 #define ARRAY_SIZE (32 * 1024 * 1024)  // 32MB per thread
 #define PREFETCH_DISTANCE 16
@@ -28,8 +34,18 @@ typedef struct {
     volatile int *start;
     uint64_t result;
     double elapsed_time;
+    freq_sample_t freq;
 } thread_arg_t;
 
+// 一个配置的结果：墙钟时间 + 每线程平均周期和频率
+typedef struct {
+    double time;
+    double cycles;  // 最慢线程的周期数
+    double ghz;     // 各线程平均，< 0 不可用
+    const char *source;
+    energy_sample_t energy;
+} config_result_t;
+
 // 不使用预取
 static uint64_t process_no_prefetch(uint64_t *array, size_t elements) {
     uint64_t sum = 0;
@@ -54,6 +70,7 @@ static uint64_t process_with_prefetch(uint64_t *array, size_t elements) {
 static void *worker_thread(void *arg) {
     thread_arg_t *targ = (thread_arg_t *)arg;
     size_t elements = ARRAY_SIZE / sizeof(uint64_t);
+    freq_tracker_t ft;
 
     bind_to_cpu(targ->cpu_id);
 
@@ -62,7 +79,7 @@ static void *worker_thread(void *arg) {
         __asm__ __volatile__("pause" ::: "memory");
     }
 
-    double start = get_time_sec();
+    freq_start(&ft, targ->cpu_id);
 
     if (targ->use_prefetch) {
         targ->result = process_with_prefetch(targ->array, elements);
@@ -70,31 +87,38 @@ static void *worker_thread(void *arg) {
         targ->result = process_no_prefetch(targ->array, elements);
     }
 
-    targ->elapsed_time = get_time_sec() - start;
+    freq_stop(&ft, &targ->freq);
+    targ->elapsed_time = targ->freq.elapsed;
     return NULL;
 }
 
-static double run_single(int use_prefetch) {
+static config_result_t run_single(int use_prefetch) {
     uint64_t *array = aligned_alloc(CACHE_LINE_SIZE, ARRAY_SIZE);
     memset(array, 0x55, ARRAY_SIZE);
 
     bind_to_cpu(0);
 
-    double start = get_time_sec();
+    freq_tracker_t ft;
+    freq_sample_t fs;
     size_t elements = ARRAY_SIZE / sizeof(uint64_t);
 
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
+    freq_start(&ft, 0);
     if (use_prefetch) {
         process_with_prefetch(array, elements);
     } else {
         process_no_prefetch(array, elements);
     }
+    freq_stop(&ft, &fs);
+    energy_stop(&em, &es);
 
-    double elapsed = get_time_sec() - start;
     free(array);
-    return elapsed;
+    return (config_result_t){fs.elapsed, fs.cycles, fs.ghz, fs.source, es};
 }
 
-static double run_dual(int cpu1, int cpu2, int use_prefetch) {
+static config_result_t run_dual(int cpu1, int cpu2, int use_prefetch) {
     uint64_t *array1 = aligned_alloc(CACHE_LINE_SIZE, ARRAY_SIZE);
     uint64_t *array2 = aligned_alloc(CACHE_LINE_SIZE, ARRAY_SIZE);
     memset(array1, 0x55, ARRAY_SIZE);
@@ -119,72 +143,140 @@ static double run_dual(int cpu1, int cpu2, int use_prefetch) {
 
     while (ready < 2) usleep(100);
 
+    energy_meter_t em;
+    energy_sample_t es;
+    energy_start(&em);
     double wall_start = get_time_sec();
     start = 1;
 
     pthread_join(threads[0], NULL);
     pthread_join(threads[1], NULL);
     double wall_elapsed = get_time_sec() - wall_start;
+    energy_stop(&em, &es);
 
     free(array1);
     free(array2);
-    return wall_elapsed;
+
+    config_result_t r = {wall_elapsed, args[0].freq.cycles, -1, args[0].freq.source, es};
+    if (args[1].freq.cycles > r.cycles) r.cycles = args[1].freq.cycles;
+    if (args[0].freq.ghz >= 0 && args[1].freq.ghz >= 0) {
+        r.ghz = (args[0].freq.ghz + args[1].freq.ghz) / 2;
+    }
+    return r;
+}
+
+static int cycles_mode;
+static config_result_t baseline;
+
+static double metric(config_result_t r) {
+    return cycles_mode ? r.cycles : r.time;
+}
+
+// time 模式：时间、周期、频率、相对时间加速比
+// cycles 模式：cycles/元素（每线程）、相对周期加速比
+static void print_config(const char *name, config_result_t r) {
+    char ghz[16];
+    double elements = ARRAY_SIZE / sizeof(uint64_t);
+    freq_sample_t fs = {r.time, r.cycles, r.ghz, r.source};
+
+    freq_fmt_ghz(&fs, ghz, sizeof(ghz));
+    if (cycles_mode) {
+        printf("%-40s %12.3f %8s %9.2fx\n", name, r.cycles / elements, ghz,
+               metric(baseline) / metric(r));
+    } else {
+        printf("%-40s %10.4f %11.1f %8s %9.2fx\n", name, r.time, r.cycles / 1e6, ghz,
+               metric(baseline) / metric(r));
+    }
 }
 
 int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--time";
+
+    if (strcmp(mode, "--cycles") == 0) {
+        cycles_mode = 1;
+    } else if (strcmp(mode, "--time") != 0) {
+        printf("Usage: %s [--time | --cycles]\n", argv[0]);
+        return 1;
+    }
+
     printf("=== Combined Hyper-Threading + Prefetch Test ===\n");
     printf("Array size per thread: %d MB\n", ARRAY_SIZE / (1024 * 1024));
-    printf("Prefetch distance: %d elements\n\n", PREFETCH_DISTANCE);
+    printf("Prefetch distance: %d elements\n", PREFETCH_DISTANCE);
+    printf("Energy source: %s\n", energy_init());
+    printf("TSC frequency: %.2f GHz\n\n", freq_init());
 
     // 运行所有配置
-    printf("%-40s %10s %10s\n", "Configuration", "Time(s)", "Speedup");
-    printf("------------------------------------------------------------\n");
+    if (cycles_mode) {
+        printf("%-40s %12s %8s %10s\n", "Configuration", "Cycles/elem", "GHz", "Speedup");
+    } else {
+        printf("%-40s %10s %11s %8s %10s\n", "Configuration", "Time(s)", "Cycles(M)", "GHz",
+               "Speedup");
+    }
+    printf("--------------------------------------------------------------------------------\n");
 
     // 基准：单线程无预取
-    double single_no_pf = run_single(0);
-    printf("%-40s %10.4f %10s\n", "Single thread, no prefetch", single_no_pf, "1.00x");
+    config_result_t single_no_pf = run_single(0);
+    baseline = single_no_pf;
+    print_config("Single thread, no prefetch", single_no_pf);
 
     // 单线程有预取
-    double single_pf = run_single(1);
-    printf("%-40s %10.4f %10.2fx\n", "Single thread, with prefetch",
-           single_pf, single_no_pf / single_pf);
+    config_result_t single_pf = run_single(1);
+    print_config("Single thread, with prefetch", single_pf);
 
     // 同核心超线程，无预取
-    double ht_same_no_pf = run_dual(0, 8, 0);
-    printf("%-40s %10.4f %10.2fx\n", "Same core HT (0,8), no prefetch",
-           ht_same_no_pf, single_no_pf / ht_same_no_pf);
+    config_result_t ht_same_no_pf = run_dual(0, 8, 0);
+    print_config("Same core HT (0,8), no prefetch", ht_same_no_pf);
 
     // 同核心超线程，有预取
-    double ht_same_pf = run_dual(0, 8, 1);
-    printf("%-40s %10.4f %10.2fx\n", "Same core HT (0,8), with prefetch",
-           ht_same_pf, single_no_pf / ht_same_pf);
+    config_result_t ht_same_pf = run_dual(0, 8, 1);
+    print_config("Same core HT (0,8), with prefetch", ht_same_pf);
 
     // 不同核心，无预取
-    double diff_no_pf = run_dual(0, 1, 0);
-    printf("%-40s %10.4f %10.2fx\n", "Different cores (0,1), no prefetch",
-           diff_no_pf, single_no_pf / diff_no_pf);
+    config_result_t diff_no_pf = run_dual(0, 1, 0);
+    print_config("Different cores (0,1), no prefetch", diff_no_pf);
 
     // 不同核心，有预取
-    double diff_pf = run_dual(0, 1, 1);
-    printf("%-40s %10.4f %10.2fx\n", "Different cores (0,1), with prefetch",
-           diff_pf, single_no_pf / diff_pf);
-
-    printf("\n=== Analysis ===\n");
+    config_result_t diff_pf = run_dual(0, 1, 1);
+    print_config("Different cores (0,1), with prefetch", diff_pf);
+
+    printf("Cycle source: %s\n", single_no_pf.source);
+
+    // 能耗：单线程处理一个数组，双线程处理两个
+    double elements = ARRAY_SIZE / sizeof(uint64_t);
+    printf("\n=== Energy ===\n");
+    printf("%-38s ", "Single, no prefetch");
+    energy_print(&single_no_pf.energy, elements);
+    printf("%-38s ", "Single, with prefetch");
+    energy_print(&single_pf.energy, elements);
+    printf("%-38s ", "Same core HT (0,8), no prefetch");
+    energy_print(&ht_same_no_pf.energy, 2 * elements);
+    printf("%-38s ", "Same core HT (0,8), with prefetch");
+    energy_print(&ht_same_pf.energy, 2 * elements);
+    printf("%-38s ", "Different cores (0,1), no prefetch");
+    energy_print(&diff_no_pf.energy, 2 * elements);
+    printf("%-38s ", "Different cores (0,1), with prefetch");
+    energy_print(&diff_pf.energy, 2 * elements);
+
+    // 按所选口径计算改进幅度
+    double base = metric(single_no_pf);
+
+    printf("\n=== Analysis (%s) ===\n", cycles_mode ? "cycles" : "wall time");
     printf("Prefetch improvement (single):     %.1f%%\n",
-           (single_no_pf / single_pf - 1) * 100);
+           (base / metric(single_pf) - 1) * 100);
     printf("HT same core improvement:          %.1f%%\n",
-           (single_no_pf / ht_same_no_pf - 1) * 100);
+           (base / metric(ht_same_no_pf) - 1) * 100);
     printf("HT same core + prefetch:           %.1f%%\n",
-           (single_no_pf / ht_same_pf - 1) * 100);
+           (base / metric(ht_same_pf) - 1) * 100);
     printf("Different cores improvement:       %.1f%%\n",
-           (single_no_pf / diff_no_pf - 1) * 100);
+           (base / metric(diff_no_pf) - 1) * 100);
     printf("Different cores + prefetch:        %.1f%%\n",
-           (single_no_pf / diff_pf - 1) * 100);
+           (base / metric(diff_pf) - 1) * 100);
 
     printf("\nKey findings:\n");
     printf("1. Compare HT with/without prefetch to see if prefetch helps\n");
     printf("2. Compare HT vs different cores for parallelism benefit\n");
     printf("3. Best config is usually: different cores + prefetch\n");
+    printf("4. If GHz drops in dual runs, use --cycles to separate turbo from contention\n");
 
     return 0;
 }
@@ -0,0 +1,340 @@
+/*
+ * hw_prefetch_sweep.c - 硬件预取器特性扫描
+ *
+ * sequential_prefetch.c 只测试单条单位步长流。本测试扫描：
+ * - 步长 64B..8KB（含跨 4KB 页边界的步长），正向/反向
+ * - 并发交错的流数量 1..64，找出预取器流表容量
+ * - 超线程兄弟线程同时运行多条流时对预取器资源的竞争
+ *
+ * 每个配置都恰好把缓冲区的每条缓存行访问一次，
+ * 因此不同配置的总访问量相同，带宽可以直接比较。
+ *
+ * 编译: gcc -O2 -pthread -o hw_prefetch_sweep hw_prefetch_sweep.c
+ * 运行: ./hw_prefetch_sweep [--stride | --streams | --smt | --all]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdint.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+#include "../common/perf_counters.h"
+
+// 配置参数
+#define ARRAY_SIZE (128 * 1024 * 1024)  // 128MB - 远超 L3
+#define PAGE_SIZE_4K 4096
+#define MAX_STREAMS 64
+#define STREAM_STAGGER 320  // 各流起点错开，避免同时落在相同 cache set
+
+static char *buffer1;
+static char *buffer2;
+
+// 每线程的计数器：L1D 缺失 / LLC 缺失
+typedef struct {
+    perf_counter_t counters[2];
+} thread_counters_t;
+
+static void counters_open(thread_counters_t *tc) {
+    perf_counter_open(&tc->counters[0], "L1D-miss", PERF_TYPE_HW_CACHE, PERF_L1D_READ_MISS);
+    perf_counter_open(&tc->counters[1], "LLC-miss", PERF_TYPE_HARDWARE,
+                      PERF_COUNT_HW_CACHE_MISSES);
+}
+
+static void flush_buffer(char *buf) {
+    for (size_t i = 0; i < ARRAY_SIZE; i += CACHE_LINE_SIZE) {
+        CLFLUSH(buf + i);
+    }
+    BARRIER();
+}
+
+// 按 stride 遍历：外层按行偏移分多趟，每趟是一条纯步长流
+// stride 为 CACHE_LINE_SIZE 的倍数，共访问 ARRAY_SIZE / 64 次
+static uint64_t stride_walk(const char *buf, size_t stride, int backward) {
+    uint64_t sum = 0;
+    size_t passes = stride / CACHE_LINE_SIZE;
+
+    for (size_t pass = 0; pass < passes; pass++) {
+        size_t off = pass * CACHE_LINE_SIZE;
+        size_t n = (ARRAY_SIZE - off + stride - 1) / stride;
+
+        if (!backward) {
+            for (size_t k = 0; k < n; k++) {
+                sum += *(const uint64_t *)(buf + off + k * stride);
+            }
+        } else {
+            for (size_t k = n; k-- > 0;) {
+                sum += *(const uint64_t *)(buf + off + k * stride);
+            }
+        }
+    }
+    return sum;
+}
+
+// num_streams 条单位步长流交错前进，每条流占缓冲区的一段
+static uint64_t streams_walk(const char *buf, int num_streams, int backward) {
+    const char *base[MAX_STREAMS];
+    size_t region = (ARRAY_SIZE / num_streams) & ~(size_t)(PAGE_SIZE_4K - 1);
+    size_t lines = (region - PAGE_SIZE_4K) / CACHE_LINE_SIZE;
+    uint64_t sum = 0;
+
+    for (int s = 0; s < num_streams; s++) {
+        base[s] = buf + s * region + (s * STREAM_STAGGER) % PAGE_SIZE_4K;
+    }
+
+    if (!backward) {
+        for (size_t i = 0; i < lines; i++) {
+            for (int s = 0; s < num_streams; s++) {
+                sum += *(const uint64_t *)(base[s] + i * CACHE_LINE_SIZE);
+            }
+        }
+    } else {
+        for (size_t i = lines; i-- > 0;) {
+            for (int s = 0; s < num_streams; s++) {
+                sum += *(const uint64_t *)(base[s] + i * CACHE_LINE_SIZE);
+            }
+        }
+    }
+    return sum;
+}
+
+static size_t streams_total_lines(int num_streams) {
+    size_t region = (ARRAY_SIZE / num_streams) & ~(size_t)(PAGE_SIZE_4K - 1);
+    return (region - PAGE_SIZE_4K) / CACHE_LINE_SIZE * num_streams;
+}
+
+static void print_row(const char *label, size_t lines, double elapsed,
+                      thread_counters_t *tc, uint64_t result) {
+    char l1[32], llc[32];
+    double per_line = 1.0 / lines;
+
+    printf("%-18s %8.4f %10.2f %8.2f %10s %10s  (result=%lu)\n",
+           label, elapsed,
+           lines * CACHE_LINE_SIZE / elapsed / (1024.0 * 1024 * 1024),
+           elapsed / lines * 1e9,
+           perf_counter_fmt(&tc->counters[0], l1, sizeof(l1), per_line),
+           perf_counter_fmt(&tc->counters[1], llc, sizeof(llc), per_line),
+           result % 1000);
+}
+
+static void print_header(const char *first) {
+    printf("%-18s %8s %10s %8s %10s %10s\n",
+           first, "Time(s)", "BW(GB/s)", "ns/line", "L1D/line", "LLC/line");
+    printf("----------------------------------------------------------------------\n");
+}
+
+// 步长扫描
+static void run_stride_sweep(void) {
+    static const size_t strides[] = {
+        64, 128, 192, 256, 320, 512, 1024, 2048, 4032, 4096, 4160, 8192
+    };
+    int num_strides = sizeof(strides) / sizeof(strides[0]);
+    thread_counters_t tc;
+    size_t lines = ARRAY_SIZE / CACHE_LINE_SIZE;
+
+    counters_open(&tc);
+
+    for (int backward = 0; backward <= 1; backward++) {
+        printf("\n=== Stride Sweep (%s) ===\n", backward ? "backward" : "forward");
+        print_header("Stride(B)/Pages");
+
+        for (int i = 0; i < num_strides; i++) {
+            char label[32];
+            size_t stride = strides[i];
+            // 每次访问跨越的页数: <1 表示多次访问落在同一页
+            snprintf(label, sizeof(label), "%5zu / %.3f", stride,
+                     (double)stride / PAGE_SIZE_4K);
+
+            flush_buffer(buffer1);
+            perf_counters_start(tc.counters, 2);
+            double start = get_time_sec();
+            uint64_t result = stride_walk(buffer1, stride, backward);
+            double elapsed = get_time_sec() - start;
+            perf_counters_stop(tc.counters, 2);
+
+            print_row(label, lines, elapsed, &tc, result);
+        }
+    }
+
+    perf_counters_close(tc.counters, 2);
+}
+
+static const int stream_counts[] = {1, 2, 4, 8, 12, 16, 24, 32, 48, 64};
+#define NUM_STREAM_COUNTS (int)(sizeof(stream_counts) / sizeof(stream_counts[0]))
+
+// 流数量扫描
+static void run_stream_sweep(void) {
+    thread_counters_t tc;
+    counters_open(&tc);
+
+    for (int backward = 0; backward <= 1; backward++) {
+        printf("\n=== Concurrent Stream Sweep (%s) ===\n", backward ? "backward" : "forward");
+        print_header("Streams");
+
+        for (int i = 0; i < NUM_STREAM_COUNTS; i++) {
+            char label[32];
+            int n = stream_counts[i];
+            snprintf(label, sizeof(label), "%d", n);
+
+            flush_buffer(buffer1);
+            perf_counters_start(tc.counters, 2);
+            double start = get_time_sec();
+            uint64_t result = streams_walk(buffer1, n, backward);
+            double elapsed = get_time_sec() - start;
+            perf_counters_stop(tc.counters, 2);
+
+            print_row(label, streams_total_lines(n), elapsed, &tc, result);
+        }
+    }
+
+    perf_counters_close(tc.counters, 2);
+}
+
+// 线程参数
+typedef struct {
+    int cpu_id;
+    int num_streams;
+    char *buffer;
+    volatile int *ready;
+    volatile int *start;
+    thread_counters_t tc;
+    uint64_t result;
+    double elapsed_time;
+} thread_arg_t;
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+
+    bind_to_cpu(targ->cpu_id);
+    counters_open(&targ->tc);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __asm__ __volatile__("pause" ::: "memory");
+    }
+
+    perf_counters_start(targ->tc.counters, 2);
+    double start = get_time_sec();
+    targ->result = streams_walk(targ->buffer, targ->num_streams, 0);
+    targ->elapsed_time = get_time_sec() - start;
+    perf_counters_stop(targ->tc.counters, 2);
+
+    return NULL;
+}
+
+static void run_dual_streams(int cpu1, int cpu2, int num_streams) {
+    pthread_t threads[2];
+    thread_arg_t args[2];
+    volatile int ready = 0;
+    volatile int start = 0;
+
+    flush_buffer(buffer1);
+    flush_buffer(buffer2);
+
+    args[0] = (thread_arg_t){
+        .cpu_id = cpu1, .num_streams = num_streams, .buffer = buffer1,
+        .ready = &ready, .start = &start
+    };
+    args[1] = (thread_arg_t){
+        .cpu_id = cpu2, .num_streams = num_streams, .buffer = buffer2,
+        .ready = &ready, .start = &start
+    };
+
+    pthread_create(&threads[0], NULL, worker_thread, &args[0]);
+    pthread_create(&threads[1], NULL, worker_thread, &args[1]);
+
+    while (ready < 2) usleep(100);
+    start = 1;
+
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    size_t lines = streams_total_lines(num_streams);
+    for (int t = 0; t < 2; t++) {
+        char label[32];
+        snprintf(label, sizeof(label), "%d x2 (T%d)", num_streams, t);
+        print_row(label, lines, args[t].elapsed_time, &args[t].tc, args[t].result);
+        perf_counters_close(args[t].tc.counters, 2);
+    }
+}
+
+// 超线程兄弟线程竞争预取器资源
+static void run_smt_sweep(void) {
+    printf("\n=== Same Core HT (CPU 0,8) - Streams per Thread ===\n");
+    print_header("Streams");
+    for (int i = 0; i < NUM_STREAM_COUNTS; i++) {
+        run_dual_streams(0, 8, stream_counts[i]);
+    }
+
+    printf("\n=== Different Cores (CPU 0,1) - Streams per Thread ===\n");
+    print_header("Streams");
+    for (int i = 0; i < NUM_STREAM_COUNTS; i++) {
+        run_dual_streams(0, 1, stream_counts[i]);
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--stride | --streams | --smt | --all]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --stride   Stride sweep 64B..8KB, forward and backward\n");
+    printf("  --streams  Concurrent interleaved stream sweep 1..%d\n", MAX_STREAMS);
+    printf("  --smt      Stream sweep with HT sibling vs different core\n");
+    printf("  --all      Run all tests\n");
+}
+
+int main(int argc, char *argv[]) {
+    buffer1 = aligned_alloc(PAGE_SIZE_4K, ARRAY_SIZE);
+    buffer2 = aligned_alloc(PAGE_SIZE_4K, ARRAY_SIZE);
+
+    if (!buffer1 || !buffer2) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    memset(buffer1, 0x55, ARRAY_SIZE);
+    memset(buffer2, 0xAA, ARRAY_SIZE);
+
+    bind_to_cpu(0);
+
+    printf("=== Hardware Prefetcher Characterization ===\n");
+    printf("Array size: %d MB\n", ARRAY_SIZE / (1024 * 1024));
+    printf("Every configuration touches each cache line exactly once.\n");
+
+    const char *mode = argc > 1 ? argv[1] : "--all";
+
+    if (strcmp(mode, "--stride") == 0) {
+        run_stride_sweep();
+    } else if (strcmp(mode, "--streams") == 0) {
+        run_stream_sweep();
+    } else if (strcmp(mode, "--smt") == 0) {
+        run_smt_sweep();
+    } else if (strcmp(mode, "--all") == 0) {
+        run_stride_sweep();
+        run_stream_sweep();
+        run_smt_sweep();
+
+        printf("\n=== Analysis ===\n");
+        printf("Stride sweep:\n");
+        printf("- ns/line stays low while the stride prefetcher tracks the pattern\n");
+        printf("- The jump in ns/line marks the maximum detected stride\n");
+        printf("- Strides >= 4KB cross a page every access; most prefetchers\n");
+        printf("  stop at page boundaries, so expect DRAM latency there\n");
+        printf("Stream sweep:\n");
+        printf("- Bandwidth collapses once streams exceed the stream table size\n");
+        printf("SMT sweep:\n");
+        printf("- If HT siblings share the stream table, the knee moves to\n");
+        printf("  half the stream count compared to different cores\n");
+    } else {
+        print_usage(argv[0]);
+        free(buffer1);
+        free(buffer2);
+        return 1;
+    }
+
+    free(buffer1);
+    free(buffer2);
+    return 0;
+}
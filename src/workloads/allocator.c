@@ -0,0 +1,609 @@
+/*
+ * allocator.c - 小对象分配器测试：glibc malloc vs 每线程 slab 分配器
+ *
+ * 其它测试都只在开始时分配几个大缓冲区，而服务程序每秒分配数百万个小对象。
+ * 本测试比较 glibc malloc 与一个内置的每线程 slab 分配器：
+ *
+ *   slab       每个线程一个 heap，按 2 的幂大小类（16..2048B）从 64KB slab 中切分。
+ *              slab 按 64KB 对齐，头部记录所属 heap 和大小类，free 时屏蔽低位找到头部。
+ *              本线程释放进本地空闲链表；跨线程释放用 CAS 压入所属 heap 的远程链表
+ *              （每个大小类一个独立缓存行），所属线程本地链表为空时一次性取走。
+ *              每个新 slab 的首个对象偏移 color * 64 字节（缓存行着色），
+ *              让不同 slab 的同序号对象落在不同的缓存组。
+ *   slab-line  同上，但大小向上取整到缓存行，每个对象独占缓存行
+ *
+ * 场景：
+ *   steady         每线程维持 1024 个存活对象的窗口，随机替换（大小混合）
+ *   xthread        生产者分配、消费者释放（SPSC 环），全部是跨线程释放
+ *   burst          每轮先分配 32K 个对象再全部释放
+ *   false-sharing  主线程分配小对象后轮流交给各线程，各线程反复写自己的对象；
+ *                  相邻对象属于不同线程时产生伪共享
+ *
+ * 每个测量点在 fork 出的子进程中运行，峰值 RSS 来自 wait4 的 ru_maxrss。
+ *
+ * 编译: gcc -O2 -pthread -o allocator allocator.c
+ * 运行: ./allocator [--steady | --xthread | --burst | --false-sharing | --all]
+ *                   [--threads N] [--placement spread|compact] [--ops M]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define SLAB_SIZE (64 * 1024)             // slab 大小（也是对齐）
+#define NUM_CLASSES 8                     // 16, 32, ..., 2048
+#define MIN_CLASS_SHIFT 4
+#define MAX_SMALL_SIZE 2048
+#define HEAP_RESERVE (512UL * 1024 * 1024) // 每线程保留的虚拟地址空间
+#define MAX_THREADS NUM_HW_THREADS
+#define NUM_HEAPS (MAX_THREADS + 1)       // 工作线程 + 主线程
+#define DEFAULT_OPS 2000000               // 每线程操作数（分配 + 释放）
+#define WINDOW 1024                       // steady 场景的存活对象数
+#define BURST_OBJECTS 32768               // burst 场景每轮对象数
+#define RING_SIZE 1024                    // xthread 场景 SPSC 环大小
+#define FS_OBJECT_SIZE 24                 // false-sharing 场景对象大小
+#define FS_OBJECTS_PER_THREAD 64
+#define FS_ROUNDS 20000
+
+// ---------------------------------------------------------------
+// slab 分配器
+// ---------------------------------------------------------------
+
+typedef struct thread_heap thread_heap_t;
+
+typedef struct {
+    thread_heap_t *owner;
+    uint32_t cls;
+} slab_hdr_t;
+
+typedef struct {
+    void *free;               // 本地空闲链表（对象首 8 字节链接）
+    char *bump;               // 当前 slab 未切分部分
+    char *bump_end;
+    uint32_t color;           // 下一个 slab 的着色序号
+} class_state_t;
+
+struct thread_heap {
+    class_state_t cls[NUM_CLASSES];
+    char *next_slab;          // 本线程保留区中下一个未用 slab
+    char *reserve_end;
+    CACHE_PADDED(void *, remote)[NUM_CLASSES];  // 其它线程释放的对象（MPSC 栈）
+} CACHE_ALIGNED;
+
+static char *slab_region;     // 所有 heap 的保留区，每个 heap 占 HEAP_RESERVE
+static thread_heap_t slab_heaps[NUM_HEAPS];
+static int slab_heap_count;
+static __thread thread_heap_t *my_heap;
+
+static int slab_init(void) {
+    void *p = mmap(NULL, NUM_HEAPS * HEAP_RESERVE + SLAB_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap failed");
+        return 1;
+    }
+    slab_region = (char *)(((uintptr_t)p + SLAB_SIZE - 1) & ~(uintptr_t)(SLAB_SIZE - 1));
+    return 0;
+}
+
+static thread_heap_t *heap_get(void) {
+    if (!my_heap) {
+        int idx = __atomic_fetch_add(&slab_heap_count, 1, __ATOMIC_RELAXED);
+        my_heap = &slab_heaps[idx];
+        my_heap->next_slab = slab_region + idx * HEAP_RESERVE;
+        my_heap->reserve_end = my_heap->next_slab + HEAP_RESERVE;
+    }
+    return my_heap;
+}
+
+static inline int size_class(size_t size) {
+    return size <= 16 ? 0 : 64 - __builtin_clzl(size - 1) - MIN_CLASS_SHIFT;
+}
+
+static void *slab_refill(thread_heap_t *h, int c) {
+    class_state_t *cs = &h->cls[c];
+
+    // 先取走其它线程释放的对象
+    void *remote = __atomic_exchange_n(&h->remote[c].value, NULL, __ATOMIC_ACQUIRE);
+    if (remote) {
+        cs->free = *(void **)remote;
+        return remote;
+    }
+
+    size_t size = (size_t)1 << (c + MIN_CLASS_SHIFT);
+    if ((size_t)(cs->bump_end - cs->bump) < size) {
+        if (h->next_slab + SLAB_SIZE > h->reserve_end) return NULL;
+        char *slab = h->next_slab;
+        h->next_slab += SLAB_SIZE;
+        slab_hdr_t *hdr = (slab_hdr_t *)slab;
+        hdr->owner = h;
+        hdr->cls = c;
+
+        // 缓存行着色：用 slab 尾部放不下一个对象的剩余空间错开起点
+        size_t usable = SLAB_SIZE - CACHE_LINE_SIZE;
+        size_t colors = (usable % size) / CACHE_LINE_SIZE + 1;
+        cs->bump = slab + CACHE_LINE_SIZE + (cs->color++ % colors) * CACHE_LINE_SIZE;
+        cs->bump_end = slab + SLAB_SIZE;
+    }
+    void *p = cs->bump;
+    cs->bump += size;
+    return p;
+}
+
+static inline void *slab_alloc_class(int c) {
+    thread_heap_t *h = heap_get();
+    void *p = h->cls[c].free;
+    if (p) {
+        h->cls[c].free = *(void **)p;
+        return p;
+    }
+    return slab_refill(h, c);
+}
+
+static void *slab_malloc(size_t size) {
+    if (size > MAX_SMALL_SIZE) return malloc(size);
+    return slab_alloc_class(size_class(size));
+}
+
+static void *slab_line_malloc(size_t size) {
+    return slab_malloc(size < CACHE_LINE_SIZE ? CACHE_LINE_SIZE : size);
+}
+
+static void slab_free(void *p) {
+    if ((char *)p < slab_region || (char *)p >= slab_region + NUM_HEAPS * HEAP_RESERVE) {
+        free(p);
+        return;
+    }
+    slab_hdr_t *hdr = (slab_hdr_t *)((uintptr_t)p & ~(uintptr_t)(SLAB_SIZE - 1));
+    thread_heap_t *h = hdr->owner;
+    int c = hdr->cls;
+
+    if (h == my_heap) {
+        *(void **)p = h->cls[c].free;
+        h->cls[c].free = p;
+        return;
+    }
+    void *head = __atomic_load_n(&h->remote[c].value, __ATOMIC_RELAXED);
+    do {
+        *(void **)p = head;
+    } while (!__atomic_compare_exchange_n(&h->remote[c].value, &head, p, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// ---------------------------------------------------------------
+// 分配器表
+// ---------------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    void *(*alloc)(size_t);
+    void (*free)(void *);
+} allocator_t;
+
+enum { A_GLIBC, A_SLAB, A_SLAB_LINE, NUM_ALLOCATORS };
+
+static const allocator_t allocators[NUM_ALLOCATORS] = {
+    {"glibc", malloc, free},
+    {"slab", slab_malloc, slab_free},
+    {"slab-line", slab_line_malloc, slab_free},
+};
+
+// ---------------------------------------------------------------
+// 场景
+// ---------------------------------------------------------------
+
+typedef enum { S_STEADY, S_XTHREAD, S_BURST, S_FALSE_SHARING, NUM_SCENARIOS } scenario_t;
+
+static const char *scenario_names[NUM_SCENARIOS] = {
+    "steady", "xthread", "burst", "false-sharing"
+};
+
+typedef struct {
+    CACHE_PADDED(volatile uint32_t, head);
+    CACHE_PADDED(volatile uint32_t, tail);
+    void *slots[RING_SIZE];
+} spsc_ring_t;
+
+typedef struct {
+    scenario_t scenario;
+    const allocator_t *a;
+    int nthreads;
+    long ops;
+    spsc_ring_t *rings;       // xthread：每对线程一个
+    uint64_t **fs_objects;    // false-sharing：第 i 个对象属于线程 i % nthreads
+} bench_ctx_t;
+
+typedef struct {
+    int cpu_id;
+    int tid;
+    bench_ctx_t *ctx;
+    long done;                // 完成的操作数
+    uint64_t check;
+    volatile int *ready;
+    volatile int *start;
+} thread_arg_t;
+
+static inline uint32_t xorshift32(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+// 环满/空时自旋，过久则让出 CPU（线程数超过 CPU 数时对端才能运行）
+static inline void spin_pause(int spins) {
+    if (spins < 1024) {
+        __builtin_ia32_pause();
+    } else {
+        sched_yield();
+    }
+}
+
+// 70% 16..64B，25% 65..512B，5% 513..2048B
+static inline size_t mix_size(uint32_t *rng) {
+    uint32_t r = xorshift32(rng);
+    uint32_t pct = r % 100;
+    r >>= 8;
+    if (pct < 70) return 16 + r % 49;
+    if (pct < 95) return 65 + r % 448;
+    return 513 + r % 1536;
+}
+
+static void steady_worker(thread_arg_t *targ) {
+    const allocator_t *a = targ->ctx->a;
+    uint32_t rng = 0x12345u + targ->tid * 7919u;
+    void *window[WINDOW];
+    long ops = targ->ctx->ops;
+
+    for (int i = 0; i < WINDOW; i++) {
+        window[i] = a->alloc(mix_size(&rng));
+        *(volatile char *)window[i] = 1;
+    }
+    for (long i = 0; i < ops / 2; i++) {
+        uint32_t slot = xorshift32(&rng) % WINDOW;
+        a->free(window[slot]);
+        window[slot] = a->alloc(mix_size(&rng));
+        *(volatile char *)window[slot] = 1;
+    }
+    for (int i = 0; i < WINDOW; i++) a->free(window[i]);
+    targ->done = ops / 2 * 2;
+}
+
+static void xthread_worker(thread_arg_t *targ) {
+    const allocator_t *a = targ->ctx->a;
+    spsc_ring_t *ring = &targ->ctx->rings[targ->tid / 2];
+    long items = targ->ctx->ops / 2;
+    uint64_t check = 0;
+
+    if (targ->tid % 2 == 0) {
+        // 生产者
+        uint32_t rng = 0x777u + targ->tid * 7919u;
+        for (long i = 0; i < items; i++) {
+            uint64_t *p = a->alloc(mix_size(&rng));
+            p[0] = i;
+            uint32_t head = ring->head.value;
+            for (int spins = 0;
+                 head - __atomic_load_n(&ring->tail.value, __ATOMIC_ACQUIRE) == RING_SIZE;
+                 spins++) {
+                spin_pause(spins);
+            }
+            ring->slots[head % RING_SIZE] = p;
+            __atomic_store_n(&ring->head.value, head + 1, __ATOMIC_RELEASE);
+        }
+    } else {
+        // 消费者
+        for (long i = 0; i < items; i++) {
+            uint32_t tail = ring->tail.value;
+            for (int spins = 0; __atomic_load_n(&ring->head.value, __ATOMIC_ACQUIRE) == tail;
+                 spins++) {
+                spin_pause(spins);
+            }
+            uint64_t *p = ring->slots[tail % RING_SIZE];
+            __atomic_store_n(&ring->tail.value, tail + 1, __ATOMIC_RELEASE);
+            check += p[0];
+            a->free(p);
+        }
+    }
+    targ->done = items;
+    targ->check = check;
+}
+
+static void burst_worker(thread_arg_t *targ) {
+    const allocator_t *a = targ->ctx->a;
+    uint32_t rng = 0xBEEFu + targ->tid * 7919u;
+    void **objs = malloc(BURST_OBJECTS * sizeof(void *));
+    long rounds = targ->ctx->ops / (2 * BURST_OBJECTS);
+    if (rounds < 1) rounds = 1;
+    if (!objs) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+
+    for (long r = 0; r < rounds; r++) {
+        for (int i = 0; i < BURST_OBJECTS; i++) {
+            objs[i] = a->alloc(mix_size(&rng));
+            *(volatile char *)objs[i] = 1;
+        }
+        // 以与分配顺序无关的步长释放
+        for (int i = 0; i < BURST_OBJECTS; i++) {
+            a->free(objs[(i * 7919u) % BURST_OBJECTS]);
+        }
+    }
+    free(objs);
+    targ->done = rounds * 2 * BURST_OBJECTS;
+}
+
+static void false_sharing_worker(thread_arg_t *targ) {
+    bench_ctx_t *ctx = targ->ctx;
+    uint64_t *mine[FS_OBJECTS_PER_THREAD];
+    for (int i = 0; i < FS_OBJECTS_PER_THREAD; i++) {
+        mine[i] = ctx->fs_objects[i * ctx->nthreads + targ->tid];
+    }
+    for (int r = 0; r < FS_ROUNDS; r++) {
+        for (int i = 0; i < FS_OBJECTS_PER_THREAD; i++) {
+            (*(volatile uint64_t *)mine[i])++;
+        }
+    }
+    targ->done = (long)FS_ROUNDS * FS_OBJECTS_PER_THREAD;
+}
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    switch (targ->ctx->scenario) {
+    case S_STEADY: steady_worker(targ); break;
+    case S_XTHREAD: xthread_worker(targ); break;
+    case S_BURST: burst_worker(targ); break;
+    case S_FALSE_SHARING: false_sharing_worker(targ); break;
+    default: break;
+    }
+    return NULL;
+}
+
+typedef struct {
+    double ops_per_sec;
+    double peak_rss_mb;
+    int ok;
+} case_result_t;
+
+// 在当前进程中运行一个测量点（子进程调用）
+static case_result_t run_case_inproc(scenario_t s, int alloc_idx, int nthreads,
+                                     placement_t placement, long ops) {
+    pthread_t threads[MAX_THREADS];
+    thread_arg_t args[MAX_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+    const allocator_t *a = &allocators[alloc_idx];
+    bench_ctx_t ctx = {.scenario = s, .a = a, .nthreads = nthreads, .ops = ops};
+    case_result_t r = {0, 0, 1};
+    int nobj = FS_OBJECTS_PER_THREAD * nthreads;
+
+    if (s == S_XTHREAD) {
+        ctx.rings = aligned_alloc(CACHE_LINE_SIZE, nthreads / 2 * sizeof(spsc_ring_t));
+        if (!ctx.rings) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+        memset(ctx.rings, 0, nthreads / 2 * sizeof(spsc_ring_t));
+    } else if (s == S_FALSE_SHARING) {
+        ctx.fs_objects = malloc(nobj * sizeof(uint64_t *));
+        if (!ctx.fs_objects) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+        for (int i = 0; i < nobj; i++) {
+            ctx.fs_objects[i] = a->alloc(FS_OBJECT_SIZE);
+            ctx.fs_objects[i][0] = 0;
+        }
+    }
+
+    for (int t = 0; t < nthreads; t++) {
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, placement), .tid = t, .ctx = &ctx,
+            .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < nthreads) usleep(100);
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+    double elapsed = get_time_sec() - t0;
+
+    long total = 0;
+    for (int t = 0; t < nthreads; t++) total += args[t].done;
+    r.ops_per_sec = total / elapsed;
+
+    if (s == S_XTHREAD) {
+        uint64_t expect = (uint64_t)(ops / 2) * (ops / 2 - 1) / 2;
+        for (int t = 1; t < nthreads; t += 2) r.ok &= args[t].check == expect;
+        free(ctx.rings);
+    } else if (s == S_FALSE_SHARING) {
+        for (int i = 0; i < nobj; i++) {
+            r.ok &= ctx.fs_objects[i][0] == FS_ROUNDS;
+            a->free(ctx.fs_objects[i]);
+        }
+        free(ctx.fs_objects);
+    }
+    return r;
+}
+
+// fork 一个子进程运行测量点，使每个分配器从干净的堆开始并得到独立的峰值 RSS
+static case_result_t run_case(scenario_t s, int alloc_idx, int nthreads,
+                              placement_t placement, long ops) {
+    case_result_t *shared = mmap(NULL, sizeof(case_result_t), PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    case_result_t r = {0, 0, 0};
+    struct rusage ru;
+    int status;
+
+    if (shared == MAP_FAILED) {
+        perror("mmap failed");
+        return r;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork failed");
+        munmap(shared, sizeof(*shared));
+        return r;
+    }
+    if (pid == 0) {
+        if (slab_init()) _exit(1);
+        *shared = run_case_inproc(s, alloc_idx, nthreads, placement, ops);
+        _exit(0);
+    }
+    if (wait4(pid, &status, 0, &ru) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        r = *shared;
+        r.peak_rss_mb = ru.ru_maxrss / 1024.0;
+    }
+    munmap(shared, sizeof(*shared));
+    return r;
+}
+
+// ---------------------------------------------------------------
+// 测试
+// ---------------------------------------------------------------
+
+static void run_scenario(scenario_t s, int max_threads, placement_t placement, long ops) {
+    int first = s == S_XTHREAD ? 2 : 1;
+    int nalloc = s == S_FALSE_SHARING ? NUM_ALLOCATORS : A_SLAB + 1;
+
+    printf("\n=== Scenario: %s, placement: %s ===\n", scenario_names[s],
+           placement_name(placement));
+    if (s == S_XTHREAD) {
+        printf("Threads form producer/consumer pairs; every free is a cross-thread free\n");
+    } else if (s == S_FALSE_SHARING) {
+        printf("%d-byte objects allocated by one thread, handed out round-robin; M updates/s\n",
+               FS_OBJECT_SIZE);
+    }
+    printf("%s; peak RSS of the whole process\n",
+           s == S_FALSE_SHARING ? "FS cost = slab-line / glibc" : "M ops/s (allocations + frees)");
+    printf("%-8s", "Threads");
+    for (int k = 0; k < nalloc; k++) printf(" %11s", allocators[k].name);
+    printf(" %9s", s == S_FALSE_SHARING ? "FS cost" : "Speedup");
+    for (int k = 0; k < nalloc; k++) {
+        char label[24];
+        snprintf(label, sizeof(label), "RSS %s", allocators[k].name);
+        printf(" %13s", label);
+    }
+    printf("  Check\n");
+    printf("---------------------------------------------------------------------------------\n");
+
+    for (int nt = first; nt <= max_threads; nt = nt < max_threads && nt * 2 > max_threads
+                                                ? max_threads : nt * 2) {
+        if (s == S_XTHREAD && nt % 2) continue;
+        case_result_t res[NUM_ALLOCATORS];
+        int ok = 1;
+        printf("%-8d", nt);
+        for (int k = 0; k < nalloc; k++) {
+            res[k] = run_case(s, k, nt, placement, ops);
+            ok &= res[k].ok;
+            printf(" %11.1f", res[k].ops_per_sec / 1e6);
+            fflush(stdout);
+        }
+        if (s == S_FALSE_SHARING) {
+            // 相对每对象独占缓存行的 slab-line 的减速
+            printf(" %8.2fx", res[A_SLAB_LINE].ops_per_sec / res[A_GLIBC].ops_per_sec);
+        } else {
+            printf(" %8.2fx", res[A_SLAB].ops_per_sec / res[A_GLIBC].ops_per_sec);
+        }
+        for (int k = 0; k < nalloc; k++) printf(" %10.1f MB", res[k].peak_rss_mb);
+        printf("  %s\n", ok ? "OK" : "FAIL");
+        if (nt == max_threads) break;
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--steady | --xthread | --burst | --false-sharing | --all] [options]\n",
+           prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --threads N                  Maximum threads (default %d)\n", NUM_CORES);
+    printf("  --placement spread|compact   Thread placement (default spread)\n");
+    printf("  --ops M                      Operations per thread (default %d)\n", DEFAULT_OPS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    int max_threads = NUM_CORES;
+    placement_t placement = PLACE_SPREAD;
+    long ops = DEFAULT_OPS;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            max_threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--placement") == 0) {
+            placement = strcmp(argv[i + 1], "compact") == 0 ? PLACE_COMPACT : PLACE_SPREAD;
+        } else if (strcmp(argv[i], "--ops") == 0) {
+            ops = atol(argv[i + 1]);
+        }
+    }
+    if (max_threads < 1 || max_threads > MAX_THREADS || ops < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("=== Allocator Benchmark: glibc malloc vs per-thread slab ===\n");
+    printf("Ops per thread: %ld, slab: %d KB slabs, %d size classes (16..%d B)\n", ops,
+           SLAB_SIZE / 1024, NUM_CLASSES, MAX_SMALL_SIZE);
+
+    if (strcmp(mode, "--steady") == 0) {
+        run_scenario(S_STEADY, max_threads, placement, ops);
+    } else if (strcmp(mode, "--xthread") == 0) {
+        if (max_threads < 2) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        run_scenario(S_XTHREAD, max_threads, placement, ops);
+    } else if (strcmp(mode, "--burst") == 0) {
+        run_scenario(S_BURST, max_threads, placement, ops);
+    } else if (strcmp(mode, "--false-sharing") == 0) {
+        run_scenario(S_FALSE_SHARING, max_threads, placement, ops);
+    } else if (strcmp(mode, "--all") == 0) {
+        run_scenario(S_STEADY, max_threads, placement, ops);
+        if (max_threads >= 2) {
+            run_scenario(S_XTHREAD, max_threads, PLACE_SPREAD, ops);
+            run_scenario(S_XTHREAD, max_threads, PLACE_COMPACT, ops);
+        }
+        run_scenario(S_BURST, max_threads, placement, ops);
+        run_scenario(S_FALSE_SHARING, max_threads, placement, ops);
+
+        printf("\n=== Analysis ===\n");
+        printf("- steady: the slab fast path is a pointer pop with no locking or header\n");
+        printf("  bookkeeping; glibc's tcache is close for small sizes but falls back to\n");
+        printf("  its arena for the larger classes\n");
+        printf("- xthread: glibc returns remote frees through the owning arena's lock,\n");
+        printf("  the slab pushes them with one CAS and the owner reclaims a whole list\n");
+        printf("  at once; compact placement keeps the freed lines in the shared L1/L2\n");
+        printf("- burst: peak RSS shows retention - slabs are never returned to the OS\n");
+        printf("- false-sharing: packed %d-byte objects from one thread share lines, so\n",
+               FS_OBJECT_SIZE);
+        printf("  writers on different cores ping-pong them; slab-line trades memory\n");
+        printf("  for one object per line\n");
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
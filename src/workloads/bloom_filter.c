@@ -0,0 +1,457 @@
+/*
+ * bloom_filter.c - 缓存行分块 Bloom filter 与批量预取查询
+ *
+ * 放在存储前面的 Bloom filter 通常远大于 L3。经典 k-hash 过滤器
+ * 每次查询访问 k 个随机缓存行（负查询平均在前 1-2 个 0 位退出），
+ * 分块过滤器把一个 key 的所有位限制在一个块内，只访问一个缓存行。
+ *
+ * 三种过滤器（每 key 10 bit）：
+ * 1. classic   k=7，位置 g_i = h1 + i*h2 分布在整个位数组
+ * 2. blocked   64 字节块 = 8 个 64 位字，每个字置 1 位（k=8），
+ *              AVX2 用 mullo + sllv 生成 512 位掩码，两次 vptest 判断
+ * 3. split     32 字节块 = 8 个 32 位字，每个字置 1 位（k=8），
+ *              整个块就是一个 YMM 寄存器（寄存器分块）
+ *
+ * 查询接口：
+ *   probe        单个 key：哈希 -> 访存 -> 判断，一次一条依赖链
+ *   probe_batch  一批 key：全部哈希并预取所在缓存行，再逐个判断，
+ *                使 16 个缓存缺失并行
+ *
+ * 编译: gcc -O2 -pthread -o bloom_filter bloom_filter.c
+ * 运行: ./bloom_filter [--throughput | --smt | --all] [--max-mb N]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define MIN_FILTER_BYTES (256 * 1024)        // 256KB: L2 内
+#define DEFAULT_MAX_MB 64                    // 256KB, 4MB, 64MB
+#define SIZE_STEP 16
+#define BITS_PER_KEY 10
+#define CLASSIC_K 7                          // 10 bit/key 时的最优 k
+#define BATCH 16
+#define PROBES (1 << 21)                     // 每线程每次测量的查询数
+#define FN_CHECK_KEYS (1 << 20)              // 假阴性检查的 key 数上限
+#define NEGATIVE_BASE (1ULL << 40)           // 负查询 key 从这里开始，不与插入 key 重叠
+
+typedef enum {
+    BF_CLASSIC,
+    BF_BLOCKED,
+    BF_SPLIT,
+    BF_NUM_TYPES
+} bf_type_t;
+
+static const char *bf_type_names[BF_NUM_TYPES] = {"classic", "blocked", "split"};
+
+typedef struct {
+    bf_type_t type;
+    uint64_t *words;     // 64 字节对齐
+    uint64_t nbits;
+    uint64_t nblocks;    // blocked: 64 字节块数，split: 32 字节块数
+} bloom_t;
+
+// Parquet split block Bloom filter 使用的 8 个奇数乘子
+static const uint32_t SALT[8] CACHE_ALIGNED = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+static int has_avx2;
+
+// ---------------------------------------------------------------
+// 哈希与定位
+// ---------------------------------------------------------------
+
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// 把 64 位哈希映射到 [0, n)，避免取模除法
+static inline uint64_t fastrange64(uint64_t h, uint64_t n) {
+    return (uint64_t)(((__uint128_t)h * n) >> 64);
+}
+
+static inline uint64_t classic_step(uint64_t h) {
+    return ((h >> 32) | (h << 32)) | 1;
+}
+
+// 块下标取哈希高位，块内位置取低 32 位
+static inline const uint64_t *blocked_addr(const bloom_t *bf, uint64_t h) {
+    return bf->words + fastrange64(h, bf->nblocks) * 8;
+}
+
+static inline const uint32_t *split_addr(const bloom_t *bf, uint64_t h) {
+    return (const uint32_t *)bf->words + fastrange64(h, bf->nblocks) * 8;
+}
+
+// ---------------------------------------------------------------
+// 插入（标量，与查询的 SIMD 掩码逐位一致）
+// ---------------------------------------------------------------
+
+static void bloom_insert(bloom_t *bf, uint64_t key) {
+    uint64_t h = mix64(key);
+
+    if (bf->type == BF_CLASSIC) {
+        uint64_t g = h, step = classic_step(h);
+        for (int i = 0; i < CLASSIC_K; i++) {
+            uint64_t pos = fastrange64(g, bf->nbits);
+            bf->words[pos >> 6] |= 1ULL << (pos & 63);
+            g += step;
+        }
+    } else if (bf->type == BF_BLOCKED) {
+        uint64_t *blk = (uint64_t *)blocked_addr(bf, h);
+        for (int i = 0; i < 8; i++) {
+            blk[i] |= 1ULL << (((uint32_t)h * SALT[i]) >> 26);
+        }
+    } else {
+        uint32_t *blk = (uint32_t *)split_addr(bf, h);
+        for (int i = 0; i < 8; i++) {
+            blk[i] |= 1U << (((uint32_t)h * SALT[i]) >> 27);
+        }
+    }
+}
+
+// ---------------------------------------------------------------
+// 位测试：返回 1 表示可能存在
+// ---------------------------------------------------------------
+
+static inline int classic_test(const bloom_t *bf, uint64_t h) {
+    uint64_t g = h, step = classic_step(h);
+    for (int i = 0; i < CLASSIC_K; i++) {
+        uint64_t pos = fastrange64(g, bf->nbits);
+        if (!(bf->words[pos >> 6] & (1ULL << (pos & 63)))) return 0;
+        g += step;
+    }
+    return 1;
+}
+
+static inline void classic_prefetch(const bloom_t *bf, uint64_t h) {
+    uint64_t g = h, step = classic_step(h);
+    for (int i = 0; i < CLASSIC_K; i++) {
+        PREFETCH_T0(&bf->words[fastrange64(g, bf->nbits) >> 6]);
+        g += step;
+    }
+}
+
+static inline int blocked_test_scalar(const bloom_t *bf, uint64_t h) {
+    const uint64_t *blk = blocked_addr(bf, h);
+    uint64_t missing = 0;
+    for (int i = 0; i < 8; i++) {
+        missing |= ~blk[i] & (1ULL << (((uint32_t)h * SALT[i]) >> 26));
+    }
+    return missing == 0;
+}
+
+__attribute__((target("avx2")))
+static inline int blocked_test_avx2(const bloom_t *bf, uint64_t h) {
+    const uint64_t *blk = blocked_addr(bf, h);
+    __m256i salt = _mm256_load_si256((const __m256i *)SALT);
+    __m256i shift = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)h), salt), 26);
+    __m256i one = _mm256_set1_epi64x(1);
+    __m256i lo = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shift)));
+    __m256i hi = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shift, 1)));
+    // testc: (~block & mask) == 0
+    return _mm256_testc_si256(_mm256_load_si256((const __m256i *)blk), lo) &
+           _mm256_testc_si256(_mm256_load_si256((const __m256i *)(blk + 4)), hi);
+}
+
+static inline int split_test_scalar(const bloom_t *bf, uint64_t h) {
+    const uint32_t *blk = split_addr(bf, h);
+    uint32_t missing = 0;
+    for (int i = 0; i < 8; i++) {
+        missing |= ~blk[i] & (1U << (((uint32_t)h * SALT[i]) >> 27));
+    }
+    return missing == 0;
+}
+
+__attribute__((target("avx2")))
+static inline int split_test_avx2(const bloom_t *bf, uint64_t h) {
+    __m256i salt = _mm256_load_si256((const __m256i *)SALT);
+    __m256i shift = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)h), salt), 27);
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), shift);
+    return _mm256_testc_si256(_mm256_load_si256((const __m256i *)split_addr(bf, h)), mask);
+}
+
+#define BLOCK_PREFETCH(bf, h) PREFETCH_T0(blocked_addr(bf, h))
+#define SPLIT_PREFETCH(bf, h) PREFETCH_T0(split_addr(bf, h))
+
+// ---------------------------------------------------------------
+// 查询接口：每个变体生成 probe 和 probe_batch
+// ---------------------------------------------------------------
+
+#define DEFINE_PROBES(name, ATTR, TEST, PREFETCH) \
+ATTR static int name##_probe(const bloom_t *bf, uint64_t key) { \
+    return TEST(bf, mix64(key)); \
+} \
+ATTR static int name##_probe_batch(const bloom_t *bf, const uint64_t *keys, int n, \
+                                   uint8_t *out) { \
+    uint64_t h[BATCH]; \
+    int hits = 0; \
+    for (int q = 0; q < n; q++) { \
+        h[q] = mix64(keys[q]); \
+        PREFETCH(bf, h[q]); \
+    } \
+    for (int q = 0; q < n; q++) { \
+        out[q] = (uint8_t)TEST(bf, h[q]); \
+        hits += out[q]; \
+    } \
+    return hits; \
+}
+
+DEFINE_PROBES(classic, , classic_test, classic_prefetch)
+DEFINE_PROBES(blocked_scalar, , blocked_test_scalar, BLOCK_PREFETCH)
+DEFINE_PROBES(blocked_avx2, __attribute__((target("avx2"))), blocked_test_avx2, BLOCK_PREFETCH)
+DEFINE_PROBES(split_scalar, , split_test_scalar, SPLIT_PREFETCH)
+DEFINE_PROBES(split_avx2, __attribute__((target("avx2"))), split_test_avx2, SPLIT_PREFETCH)
+
+typedef struct {
+    int (*probe)(const bloom_t *bf, uint64_t key);
+    // n <= BATCH，out[i] 为第 i 个 key 的结果，返回命中数
+    int (*probe_batch)(const bloom_t *bf, const uint64_t *keys, int n, uint8_t *out);
+} bloom_ops_t;
+
+static bloom_ops_t bloom_ops(bf_type_t type) {
+    bloom_ops_t ops;
+    if (type == BF_CLASSIC) {
+        ops.probe = classic_probe;
+        ops.probe_batch = classic_probe_batch;
+    } else if (type == BF_BLOCKED) {
+        ops.probe = has_avx2 ? blocked_avx2_probe : blocked_scalar_probe;
+        ops.probe_batch = has_avx2 ? blocked_avx2_probe_batch : blocked_scalar_probe_batch;
+    } else {
+        ops.probe = has_avx2 ? split_avx2_probe : split_scalar_probe;
+        ops.probe_batch = has_avx2 ? split_avx2_probe_batch : split_scalar_probe_batch;
+    }
+    return ops;
+}
+
+static int bloom_create(bloom_t *bf, bf_type_t type, size_t bytes) {
+    bf->type = type;
+    bf->words = aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (!bf->words) return -1;
+    memset(bf->words, 0, bytes);
+    bf->nbits = bytes * 8;
+    bf->nblocks = type == BF_SPLIT ? bytes / 32 : bytes / 64;
+    return 0;
+}
+
+// ---------------------------------------------------------------
+// 多线程查询
+// ---------------------------------------------------------------
+
+typedef struct {
+    int cpu_id;
+    const bloom_t *bf;
+    bloom_ops_t ops;
+    int batched;
+    uint64_t first_key;
+    volatile int *ready;
+    volatile int *start;
+    uint64_t hits;
+    double elapsed_time;
+} thread_arg_t;
+
+static uint64_t probe_range(const bloom_t *bf, bloom_ops_t ops, int batched,
+                            uint64_t first, size_t n) {
+    uint64_t hits = 0;
+
+    if (batched) {
+        uint64_t keys[BATCH];
+        uint8_t out[BATCH];
+        for (size_t i = 0; i < n; i += BATCH) {
+            int cnt = n - i < BATCH ? (int)(n - i) : BATCH;
+            for (int q = 0; q < cnt; q++) keys[q] = first + i + q;
+            hits += ops.probe_batch(bf, keys, cnt, out);
+        }
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            hits += ops.probe(bf, first + i);
+        }
+    }
+    return hits;
+}
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    double start = get_time_sec();
+    targ->hits = probe_range(targ->bf, targ->ops, targ->batched, targ->first_key, PROBES);
+    targ->elapsed_time = get_time_sec() - start;
+
+    return NULL;
+}
+
+// 返回所有线程合计的 Mprobes/s；fpr 为负查询命中率
+static double run_probes(const bloom_t *bf, int batched, int nthreads, placement_t placement,
+                         double *fpr) {
+    pthread_t threads[2];
+    thread_arg_t args[2];
+    volatile int ready = 0;
+    volatile int start = 0;
+
+    for (int t = 0; t < nthreads; t++) {
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, placement), .bf = bf, .ops = bloom_ops(bf->type),
+            .batched = batched, .first_key = NEGATIVE_BASE + (uint64_t)t * PROBES,
+            .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < nthreads) usleep(100);
+
+    double wall_start = get_time_sec();
+    start = 1;
+    uint64_t hits = 0;
+    for (int t = 0; t < nthreads; t++) {
+        pthread_join(threads[t], NULL);
+        hits += args[t].hits;
+    }
+    double wall_elapsed = get_time_sec() - wall_start;
+
+    if (fpr) *fpr = (double)hits / ((double)nthreads * PROBES);
+    return (double)nthreads * PROBES / wall_elapsed / 1e6;
+}
+
+// 插入的 key 必须全部命中（单查询和批量两条路径都检查）
+static int check_no_false_negatives(const bloom_t *bf, size_t nkeys) {
+    bloom_ops_t ops = bloom_ops(bf->type);
+    size_t n = nkeys < FN_CHECK_KEYS ? nkeys : FN_CHECK_KEYS;
+    return probe_range(bf, ops, 0, 0, n) == n && probe_range(bf, ops, 1, 0, n) == n;
+}
+
+static void print_size(size_t bytes) {
+    if (bytes >= 1024 * 1024) {
+        printf("%5zuMB", bytes / (1024 * 1024));
+    } else {
+        printf("%5zuKB", bytes / 1024);
+    }
+}
+
+// ---------------------------------------------------------------
+// 测试
+// ---------------------------------------------------------------
+
+static void run_size(size_t bytes, int throughput, int smt) {
+    size_t nkeys = bytes * 8 / BITS_PER_KEY;
+
+    for (int type = 0; type < BF_NUM_TYPES; type++) {
+        bloom_t bf;
+        if (bloom_create(&bf, (bf_type_t)type, bytes) != 0) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+        for (size_t i = 0; i < nkeys; i++) bloom_insert(&bf, i);
+        int ok = check_no_false_negatives(&bf, nkeys);
+
+        print_size(bytes);
+        printf(" %-8s", bf_type_names[type]);
+        if (throughput) {
+            double fpr;
+            double single = run_probes(&bf, 0, 1, PLACE_SPREAD, &fpr);
+            double batched = run_probes(&bf, 1, 1, PLACE_SPREAD, NULL);
+            printf(" %7.3f%% %12.1f %12.1f %8.2fx", fpr * 100, single, batched,
+                   batched / single);
+        }
+        if (smt) {
+            double one = run_probes(&bf, 1, 1, PLACE_SPREAD, NULL);
+            double same = run_probes(&bf, 1, 2, PLACE_COMPACT, NULL);
+            double diff = run_probes(&bf, 1, 2, PLACE_SPREAD, NULL);
+            printf(" %10.1f %12.1f %12.1f %9.2f", one, same, diff, same / diff);
+        }
+        printf("  %s\n", ok ? "OK" : "FALSE-NEG");
+        fflush(stdout);
+        free(bf.words);
+    }
+}
+
+static void run_sweep(size_t max_bytes, int throughput, int smt) {
+    if (throughput) {
+        printf("\n=== Single Thread: Throughput (Mprobes/s) and False Positives ===\n");
+        printf("%-7s %-8s %8s %12s %12s %9s  Check\n",
+               "Filter", "Variant", "FPR", "single", "batched", "Speedup");
+    } else {
+        printf("\n=== SMT Placement: Batched Probes, Aggregate Mprobes/s ===\n");
+        printf("%-7s %-8s %10s %12s %12s %9s  Check\n",
+               "Filter", "Variant", "1 thread", "same-core", "diff-core", "same/diff");
+    }
+    printf("------------------------------------------------------------------------\n");
+
+    for (size_t bytes = MIN_FILTER_BYTES; bytes <= max_bytes; bytes *= SIZE_STEP) {
+        run_size(bytes, throughput, smt);
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--throughput | --smt | --all] [--max-mb N]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --throughput  Single thread: FPR, single vs batched probes\n");
+    printf("  --smt         Batched probes: 1 thread vs 2 threads same-core / diff-core\n");
+    printf("  --all         Both tables\n");
+    printf("  --max-mb N    Largest filter in MB (default %d, sizes step x%d from 256KB)\n",
+           DEFAULT_MAX_MB, SIZE_STEP);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    size_t max_bytes = (size_t)DEFAULT_MAX_MB * 1024 * 1024;
+
+    if (argc > 3 && strcmp(argv[2], "--max-mb") == 0) {
+        max_bytes = strtoull(argv[3], NULL, 0) * 1024 * 1024;
+    }
+    if (max_bytes < MIN_FILTER_BYTES) {
+        fprintf(stderr, "Invalid --max-mb: must be at least 1\n");
+        return 1;
+    }
+
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2");
+
+    printf("=== Blocked Bloom Filter Benchmark ===\n");
+    printf("Bits per key: %d, classic k=%d, blocked/split k=8\n", BITS_PER_KEY, CLASSIC_K);
+    printf("Bit test: %s, batch size: %d, probes per thread: %d (all negative)\n",
+           has_avx2 ? "AVX2" : "scalar", BATCH, PROBES);
+
+    if (strcmp(mode, "--throughput") == 0) {
+        run_sweep(max_bytes, 1, 0);
+    } else if (strcmp(mode, "--smt") == 0) {
+        run_sweep(max_bytes, 0, 1);
+    } else if (strcmp(mode, "--all") == 0) {
+        run_sweep(max_bytes, 1, 0);
+        run_sweep(max_bytes, 0, 1);
+
+        printf("\n=== Analysis ===\n");
+        printf("- classic touches up to k lines per probe; blocked/split touch one,\n");
+        printf("  at the cost of a somewhat higher FPR for the same bits per key\n");
+        printf("- Batched probes overlap %d misses: little gain while the filter fits\n", BATCH);
+        printf("  in L2, large gain once it spills out of L3\n");
+        printf("- same-core: two threads share one core's miss buffers; if batching\n");
+        printf("  already fills them, same/diff drops well below 1\n");
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
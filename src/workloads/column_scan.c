@@ -0,0 +1,810 @@
+/*
+ * column_scan.c - SIMD 列扫描与谓词求值
+ *
+ * sequential_prefetch.c 的 sum += array[i] 只有一条依赖链，谓词也不会被向量化。
+ * 分析型查询的扫描是 WHERE col > x AND col < y，然后输出位图或选择向量，
+ * 或者先解码位压缩列。本测试比较各指令集下这些内核离内存带宽有多近。
+ *
+ * 内核（u32 列，值 < 2^31）：
+ *   count    只计数匹配的行（过滤 + 聚合）
+ *   bitmap   每行 1 位的结果位图（movemask / AVX-512 掩码寄存器）
+ *   selvec   匹配行号数组（SSE pshufb / AVX2 vpermd 查表左压缩，AVX-512 vpcompressd）
+ *   unpack   b 位压缩列（b = 1..32）解码并求值谓词；8/16 个值的起点总是字节对齐，
+ *            每个通道用 gather 读入包含自己那 b 位的 4/8 字节再移位、掩码
+ *
+ * 指令集：scalar（无分支）、SSE4.1、AVX2、AVX-512（运行时检测）。
+ * 列存放在堆内存或 mmap 的文件中（页缓存），单线程与多线程。
+ * 报告输入 GB/s 以及 tuples/cycle（周期来源见 common/freq_tracker.h）。
+ *
+ * 编译: gcc -O2 -pthread -o column_scan column_scan.c
+ * 运行: ./column_scan [--filter | --mmap | --unpack | --all] [--threads N]
+ *                     [--selectivity P] [--file PATH]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+#include "../common/freq_tracker.h"
+
+// 配置参数
+#define NUM_TUPLES (64 * 1024 * 1024)     // 256MB u32 列
+#define CHUNK_ALIGN 1024                  // 线程划分粒度（元组）
+#define DEFAULT_SELECTIVITY 50
+#define DEFAULT_FILE "/tmp/column_scan.bin"
+#define PACK_PAD 64                       // 压缩列尾部填充，gather 可以越过最后一个值
+#define MAX_THREADS NUM_HW_THREADS
+
+typedef enum { I_SCALAR, I_SSE, I_AVX2, I_AVX512, NUM_ISAS } isa_t;
+typedef enum { K_COUNT, K_BITMAP, K_SELVEC, NUM_FILTERS } filter_kind_t;
+
+static const char *isa_names[NUM_ISAS] = {"scalar", "sse4.1", "avx2", "avx512"};
+static const char *filter_names[NUM_FILTERS] = {"count", "bitmap", "selvec"};
+
+static int isa_supported[NUM_ISAS];
+
+// 过滤内核：处理 [lo, hi)，返回匹配数；out 为位图（按 32 位字）或选择向量（从 lo 开始写）
+typedef uint64_t (*filter_fn)(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                              void *out);
+// 解码内核：b 位压缩列 [lo, hi) 中满足 x < v < y（无符号）的个数
+typedef uint64_t (*unpack_fn)(const uint8_t *packed, size_t lo, size_t hi, int bits,
+                              uint32_t x, uint32_t y);
+
+// ---------------------------------------------------------------
+// scalar
+// ---------------------------------------------------------------
+
+static uint64_t count_scalar(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                             void *out) {
+    (void)out;
+    uint64_t c = 0;
+    for (size_t i = lo; i < hi; i++) {
+        int32_t v = (int32_t)col[i];
+        c += (v > x) & (v < y);
+    }
+    return c;
+}
+
+static uint64_t bitmap_scalar(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                              void *out) {
+    uint32_t *bm = out;
+    uint64_t c = 0;
+    for (size_t i = lo; i < hi; i += 32) {
+        uint32_t w = 0;
+        for (int j = 0; j < 32; j++) {
+            int32_t v = (int32_t)col[i + j];
+            w |= (uint32_t)((v > x) & (v < y)) << j;
+        }
+        bm[i / 32] = w;
+        c += __builtin_popcount(w);
+    }
+    return c;
+}
+
+static uint64_t selvec_scalar(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                              void *out) {
+    uint32_t *sel = (uint32_t *)out + lo;
+    size_t k = 0;
+    for (size_t i = lo; i < hi; i++) {
+        int32_t v = (int32_t)col[i];
+        sel[k] = (uint32_t)i;
+        k += (v > x) & (v < y);
+    }
+    return k;
+}
+
+static uint64_t unpack_scalar(const uint8_t *packed, size_t lo, size_t hi, int bits,
+                              uint32_t x, uint32_t y) {
+    uint64_t mask = (1ULL << bits) - 1, c = 0;
+    for (size_t i = lo; i < hi; i++) {
+        size_t bit = i * bits;
+        uint64_t w;
+        memcpy(&w, packed + (bit >> 3), sizeof(w));
+        uint32_t v = (uint32_t)((w >> (bit & 7)) & mask);
+        c += (v > x) & (v < y);
+    }
+    return c;
+}
+
+// ---------------------------------------------------------------
+// SSE4.1
+// ---------------------------------------------------------------
+
+static __m128i sse_selvec_lut[16];
+
+__attribute__((target("sse4.1")))
+static inline __m128i sse_match(const uint32_t *p, __m128i vx, __m128i vy) {
+    __m128i v = _mm_load_si128((const __m128i *)p);
+    return _mm_and_si128(_mm_cmpgt_epi32(v, vx), _mm_cmpgt_epi32(vy, v));
+}
+
+__attribute__((target("sse4.1")))
+static uint64_t count_sse(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                          void *out) {
+    (void)out;
+    __m128i vx = _mm_set1_epi32(x), vy = _mm_set1_epi32(y);
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    for (size_t i = lo; i < hi; i += 8) {
+        acc0 = _mm_sub_epi32(acc0, sse_match(col + i, vx, vy));
+        acc1 = _mm_sub_epi32(acc1, sse_match(col + i + 4, vx, vy));
+    }
+    uint32_t lanes[8];
+    _mm_storeu_si128((__m128i *)lanes, acc0);
+    _mm_storeu_si128((__m128i *)(lanes + 4), acc1);
+    uint64_t c = 0;
+    for (int j = 0; j < 8; j++) c += lanes[j];
+    return c;
+}
+
+__attribute__((target("sse4.1,popcnt")))
+static uint64_t bitmap_sse(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                           void *out) {
+    uint32_t *bm = out;
+    __m128i vx = _mm_set1_epi32(x), vy = _mm_set1_epi32(y);
+    uint64_t c = 0;
+    for (size_t i = lo; i < hi; i += 32) {
+        uint32_t w = 0;
+        for (int j = 0; j < 8; j++) {
+            w |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(sse_match(col + i + 4 * j, vx, vy)))
+                 << (4 * j);
+        }
+        bm[i / 32] = w;
+        c += __builtin_popcount(w);
+    }
+    return c;
+}
+
+__attribute__((target("sse4.1,popcnt")))
+static uint64_t selvec_sse(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                           void *out) {
+    uint32_t *sel = (uint32_t *)out + lo;
+    __m128i vx = _mm_set1_epi32(x), vy = _mm_set1_epi32(y);
+    __m128i idx = _mm_add_epi32(_mm_set1_epi32((int)lo), _mm_setr_epi32(0, 1, 2, 3));
+    const __m128i four = _mm_set1_epi32(4);
+    size_t k = 0;
+    for (size_t i = lo; i < hi; i += 4) {
+        int m = _mm_movemask_ps(_mm_castsi128_ps(sse_match(col + i, vx, vy)));
+        _mm_storeu_si128((__m128i *)(sel + k), _mm_shuffle_epi8(idx, sse_selvec_lut[m]));
+        k += __builtin_popcount(m);
+        idx = _mm_add_epi32(idx, four);
+    }
+    return k;
+}
+
+// ---------------------------------------------------------------
+// AVX2
+// ---------------------------------------------------------------
+
+static uint32_t avx2_selvec_lut[256][8];
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_match(const uint32_t *p, __m256i vx, __m256i vy) {
+    __m256i v = _mm256_load_si256((const __m256i *)p);
+    return _mm256_and_si256(_mm256_cmpgt_epi32(v, vx), _mm256_cmpgt_epi32(vy, v));
+}
+
+__attribute__((target("avx2")))
+static uint64_t count_avx2(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                           void *out) {
+    (void)out;
+    __m256i vx = _mm256_set1_epi32(x), vy = _mm256_set1_epi32(y);
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    for (size_t i = lo; i < hi; i += 16) {
+        acc0 = _mm256_sub_epi32(acc0, avx2_match(col + i, vx, vy));
+        acc1 = _mm256_sub_epi32(acc1, avx2_match(col + i + 8, vx, vy));
+    }
+    uint32_t lanes[16];
+    _mm256_storeu_si256((__m256i *)lanes, acc0);
+    _mm256_storeu_si256((__m256i *)(lanes + 8), acc1);
+    uint64_t c = 0;
+    for (int j = 0; j < 16; j++) c += lanes[j];
+    return c;
+}
+
+__attribute__((target("avx2,popcnt")))
+static uint64_t bitmap_avx2(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                            void *out) {
+    uint32_t *bm = out;
+    __m256i vx = _mm256_set1_epi32(x), vy = _mm256_set1_epi32(y);
+    uint64_t c = 0;
+    for (size_t i = lo; i < hi; i += 32) {
+        uint32_t w = 0;
+        for (int j = 0; j < 4; j++) {
+            w |= (uint32_t)_mm256_movemask_ps(
+                     _mm256_castsi256_ps(avx2_match(col + i + 8 * j, vx, vy))) << (8 * j);
+        }
+        bm[i / 32] = w;
+        c += __builtin_popcount(w);
+    }
+    return c;
+}
+
+__attribute__((target("avx2,popcnt")))
+static uint64_t selvec_avx2(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                            void *out) {
+    uint32_t *sel = (uint32_t *)out + lo;
+    __m256i vx = _mm256_set1_epi32(x), vy = _mm256_set1_epi32(y);
+    __m256i idx = _mm256_add_epi32(_mm256_set1_epi32((int)lo),
+                                   _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i eight = _mm256_set1_epi32(8);
+    size_t k = 0;
+    for (size_t i = lo; i < hi; i += 8) {
+        int m = _mm256_movemask_ps(_mm256_castsi256_ps(avx2_match(col + i, vx, vy)));
+        __m256i perm = _mm256_load_si256((const __m256i *)avx2_selvec_lut[m]);
+        _mm256_storeu_si256((__m256i *)(sel + k), _mm256_permutevar8x32_epi32(idx, perm));
+        k += __builtin_popcount(m);
+        idx = _mm256_add_epi32(idx, eight);
+    }
+    return k;
+}
+
+__attribute__((target("avx2,popcnt")))
+static uint64_t unpack_avx2(const uint8_t *packed, size_t lo, size_t hi, int bits,
+                            uint32_t x, uint32_t y) {
+    const __m256i lane_bits = _mm256_mullo_epi32(_mm256_set1_epi32(bits),
+                                                 _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i byte_off = _mm256_srli_epi32(lane_bits, 3);
+    const __m256i shift = _mm256_and_si256(lane_bits, _mm256_set1_epi32(7));
+    const __m256i mask = _mm256_set1_epi32((int)(uint32_t)((1ULL << bits) - 1));
+    // 无符号比较：翻转符号位后用有符号比较
+    const __m256i flip = _mm256_set1_epi32((int)0x80000000u);
+    const __m256i vx = _mm256_set1_epi32((int)(x ^ 0x80000000u));
+    const __m256i vy = _mm256_set1_epi32((int)(y ^ 0x80000000u));
+    uint64_t c = 0;
+
+    for (size_t i = lo; i < hi; i += 8) {
+        const uint8_t *base = packed + i * bits / 8;
+        __m256i v;
+        if (bits <= 25) {
+            // 移位最多 7 位，b + 7 <= 32：一次 32 位读就包含整个值
+            v = _mm256_i32gather_epi32((const int *)base, byte_off, 1);
+            v = _mm256_and_si256(_mm256_srlv_epi32(v, shift), mask);
+        } else {
+            __m256i w0 = _mm256_i32gather_epi64((const long long *)base,
+                                                _mm256_castsi256_si128(byte_off), 1);
+            __m256i w1 = _mm256_i32gather_epi64((const long long *)base,
+                                                _mm256_extracti128_si256(byte_off, 1), 1);
+            w0 = _mm256_srlv_epi64(w0, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shift)));
+            w1 = _mm256_srlv_epi64(w1, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shift, 1)));
+            const __m256i low = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+            v = _mm256_permute2x128_si256(_mm256_permutevar8x32_epi32(w0, low),
+                                          _mm256_permutevar8x32_epi32(w1, low), 0x20);
+            v = _mm256_and_si256(v, mask);
+        }
+        v = _mm256_xor_si256(v, flip);
+        __m256i m = _mm256_and_si256(_mm256_cmpgt_epi32(v, vx), _mm256_cmpgt_epi32(vy, v));
+        c += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+    }
+    return c;
+}
+
+// ---------------------------------------------------------------
+// AVX-512
+// ---------------------------------------------------------------
+
+__attribute__((target("avx512f,popcnt")))
+static inline __mmask16 avx512_match(const uint32_t *p, __m512i vx, __m512i vy) {
+    __m512i v = _mm512_load_si512((const void *)p);
+    return _mm512_cmpgt_epi32_mask(v, vx) & _mm512_cmplt_epi32_mask(v, vy);
+}
+
+__attribute__((target("avx512f,popcnt")))
+static uint64_t count_avx512(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                             void *out) {
+    (void)out;
+    __m512i vx = _mm512_set1_epi32(x), vy = _mm512_set1_epi32(y);
+    uint64_t c = 0;
+    for (size_t i = lo; i < hi; i += 32) {
+        uint32_t m = avx512_match(col + i, vx, vy) |
+                     (uint32_t)avx512_match(col + i + 16, vx, vy) << 16;
+        c += __builtin_popcount(m);
+    }
+    return c;
+}
+
+__attribute__((target("avx512f,popcnt")))
+static uint64_t bitmap_avx512(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                              void *out) {
+    uint32_t *bm = out;
+    __m512i vx = _mm512_set1_epi32(x), vy = _mm512_set1_epi32(y);
+    uint64_t c = 0;
+    for (size_t i = lo; i < hi; i += 32) {
+        uint32_t w = avx512_match(col + i, vx, vy) |
+                     (uint32_t)avx512_match(col + i + 16, vx, vy) << 16;
+        bm[i / 32] = w;
+        c += __builtin_popcount(w);
+    }
+    return c;
+}
+
+__attribute__((target("avx512f,popcnt")))
+static uint64_t selvec_avx512(const uint32_t *col, size_t lo, size_t hi, int32_t x, int32_t y,
+                              void *out) {
+    uint32_t *sel = (uint32_t *)out + lo;
+    __m512i vx = _mm512_set1_epi32(x), vy = _mm512_set1_epi32(y);
+    __m512i idx = _mm512_add_epi32(_mm512_set1_epi32((int)lo),
+                                   _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                                     8, 9, 10, 11, 12, 13, 14, 15));
+    const __m512i sixteen = _mm512_set1_epi32(16);
+    size_t k = 0;
+    for (size_t i = lo; i < hi; i += 16) {
+        __mmask16 m = avx512_match(col + i, vx, vy);
+        _mm512_mask_compressstoreu_epi32(sel + k, m, idx);
+        k += __builtin_popcount(m);
+        idx = _mm512_add_epi32(idx, sixteen);
+    }
+    return k;
+}
+
+__attribute__((target("avx512f,popcnt")))
+static uint64_t unpack_avx512(const uint8_t *packed, size_t lo, size_t hi, int bits,
+                              uint32_t x, uint32_t y) {
+    const __m512i lane_bits = _mm512_mullo_epi32(
+        _mm512_set1_epi32(bits),
+        _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    const __m512i byte_off = _mm512_srli_epi32(lane_bits, 3);
+    const __m512i shift = _mm512_and_si512(lane_bits, _mm512_set1_epi32(7));
+    const __m512i mask = _mm512_set1_epi32((int)(uint32_t)((1ULL << bits) - 1));
+    const __m512i mask64 = _mm512_set1_epi64((long long)((1ULL << bits) - 1));
+    const __m512i vx = _mm512_set1_epi32((int)x), vy = _mm512_set1_epi32((int)y);
+    uint64_t c = 0;
+
+    for (size_t i = lo; i < hi; i += 16) {
+        const uint8_t *base = packed + i * bits / 8;
+        __m512i v;
+        if (bits <= 25) {
+            v = _mm512_i32gather_epi32(byte_off, (const void *)base, 1);
+            v = _mm512_and_si512(_mm512_srlv_epi32(v, shift), mask);
+        } else {
+            __m256i off0 = _mm512_castsi512_si256(byte_off);
+            __m256i off1 = _mm512_extracti64x4_epi64(byte_off, 1);
+            __m512i w0 = _mm512_i32gather_epi64(off0, (const void *)base, 1);
+            __m512i w1 = _mm512_i32gather_epi64(off1, (const void *)base, 1);
+            w0 = _mm512_and_si512(_mm512_srlv_epi64(w0, _mm512_cvtepu32_epi64(
+                                      _mm512_castsi512_si256(shift))), mask64);
+            w1 = _mm512_and_si512(_mm512_srlv_epi64(w1, _mm512_cvtepu32_epi64(
+                                      _mm512_extracti64x4_epi64(shift, 1))), mask64);
+            v = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(w0)),
+                                   _mm512_cvtepi64_epi32(w1), 1);
+        }
+        __mmask16 m = _mm512_cmpgt_epu32_mask(v, vx) & _mm512_cmplt_epu32_mask(v, vy);
+        c += __builtin_popcount(m);
+    }
+    return c;
+}
+
+static const filter_fn filter_table[NUM_FILTERS][NUM_ISAS] = {
+    {count_scalar, count_sse, count_avx2, count_avx512},
+    {bitmap_scalar, bitmap_sse, bitmap_avx2, bitmap_avx512},
+    {selvec_scalar, selvec_sse, selvec_avx2, selvec_avx512},
+};
+
+static const unpack_fn unpack_table[NUM_ISAS] = {
+    unpack_scalar, NULL, unpack_avx2, unpack_avx512
+};
+
+static void init_luts(void) {
+    for (int m = 0; m < 16; m++) {
+        uint8_t bytes[16] = {0};
+        int k = 0;
+        for (int j = 0; j < 4; j++) {
+            if (m & (1 << j)) {
+                for (int b = 0; b < 4; b++) bytes[k * 4 + b] = (uint8_t)(j * 4 + b);
+                k++;
+            }
+        }
+        memcpy(&sse_selvec_lut[m], bytes, sizeof(bytes));
+    }
+    for (int m = 0; m < 256; m++) {
+        int k = 0;
+        for (int j = 0; j < 8; j++) {
+            if (m & (1 << j)) avx2_selvec_lut[m][k++] = j;
+        }
+        while (k < 8) avx2_selvec_lut[m][k++] = 0;
+    }
+}
+
+// ---------------------------------------------------------------
+// 多线程执行
+// ---------------------------------------------------------------
+
+typedef struct {
+    filter_fn filter;         // 二选一
+    unpack_fn unpack;
+    filter_kind_t kind;
+    const uint32_t *col;
+    const uint8_t *packed;
+    int bits;
+    int32_t x, y;             // 过滤谓词
+    uint32_t ux, uy;          // 解码谓词（无符号）
+    void *out;
+    size_t n;
+    int nthreads;
+} scan_job_t;
+
+typedef struct {
+    int cpu_id;
+    int tid;
+    const scan_job_t *job;
+    uint64_t count;
+    uint64_t check;           // 输出内容的校验和（计时之外计算）
+    freq_sample_t fs;
+    volatile int *ready;
+    volatile int *start;
+} thread_arg_t;
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+    const scan_job_t *job = targ->job;
+    size_t per = (job->n / CHUNK_ALIGN + job->nthreads - 1) / job->nthreads * CHUNK_ALIGN;
+    size_t lo = per * targ->tid < job->n ? per * targ->tid : job->n;
+    size_t hi = lo + per < job->n ? lo + per : job->n;
+    freq_tracker_t ft;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    freq_start(&ft, targ->cpu_id);
+    if (job->filter) {
+        targ->count = job->filter(job->col, lo, hi, job->x, job->y, job->out);
+    } else {
+        targ->count = job->unpack(job->packed, lo, hi, job->bits, job->ux, job->uy);
+    }
+    freq_stop(&ft, &targ->fs);
+
+    targ->check = targ->count;
+    if (job->filter && job->kind == K_BITMAP) {
+        const uint32_t *bm = job->out;
+        for (size_t w = lo / 32; w < hi / 32; w++) targ->check += bm[w] * (w + 1);
+    } else if (job->filter && job->kind == K_SELVEC) {
+        const uint32_t *sel = (const uint32_t *)job->out + lo;
+        for (size_t k = 0; k < targ->count; k++) targ->check += sel[k] * (k + 1);
+    }
+    return NULL;
+}
+
+typedef struct {
+    double gbps;
+    double tuples_per_cycle;
+    uint64_t check;
+    const char *cycle_source;
+} scan_result_t;
+
+static scan_result_t run_job(const scan_job_t *job, double bytes) {
+    pthread_t threads[MAX_THREADS];
+    thread_arg_t args[MAX_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+    scan_result_t r = {0, 0, 0, ""};
+
+    for (int t = 0; t < job->nthreads; t++) {
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, PLACE_SPREAD), .tid = t, .job = job,
+            .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < job->nthreads) usleep(100);
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int t = 0; t < job->nthreads; t++) pthread_join(threads[t], NULL);
+    double elapsed = get_time_sec() - t0;
+
+    double max_cycles = 0;
+    for (int t = 0; t < job->nthreads; t++) {
+        r.check += args[t].check;
+        if (args[t].fs.cycles > max_cycles) max_cycles = args[t].fs.cycles;
+    }
+    r.gbps = bytes / elapsed / 1e9;
+    r.tuples_per_cycle = max_cycles > 0 ? job->n / max_cycles : 0;
+    r.cycle_source = args[0].fs.source;
+    return r;
+}
+
+static void print_cell(const scan_result_t *r) {
+    printf(" %7.2f (%5.2f)", r->gbps, r->tuples_per_cycle);
+}
+
+static void print_na(void) {
+    printf(" %15s", "-");
+}
+
+// ---------------------------------------------------------------
+// 测试
+// ---------------------------------------------------------------
+
+static void predicate(int selectivity, int32_t *x, int32_t *y) {
+    double lo = 0.25 * 2147483648.0;
+    double hi = lo + selectivity / 100.0 * 2147483648.0;
+    *x = (int32_t)lo;
+    *y = hi > 2147483647.0 ? INT32_MAX : (int32_t)hi;
+}
+
+static void fill_column(uint32_t *col, size_t n) {
+    uint64_t s = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < n; i++) {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        col[i] = (uint32_t)(s >> 33);
+    }
+}
+
+static int run_filters(const uint32_t *col, int nthreads, int selectivity) {
+    int32_t x, y;
+    predicate(selectivity, &x, &y);
+    uint32_t *out = aligned_alloc(CACHE_LINE_SIZE, (NUM_TUPLES + 64) * sizeof(uint32_t));
+    if (!out) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    int counts[] = {1, nthreads};
+    for (int c = 0; c < (nthreads > 1 ? 2 : 1); c++) {
+        printf("\n=== Filter kernels: %d x u32 (%d MB), %d < col < %d (~%d%%), %d thread%s ===\n",
+               NUM_TUPLES, (int)(NUM_TUPLES * sizeof(uint32_t) >> 20), x, y, selectivity,
+               counts[c], counts[c] > 1 ? "s" : "");
+        printf("Input GB/s (tuples/cycle)\n");
+        printf("%-8s", "Kernel");
+        for (int i = 0; i < NUM_ISAS; i++) printf(" %15s", isa_names[i]);
+        printf("  Check\n");
+        printf("-------------------------------------------------------------------------------\n");
+
+        const char *source = "";
+        for (int k = 0; k < NUM_FILTERS; k++) {
+            uint64_t ref = 0;
+            int ok = 1;
+            printf("%-8s", filter_names[k]);
+            for (int i = 0; i < NUM_ISAS; i++) {
+                if (!isa_supported[i]) {
+                    print_na();
+                    continue;
+                }
+                scan_job_t job = {
+                    .filter = filter_table[k][i], .kind = (filter_kind_t)k, .col = col,
+                    .x = x, .y = y, .out = out, .n = NUM_TUPLES, .nthreads = counts[c]
+                };
+                scan_result_t r = run_job(&job, (double)NUM_TUPLES * sizeof(uint32_t));
+                if (i == I_SCALAR) ref = r.check;
+                ok &= r.check == ref;
+                source = r.cycle_source;
+                print_cell(&r);
+                fflush(stdout);
+            }
+            printf("  %s\n", ok ? "OK" : "MISMATCH");
+        }
+        printf("Cycles: %s\n", source);
+    }
+
+    free(out);
+    return 0;
+}
+
+static int best_isa(void) {
+    for (int i = NUM_ISAS - 1; i > 0; i--) {
+        if (isa_supported[i]) return i;
+    }
+    return I_SCALAR;
+}
+
+static int run_mmap(const uint32_t *col, int nthreads, int selectivity, const char *path) {
+    int32_t x, y;
+    predicate(selectivity, &x, &y);
+    size_t bytes = (size_t)NUM_TUPLES * sizeof(uint32_t);
+    int isa = best_isa();
+
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(col, 1, bytes, f) != bytes) {
+        perror("Failed to write column file");
+        if (f) fclose(f);
+        return 1;
+    }
+    fclose(f);
+
+    printf("\n=== Column source: heap vs mmap'd file (%s), count kernel, %s ===\n", path,
+           isa_names[isa]);
+    printf("Input GB/s (tuples/cycle); first touch maps every page from the page cache\n");
+    printf("%-18s %15s %15s\n", "Source", "1 thread", "N threads");
+    printf("----------------------------------------------------\n");
+
+    int counts[] = {1, nthreads};
+    const char *rows[] = {"heap", "mmap first touch", "mmap warm"};
+    uint64_t ref = 0;
+    int ok = 1;
+    for (int row = 0; row < 3; row++) {
+        printf("%-18s", rows[row]);
+        for (int c = 0; c < 2; c++) {
+            const uint32_t *src = col;
+            void *map = NULL;
+            int fd = -1;
+            if (row > 0) {
+                fd = open(path, O_RDONLY);
+                map = fd < 0 ? MAP_FAILED : mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+                if (map == MAP_FAILED) {
+                    perror("mmap failed");
+                    if (fd >= 0) close(fd);
+                    return 1;
+                }
+                src = map;
+            }
+            scan_job_t job = {
+                .filter = filter_table[K_COUNT][isa], .kind = K_COUNT, .col = src,
+                .x = x, .y = y, .n = NUM_TUPLES, .nthreads = counts[c]
+            };
+            if (row == 2) run_job(&job, bytes);   // 先建立映射
+            scan_result_t r = run_job(&job, bytes);
+            if (row == 0 && c == 0) ref = r.check;
+            ok &= r.check == ref;
+            print_cell(&r);
+            fflush(stdout);
+            if (map) {
+                munmap(map, bytes);
+                close(fd);
+            }
+        }
+        printf("\n");
+    }
+    printf("Check: %s (N = %d threads)\n", ok ? "OK" : "MISMATCH", nthreads);
+    unlink(path);
+    return 0;
+}
+
+static int run_unpack(const uint32_t *col, int nthreads) {
+    static const int widths[] = {1, 2, 3, 4, 5, 7, 8, 11, 12, 16, 17, 21, 24, 25, 28, 31, 32};
+    size_t max_bytes = (size_t)NUM_TUPLES * 4 + PACK_PAD;
+    uint8_t *packed = aligned_alloc(CACHE_LINE_SIZE, max_bytes);
+    if (!packed) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    printf("\n=== Bit-packed decode + filter: %d values, %d thread%s ===\n", NUM_TUPLES,
+           nthreads, nthreads > 1 ? "s" : "");
+    printf("Packed-input GB/s (tuples/cycle); predicate keeps the middle half of [0, 2^b)\n");
+    printf("%-6s %10s", "Bits", "Packed MB");
+    for (int i = 0; i < NUM_ISAS; i++) {
+        if (unpack_table[i]) printf(" %15s", isa_names[i]);
+    }
+    printf("  Check\n");
+    printf("---------------------------------------------------------------------------\n");
+
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        int bits = widths[w];
+        uint64_t mask = (1ULL << bits) - 1;
+        size_t bytes = (size_t)NUM_TUPLES * bits / 8;
+
+        memset(packed, 0, bytes + PACK_PAD);
+        for (size_t i = 0; i < NUM_TUPLES; i++) {
+            size_t bit = i * bits;
+            uint64_t v = ((uint64_t)col[i] * 2 + (i & 1)) & mask, word;
+            memcpy(&word, packed + (bit >> 3), sizeof(word));
+            word |= v << (bit & 7);
+            memcpy(packed + (bit >> 3), &word, sizeof(word));
+        }
+        uint32_t ux = (uint32_t)(mask / 4), uy = (uint32_t)(mask / 4 * 3);
+
+        printf("%-6d %10.1f", bits, bytes / (1024.0 * 1024.0));
+        uint64_t ref = 0;
+        int ok = 1;
+        for (int i = 0; i < NUM_ISAS; i++) {
+            if (!unpack_table[i]) continue;
+            if (!isa_supported[i]) {
+                print_na();
+                continue;
+            }
+            scan_job_t job = {
+                .unpack = unpack_table[i], .packed = packed, .bits = bits,
+                .ux = ux, .uy = uy, .n = NUM_TUPLES, .nthreads = nthreads
+            };
+            scan_result_t r = run_job(&job, (double)bytes);
+            if (i == I_SCALAR) ref = r.check;
+            ok &= r.check == ref;
+            print_cell(&r);
+            fflush(stdout);
+        }
+        printf("  %s\n", ok ? "OK" : "MISMATCH");
+    }
+
+    free(packed);
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--filter | --mmap | --unpack | --all] [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --threads N       Threads for the multi-threaded runs (default %d)\n", NUM_CORES);
+    printf("  --selectivity P   Percent of rows passing the filter (default %d)\n",
+           DEFAULT_SELECTIVITY);
+    printf("  --file PATH       Column file for --mmap (default %s)\n", DEFAULT_FILE);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    int nthreads = NUM_CORES;
+    int selectivity = DEFAULT_SELECTIVITY;
+    const char *path = DEFAULT_FILE;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            nthreads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--selectivity") == 0) {
+            selectivity = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--file") == 0) {
+            path = argv[i + 1];
+        }
+    }
+    if (nthreads < 1 || nthreads > MAX_THREADS || selectivity < 0 || selectivity > 100) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    __builtin_cpu_init();
+    isa_supported[I_SCALAR] = 1;
+    isa_supported[I_SSE] = __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt");
+    isa_supported[I_AVX2] = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    isa_supported[I_AVX512] = __builtin_cpu_supports("avx512f") &&
+                              __builtin_cpu_supports("popcnt");
+    init_luts();
+
+    uint32_t *col = aligned_alloc(CACHE_LINE_SIZE, (size_t)NUM_TUPLES * sizeof(uint32_t));
+    if (!col) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+    fill_column(col, NUM_TUPLES);
+
+    printf("=== Column Scan Benchmark: SIMD Predicates ===\n");
+    printf("TSC frequency: %.2f GHz, ISAs:", freq_init());
+    for (int i = 0; i < NUM_ISAS; i++) {
+        if (isa_supported[i]) printf(" %s", isa_names[i]);
+    }
+    printf("\n");
+
+    int ret = 0;
+    if (strcmp(mode, "--filter") == 0) {
+        ret = run_filters(col, nthreads, selectivity);
+    } else if (strcmp(mode, "--mmap") == 0) {
+        ret = run_mmap(col, nthreads, selectivity, path);
+    } else if (strcmp(mode, "--unpack") == 0) {
+        ret = run_unpack(col, 1);
+        if (ret == 0 && nthreads > 1) ret = run_unpack(col, nthreads);
+    } else if (strcmp(mode, "--all") == 0) {
+        ret = run_filters(col, nthreads, selectivity);
+        if (ret == 0) ret = run_mmap(col, nthreads, selectivity, path);
+        if (ret == 0) ret = run_unpack(col, 1);
+        if (ret == 0) {
+            printf("\n=== Analysis ===\n");
+            printf("- count: SIMD turns the predicate into 2 compares + and per vector; one\n");
+            printf("  thread is usually core bound with SSE and close to its load bandwidth\n");
+            printf("  with AVX2/AVX-512, more threads are needed to reach DRAM bandwidth\n");
+            printf("- bitmap output is 1/32 of the input and costs almost nothing extra\n");
+            printf("- selvec writes up to 4 bytes per input tuple: at 50%% selectivity the\n");
+            printf("  output stream is half the input, and the LUT/compress step adds work\n");
+            printf("- mmap first touch pays a page fault per 4KB page even from the page\n");
+            printf("  cache; warm mappings scan as fast as heap memory\n");
+            printf("- unpack: narrow widths read fewer bytes but gather-based decode is\n");
+            printf("  core bound, so tuples/cycle, not GB/s, is the limit; widths > 25 need\n");
+            printf("  two 64-bit gathers per vector\n");
+        }
+    } else {
+        print_usage(argv[0]);
+        ret = 1;
+    }
+
+    free(col);
+    return ret;
+}
@@ -0,0 +1,585 @@
+/*
+ * compressed_scan.c - 压缩数组扫描：用计算换带宽
+ *
+ * sequential_prefetch.c 和 latency_hiding.c 的内存线程都在等数据，核心的 ALU
+ * 大部分时间空闲。如果数组是压缩存放的，每字节内存流量能带来更多的值，
+ * 解码的计算可以由同核心的超线程分担。本测试比较原始数组与三种压缩格式
+ * 的扫描吞吐（对所有值求和，模 2^32）：
+ *
+ *   raw          u32 数组
+ *   bitpack-B    固定 B 位打包
+ *   for          frame-of-reference：每块存最小值和位宽，块内打包 (v - min)
+ *   delta-vbyte  差分 + 变长字节（Stream VByte：每 4 个值 1 个控制字节，
+ *                数据 1..4 字节），SIMD 解码用 pshufb 查表 + 前缀和
+ *
+ * 打包采用 8 路纵向布局（每块 256 个值，第 j 路存第 j, j+8, ... 个值），
+ * AVX2 解码只需要移位、掩码和拼接，不需要 gather。所有格式按 256 值的块
+ * 独立编码，线程可以从任意块开始解码。
+ *
+ * 工作集按原始大小放在 L1/L2/L3/DRAM（每核心），对比每核心 1 个线程与
+ * 2 个线程（超线程兄弟各扫描一半）。
+ *
+ * 编译: gcc -O2 -pthread -o compressed_scan compressed_scan.c
+ * 运行: ./compressed_scan [--cache | --dram | --all] [--cores N] [--bits B]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define BLOCK_VALUES 256                  // 每块值数
+#define LANES 8                           // 纵向打包的路数
+#define LANE_VALUES (BLOCK_VALUES / LANES)
+#define DRAM_PER_CORE (64 * 1024 * 1024)  // DRAM 级别每核心原始字节数
+#define TARGET_VALUES (128 * 1024 * 1024) // 每个测量点处理的值数
+#define DEFAULT_BITS 8
+#define STREAM_PAD 32                     // 编码流尾部填充，SIMD 加载可以越界读
+
+typedef enum { E_RAW, E_BITPACK, E_FOR, E_DELTA, NUM_ENCODINGS } encoding_t;
+
+typedef struct {
+    uint32_t base;            // for: 块最小值；delta: 块前一个值；bitpack: 0
+    uint32_t bits;            // 打包位宽（delta 不用）
+    size_t offset;            // 块在编码流中的字节偏移
+} block_hdr_t;
+
+typedef struct {
+    encoding_t kind;
+    char name[16];
+    uint32_t *raw;            // E_RAW
+    uint8_t *stream;          // 其它编码
+    block_hdr_t *hdr;
+    uint32_t *block_sum;      // 每块原始值之和，用于校验
+    size_t nblocks;
+    size_t bytes;             // 编码后总字节数（不含块头）
+} encoded_t;
+
+typedef uint32_t (*scan_fn)(const encoded_t *e, size_t blo, size_t bhi);
+
+typedef struct {
+    const char *name;
+    scan_fn fn;
+    int simd;                 // 需要 AVX2 / SSE4.1
+} scan_impl_t;
+
+static int has_avx2;
+static int has_sse41;
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static inline uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+// ---------------------------------------------------------------
+// raw
+// ---------------------------------------------------------------
+
+static uint32_t raw_scalar(const encoded_t *e, size_t blo, size_t bhi) {
+    const uint32_t *v = e->raw;
+    uint32_t sum = 0;
+    for (size_t i = blo * BLOCK_VALUES; i < bhi * BLOCK_VALUES; i++) {
+        sum += v[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static uint32_t hsum_avx2(__m256i acc) {
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return (uint32_t)_mm_cvtsi128_si32(s);
+}
+
+__attribute__((target("avx2")))
+static uint32_t raw_avx2(const encoded_t *e, size_t blo, size_t bhi) {
+    const __m256i *p = (const __m256i *)(e->raw + blo * BLOCK_VALUES);
+    const __m256i *end = (const __m256i *)(e->raw + bhi * BLOCK_VALUES);
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    for (; p < end; p += 2) {
+        acc0 = _mm256_add_epi32(acc0, _mm256_load_si256(p));
+        acc1 = _mm256_add_epi32(acc1, _mm256_load_si256(p + 1));
+    }
+    return hsum_avx2(_mm256_add_epi32(acc0, acc1));
+}
+
+// ---------------------------------------------------------------
+// bitpack / for：8 路纵向打包
+// ---------------------------------------------------------------
+
+// 块内第 j 路的第 k 个值占该路位流的 [k*bits, (k+1)*bits)；位流按 32 位字存放，
+// 第 w 个字的 8 路连续存放（偏移 w*8 + j），整块 bits*32 字节
+static void pack_block(const uint32_t *v, uint32_t base, int bits, uint32_t *out) {
+    memset(out, 0, (size_t)bits * LANES * sizeof(uint32_t));
+    for (int j = 0; j < LANES; j++) {
+        for (int k = 0; k < LANE_VALUES; k++) {
+            uint64_t x = v[j + LANES * k] - base;
+            int bit = k * bits, w = bit / 32, sh = bit % 32;
+            out[w * LANES + j] |= (uint32_t)(x << sh);
+            if (sh + bits > 32) out[(w + 1) * LANES + j] |= (uint32_t)(x >> (32 - sh));
+        }
+    }
+}
+
+static uint32_t unpack_block_scalar(const uint32_t *in, int bits, uint32_t base) {
+    uint32_t mask = bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+    uint32_t sum = 0;
+    for (int j = 0; j < LANES; j++) {
+        const uint32_t *lane = in + j;
+        uint32_t w = lane[0];
+        int shift = 0;
+        for (int k = 0; k < LANE_VALUES; k++) {
+            uint32_t v = w >> shift;
+            shift += bits;
+            if (shift >= 32) {
+                shift -= 32;
+                if (k + 1 < LANE_VALUES) {
+                    lane += LANES;
+                    w = lane[0];
+                    if (shift) v |= w << (bits - shift);
+                }
+            }
+            sum += (v & mask) + base;
+        }
+    }
+    return sum;
+}
+
+static uint32_t pack_scalar(const encoded_t *e, size_t blo, size_t bhi) {
+    uint32_t sum = 0;
+    for (size_t b = blo; b < bhi; b++) {
+        const block_hdr_t *h = &e->hdr[b];
+        sum += unpack_block_scalar((const uint32_t *)(e->stream + h->offset), h->bits, h->base);
+    }
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i unpack_block_avx2(const __m256i *in, int bits, uint32_t base,
+                                        __m256i acc) {
+    const __m256i mask = _mm256_set1_epi32(bits == 32 ? -1 : (int)((1u << bits) - 1));
+    const __m256i vbase = _mm256_set1_epi32((int)base);
+    __m256i w = _mm256_loadu_si256(in++);
+    int shift = 0;
+    for (int k = 0; k < LANE_VALUES; k++) {
+        __m256i v = _mm256_srl_epi32(w, _mm_cvtsi32_si128(shift));
+        shift += bits;
+        if (shift >= 32) {
+            shift -= 32;
+            if (k + 1 < LANE_VALUES) {
+                w = _mm256_loadu_si256(in++);
+                if (shift) {
+                    v = _mm256_or_si256(v, _mm256_sll_epi32(w, _mm_cvtsi32_si128(bits - shift)));
+                }
+            }
+        }
+        acc = _mm256_add_epi32(acc, _mm256_add_epi32(_mm256_and_si256(v, mask), vbase));
+    }
+    return acc;
+}
+
+__attribute__((target("avx2")))
+static uint32_t pack_avx2(const encoded_t *e, size_t blo, size_t bhi) {
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t b = blo; b < bhi; b++) {
+        const block_hdr_t *h = &e->hdr[b];
+        acc = unpack_block_avx2((const __m256i *)(e->stream + h->offset), h->bits, h->base, acc);
+    }
+    return hsum_avx2(acc);
+}
+
+// ---------------------------------------------------------------
+// delta + Stream VByte
+// ---------------------------------------------------------------
+
+// 块布局：64 个控制字节（每值 2 位：长度 - 1），随后是数据字节
+#define VBYTE_CTRL_BYTES (BLOCK_VALUES / 4)
+
+static __m128i vbyte_shuffle[256];
+static uint8_t vbyte_length[256];
+
+static void init_vbyte_tables(void) {
+    for (int c = 0; c < 256; c++) {
+        uint8_t shuf[16];
+        int off = 0;
+        for (int l = 0; l < 4; l++) {
+            int len = ((c >> (2 * l)) & 3) + 1;
+            for (int b = 0; b < 4; b++) {
+                shuf[l * 4 + b] = b < len ? (uint8_t)(off + b) : 0x80;
+            }
+            off += len;
+        }
+        memcpy(&vbyte_shuffle[c], shuf, sizeof(shuf));
+        vbyte_length[c] = (uint8_t)off;
+    }
+}
+
+static size_t vbyte_encode_block(const uint32_t *v, uint32_t prev, uint8_t *out) {
+    uint8_t *ctrl = out, *data = out + VBYTE_CTRL_BYTES;
+    memset(ctrl, 0, VBYTE_CTRL_BYTES);
+    for (int i = 0; i < BLOCK_VALUES; i++) {
+        uint32_t d = v[i] - prev;
+        int len = d < (1u << 8) ? 1 : d < (1u << 16) ? 2 : d < (1u << 24) ? 3 : 4;
+        ctrl[i / 4] |= (uint8_t)((len - 1) << (2 * (i % 4)));
+        memcpy(data, &d, len);
+        data += len;
+        prev = v[i];
+    }
+    return (size_t)(data - out);
+}
+
+static uint32_t delta_scalar(const encoded_t *e, size_t blo, size_t bhi) {
+    uint32_t sum = 0;
+    for (size_t b = blo; b < bhi; b++) {
+        const uint8_t *ctrl = e->stream + e->hdr[b].offset;
+        const uint8_t *data = ctrl + VBYTE_CTRL_BYTES;
+        uint32_t prev = e->hdr[b].base;
+        for (int i = 0; i < BLOCK_VALUES; i++) {
+            int len = ((ctrl[i / 4] >> (2 * (i % 4))) & 3) + 1;
+            uint32_t d;
+            memcpy(&d, data, sizeof(d));
+            d &= 0xFFFFFFFFu >> (32 - 8 * len);
+            data += len;
+            prev += d;
+            sum += prev;
+        }
+    }
+    return sum;
+}
+
+__attribute__((target("sse4.1")))
+static uint32_t delta_sse(const encoded_t *e, size_t blo, size_t bhi) {
+    __m128i acc = _mm_setzero_si128();
+    for (size_t b = blo; b < bhi; b++) {
+        const uint8_t *ctrl = e->stream + e->hdr[b].offset;
+        const uint8_t *data = ctrl + VBYTE_CTRL_BYTES;
+        __m128i prev = _mm_set1_epi32((int)e->hdr[b].base);
+        for (int g = 0; g < VBYTE_CTRL_BYTES; g++) {
+            uint8_t c = ctrl[g];
+            __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), vbyte_shuffle[c]);
+            data += vbyte_length[c];
+            // 4 路前缀和
+            d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+            d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+            d = _mm_add_epi32(d, prev);
+            prev = _mm_shuffle_epi32(d, 0xFF);
+            acc = _mm_add_epi32(acc, d);
+        }
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+    return (uint32_t)_mm_cvtsi128_si32(acc);
+}
+
+static const scan_impl_t impls[NUM_ENCODINGS][2] = {
+    [E_RAW] = {{"scalar", raw_scalar, 0}, {"avx2", raw_avx2, 1}},
+    [E_BITPACK] = {{"scalar", pack_scalar, 0}, {"avx2", pack_avx2, 1}},
+    [E_FOR] = {{"scalar", pack_scalar, 0}, {"avx2", pack_avx2, 1}},
+    [E_DELTA] = {{"scalar", delta_scalar, 0}, {"sse4.1", delta_sse, 1}},
+};
+
+static int impl_supported(encoding_t kind, int simd) {
+    if (!simd) return 1;
+    return kind == E_DELTA ? has_sse41 : has_avx2;
+}
+
+// ---------------------------------------------------------------
+// 数据生成与编码
+// ---------------------------------------------------------------
+
+static int bits_for(uint32_t range) {
+    return range == 0 ? 1 : 32 - __builtin_clz(range);
+}
+
+// 按块生成数据并编码；raw 与 bitpack 共用同一组值
+static int build_encoding(encoded_t *e, encoding_t kind, size_t nblocks, int bits,
+                          const encoded_t *src) {
+    uint32_t vals[BLOCK_VALUES];
+    size_t cap = nblocks * (BLOCK_VALUES * sizeof(uint32_t) + VBYTE_CTRL_BYTES) + STREAM_PAD;
+
+    memset(e, 0, sizeof(*e));
+    e->kind = kind;
+    e->nblocks = nblocks;
+    e->block_sum = malloc(nblocks * sizeof(uint32_t));
+    if (kind == E_RAW) {
+        e->raw = aligned_alloc(CACHE_LINE_SIZE, nblocks * BLOCK_VALUES * sizeof(uint32_t));
+    } else {
+        e->hdr = malloc(nblocks * sizeof(block_hdr_t));
+        e->stream = aligned_alloc(CACHE_LINE_SIZE, cap);
+    }
+    if (!e->block_sum || (kind == E_RAW ? !e->raw : (!e->hdr || !e->stream))) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    static const char *names[NUM_ENCODINGS] = {"raw", "bitpack", "for", "delta-vbyte"};
+    if (kind == E_BITPACK) {
+        snprintf(e->name, sizeof(e->name), "bitpack-%d", bits);
+    } else {
+        snprintf(e->name, sizeof(e->name), "%s", names[kind]);
+    }
+
+    uint32_t level = 1u << 30, prev = 0;
+    size_t off = 0;
+    for (size_t b = 0; b < nblocks; b++) {
+        uint32_t sum = 0, lo = UINT32_MAX, hi = 0, before = prev;
+        for (int i = 0; i < BLOCK_VALUES; i++) {
+            uint32_t v;
+            if (kind == E_BITPACK) {
+                v = src->raw[b * BLOCK_VALUES + i];
+            } else if (kind == E_RAW) {
+                v = bits == 32 ? rng_next() : rng_next() & ((1u << bits) - 1);
+            } else if (kind == E_FOR) {
+                // 缓慢漂移的基线 + 12 位噪声（如传感器读数）
+                if ((i & 63) == 0) level += (rng_next() % 8192) - 4096;
+                v = level + (rng_next() & 0xFFF);
+            } else {
+                // 递增序列：多数间隔 < 256，1/64 的间隔到 2^20（如时间戳、行号）
+                uint32_t r = rng_next();
+                prev += (r & 63) == 0 ? (r >> 12) : 1 + (r >> 24);
+                v = prev;
+            }
+            vals[i] = v;
+            sum += v;
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+        e->block_sum[b] = sum;
+
+        if (kind == E_RAW) {
+            memcpy(e->raw + b * BLOCK_VALUES, vals, sizeof(vals));
+            continue;
+        }
+        block_hdr_t *h = &e->hdr[b];
+        h->offset = off;
+        if (kind == E_DELTA) {
+            h->base = before;
+            off += vbyte_encode_block(vals, h->base, e->stream + off);
+        } else {
+            h->base = kind == E_FOR ? lo : 0;
+            h->bits = kind == E_FOR ? bits_for(hi - lo) : bits;
+            pack_block(vals, h->base, h->bits, (uint32_t *)(e->stream + off));
+            off += (size_t)h->bits * LANES * sizeof(uint32_t);
+        }
+    }
+    if (kind == E_RAW) {
+        e->bytes = nblocks * BLOCK_VALUES * sizeof(uint32_t);
+    } else {
+        e->bytes = off;
+        memset(e->stream + off, 0, STREAM_PAD);
+    }
+    return 0;
+}
+
+static void free_encoding(encoded_t *e) {
+    free(e->raw);
+    free(e->stream);
+    free(e->hdr);
+    free(e->block_sum);
+}
+
+// ---------------------------------------------------------------
+// 多线程执行
+// ---------------------------------------------------------------
+
+typedef struct {
+    int cpu_id;
+    const encoded_t *enc;
+    scan_fn fn;
+    size_t blo, bhi;
+    int reps;
+    uint32_t sum;
+    volatile int *ready;
+    volatile int *start;
+} thread_arg_t;
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+    uint32_t sum = 0;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    for (int r = 0; r < targ->reps; r++) {
+        sum += targ->fn(targ->enc, targ->blo, targ->bhi);
+    }
+    targ->sum = sum;
+    return NULL;
+}
+
+// cores 个核心各分到 per_core 块；tpc = 2 时超线程兄弟各扫描一半
+// 返回 G values/s，*ok 为校验结果
+static double run_scan(const encoded_t *e, scan_fn fn, int cores, int tpc, size_t per_core,
+                       int *ok) {
+    pthread_t threads[NUM_HW_THREADS];
+    thread_arg_t args[NUM_HW_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+    int nthreads = cores * tpc;
+    size_t values = (size_t)cores * per_core * BLOCK_VALUES;
+    int reps = values >= TARGET_VALUES ? 1 : (int)(TARGET_VALUES / values);
+
+    for (int t = 0; t < nthreads; t++) {
+        int core = t / tpc, half = t % tpc;
+        size_t blo = core * per_core + half * (per_core / tpc);
+        args[t] = (thread_arg_t){
+            .cpu_id = tpc == 2 ? placement_cpu(t, PLACE_COMPACT) : placement_cpu(t, PLACE_SPREAD),
+            .enc = e, .fn = fn, .blo = blo, .bhi = blo + per_core / tpc, .reps = reps,
+            .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < nthreads) usleep(100);
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+    double elapsed = get_time_sec() - t0;
+
+    uint32_t got = 0, expect = 0;
+    for (int t = 0; t < nthreads; t++) got += args[t].sum;
+    for (size_t b = 0; b < cores * per_core; b++) expect += e->block_sum[b];
+    *ok = got == expect * (uint32_t)reps;
+
+    return (double)values * reps / elapsed / 1e9;
+}
+
+// ---------------------------------------------------------------
+// 测试
+// ---------------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    size_t per_core_bytes;    // 每核心原始工作集
+} level_t;
+
+// L3 级别要超过 1MB 的 L2，又不超过每核心 2MB 的 L3 份额（16MB / 8 核心）
+static const level_t cache_levels[] = {
+    {"L1", 16 * 1024},
+    {"L2", 256 * 1024},
+    {"L3", 1536 * 1024},
+};
+static const level_t dram_level = {"DRAM", DRAM_PER_CORE};
+
+static void run_level(encoded_t *encs, const level_t *lv, int cores) {
+    size_t per_core = lv->per_core_bytes / (BLOCK_VALUES * sizeof(uint32_t));
+    size_t nblocks = per_core * cores;
+
+    printf("\n=== %s: %zu KB raw per core, %d core%s (%zu KB total) ===\n", lv->name,
+           lv->per_core_bytes / 1024, cores, cores > 1 ? "s" : "",
+           lv->per_core_bytes * cores / 1024);
+    printf("G values/s; 2 T/core splits each core's blocks between its HT siblings\n");
+    printf("%-12s %8s %-7s %12s %12s %9s  %s\n", "Encoding", "B/value", "Impl", "1 T/core",
+           "2 T/core", "SMT gain", "Check");
+    printf("--------------------------------------------------------------------------\n");
+
+    for (int k = 0; k < NUM_ENCODINGS; k++) {
+        encoded_t *e = &encs[k];
+        size_t bytes = e->kind == E_RAW ? nblocks * BLOCK_VALUES * sizeof(uint32_t)
+                     : nblocks < e->nblocks ? e->hdr[nblocks].offset : e->bytes;
+        double bpv = (double)bytes / (nblocks * BLOCK_VALUES);
+
+        for (int s = 0; s < 2; s++) {
+            const scan_impl_t *im = &impls[k][s];
+            printf("%-12s ", s == 0 ? e->name : "");
+            if (s == 0) printf("%8.2f ", bpv); else printf("%8s ", "");
+            printf("%-7s", im->name);
+            if (!impl_supported(e->kind, im->simd)) {
+                printf(" %12s %12s %9s\n", "-", "-", "-");
+                continue;
+            }
+            int ok1, ok2;
+            double g1 = run_scan(e, im->fn, cores, 1, per_core, &ok1);
+            printf(" %12.2f", g1);
+            fflush(stdout);
+            double g2 = run_scan(e, im->fn, cores, 2, per_core, &ok2);
+            printf(" %12.2f %8.2fx  %s\n", g2, g2 / g1, ok1 && ok2 ? "OK" : "MISMATCH");
+        }
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--cache | --dram | --all] [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --cores N   Physical cores to use (default %d)\n", NUM_CORES);
+    printf("  --bits B    Bit width for bitpack (default %d)\n", DEFAULT_BITS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    int cores = NUM_CORES;
+    int bits = DEFAULT_BITS;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--cores") == 0) {
+            cores = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--bits") == 0) {
+            bits = atoi(argv[i + 1]);
+        }
+    }
+
+    int do_cache = strcmp(mode, "--cache") == 0 || strcmp(mode, "--all") == 0;
+    int do_dram = strcmp(mode, "--dram") == 0 || strcmp(mode, "--all") == 0;
+    if ((!do_cache && !do_dram) || cores < 1 || cores > NUM_CORES || bits < 1 || bits > 32) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2");
+    has_sse41 = __builtin_cpu_supports("sse4.1");
+    init_vbyte_tables();
+
+    // 按最大级别生成一次，小级别使用前缀块
+    size_t max_bytes = do_dram ? DRAM_PER_CORE : cache_levels[2].per_core_bytes;
+    size_t nblocks = max_bytes / (BLOCK_VALUES * sizeof(uint32_t)) * cores;
+    encoded_t encs[NUM_ENCODINGS];
+    for (int k = 0; k < NUM_ENCODINGS; k++) {
+        if (build_encoding(&encs[k], (encoding_t)k, nblocks, bits, &encs[E_RAW])) return 1;
+    }
+
+    printf("=== Compressed Scan Benchmark: Compute vs Bandwidth ===\n");
+    printf("Sum of up to %.2f M values per encoding; AVX2: %s, SSE4.1: %s\n",
+           nblocks * BLOCK_VALUES / (1024.0 * 1024), has_avx2 ? "yes" : "no", has_sse41 ? "yes" : "no");
+
+    if (do_cache) {
+        for (size_t l = 0; l < sizeof(cache_levels) / sizeof(cache_levels[0]); l++) {
+            run_level(encs, &cache_levels[l], cores);
+        }
+    }
+    if (do_dram) {
+        run_level(encs, &dram_level, cores);
+    }
+
+    if (strcmp(mode, "--all") == 0) {
+        printf("\n=== Analysis ===\n");
+        printf("- In L1/L2 raw AVX2 is limited by loads; every encoding is slower there\n");
+        printf("  because decoding adds work without saving anything\n");
+        printf("- In DRAM raw scans are bandwidth bound, so B/value sets the ceiling:\n");
+        printf("  bitpack/for/delta deliver 4/B-per-value times more values per byte\n");
+        printf("- Scalar decoders stay core bound everywhere; SIMD decoders are what\n");
+        printf("  turn the saved bandwidth into throughput\n");
+        printf("- 2 T/core helps most for decode-heavy scalar kernels (idle ALUs) and\n");
+        printf("  least for raw scans that already saturate the load ports\n");
+    }
+
+    for (int k = 0; k < NUM_ENCODINGS; k++) free_encoding(&encs[k]);
+    return 0;
+}
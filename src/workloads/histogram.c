@@ -0,0 +1,428 @@
+/*
+ * histogram.c - 并行直方图：共享原子桶 vs 私有副本 vs 超线程共享副本
+ *
+ * false_sharing.c 用 4 个计数器演示了缓存行乒乓；真实的直方图/聚合有成千上万个桶，
+ * 且命中高度倾斜（Zipf）：热点桶在所有线程之间来回迁移。
+ *
+ * 策略：
+ *   atomic       所有线程对同一份桶做 lock add
+ *   private      每个线程一份私有桶，结束后并行归并（每个线程归并一段桶）
+ *   smt-shared   每个物理核心一份桶，由两个超线程以原子加共享（缓存行不出 L1），
+ *                归并的副本数减半
+ *   partitioned  按桶的哈希划分所有权：先把键按目标线程分区，再由所有者无原子地累加，
+ *                不需要归并，但每个键多一次写出/读回
+ *
+ * 输入：均匀分布或 Zipf 分布（桶编号随机置换，热点桶不相邻）。
+ * 报告 M updates/s（含归并）以及归并耗时。
+ *
+ * 编译: gcc -O2 -pthread -o histogram histogram.c -lm
+ * 运行: ./histogram [--uniform | --zipf | --all] [--threads N] [--bins N] [--zipf-s S]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define NUM_KEYS (32 * 1024 * 1024)   // 128MB 输入
+#define DEFAULT_BINS 4096             // 32KB 桶数组
+#define DEFAULT_ZIPF_S 1.1
+#define MAX_BINS (16 * 1024 * 1024)
+#define MAX_THREADS NUM_HW_THREADS
+
+typedef enum { S_ATOMIC, S_PRIVATE, S_SMT_SHARED, S_PARTITIONED, NUM_STRATEGIES } strategy_t;
+
+static const char *strategy_names[NUM_STRATEGIES] = {
+    "atomic", "private", "smt-shared", "partitioned"
+};
+
+typedef struct {
+    strategy_t strategy;
+    int nthreads;
+    int nbins;
+    const uint32_t *keys;
+    size_t nkeys;
+    uint64_t *global;              // 最终结果
+    uint64_t *copies[MAX_THREADS]; // private: 每线程一份；smt-shared: 每核心一份
+    int ncopies;
+    uint32_t *part_buf[MAX_THREADS];                 // partitioned: 每线程的分区输出
+    size_t part_off[MAX_THREADS][MAX_THREADS + 1];   // [源线程][目标线程] 起始偏移
+    pthread_barrier_t barrier;
+    double t_merge;                // 更新阶段结束时刻
+} hist_ctx_t;
+
+typedef struct {
+    int cpu_id;
+    int tid;
+    hist_ctx_t *ctx;
+    volatile int *ready;
+    volatile int *start;
+} thread_arg_t;
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static inline uint64_t xorshift64(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// 桶 b 的所有者：乘法哈希后用乘法-移位映射到 [0, nthreads)，避免每个键一次除法
+static inline int bin_owner(uint32_t b, uint64_t nthreads) {
+    uint32_t h = b * 0x9E3779B1u;
+    return (int)(((uint64_t)h * nthreads) >> 32);
+}
+
+static void chunk(size_t n, int parts, int idx, size_t *lo, size_t *hi) {
+    *lo = n * idx / parts;
+    *hi = n * (idx + 1) / parts;
+}
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+    hist_ctx_t *c = targ->ctx;
+    int tid = targ->tid, nt = c->nthreads, nbins = c->nbins;
+    size_t lo, hi;
+
+    bind_to_cpu(targ->cpu_id);
+    chunk(c->nkeys, nt, tid, &lo, &hi);
+
+    // 副本和分区缓冲由使用它的线程在计时前首次触碰
+    if (c->strategy == S_PRIVATE) {
+        memset(c->copies[tid], 0, nbins * sizeof(uint64_t));
+    } else if (c->strategy == S_SMT_SHARED && tid % 2 == 0) {
+        memset(c->copies[tid / 2], 0, nbins * sizeof(uint64_t));
+    } else if (c->strategy == S_PARTITIONED) {
+        memset(c->part_buf[tid], 0, (hi - lo) * sizeof(uint32_t));
+    }
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    const uint32_t *keys = c->keys;
+
+    // 更新阶段
+    switch (c->strategy) {
+    case S_ATOMIC:
+        for (size_t i = lo; i < hi; i++) {
+            __atomic_fetch_add(&c->global[keys[i]], 1, __ATOMIC_RELAXED);
+        }
+        break;
+    case S_PRIVATE: {
+        uint64_t *h = c->copies[tid];
+        for (size_t i = lo; i < hi; i++) {
+            h[keys[i]]++;
+        }
+        break;
+    }
+    case S_SMT_SHARED: {
+        uint64_t *h = c->copies[tid / 2];
+        for (size_t i = lo; i < hi; i++) {
+            __atomic_fetch_add(&h[keys[i]], 1, __ATOMIC_RELAXED);
+        }
+        break;
+    }
+    case S_PARTITIONED: {
+        // 1. 统计每个目标线程的键数；2. 分散写出；3. 所有者累加发给自己的键
+        size_t *off = c->part_off[tid];
+        size_t count[MAX_THREADS] = {0};
+        const uint64_t owners = (uint64_t)nt;
+        for (size_t i = lo; i < hi; i++) {
+            count[bin_owner(keys[i], owners)]++;
+        }
+        off[0] = 0;
+        for (int d = 0; d < nt; d++) off[d + 1] = off[d] + count[d];
+
+        size_t pos[MAX_THREADS];
+        memcpy(pos, off, nt * sizeof(size_t));
+        uint32_t *buf = c->part_buf[tid];
+        for (size_t i = lo; i < hi; i++) {
+            uint32_t k = keys[i];
+            buf[pos[bin_owner(k, owners)]++] = k;
+        }
+        pthread_barrier_wait(&c->barrier);
+
+        uint64_t *h = c->global;
+        for (int src = 0; src < nt; src++) {
+            const uint32_t *in = c->part_buf[src];
+            for (size_t i = c->part_off[src][tid]; i < c->part_off[src][tid + 1]; i++) {
+                h[in[i]]++;
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    pthread_barrier_wait(&c->barrier);
+    if (tid == 0) c->t_merge = get_time_sec();
+
+    // 归并阶段：每个线程负责一段桶
+    if (c->strategy == S_PRIVATE || c->strategy == S_SMT_SHARED) {
+        size_t b0, b1;
+        chunk(nbins, nt, tid, &b0, &b1);
+        for (size_t b = b0; b < b1; b++) {
+            uint64_t sum = 0;
+            for (int i = 0; i < c->ncopies; i++) sum += c->copies[i][b];
+            c->global[b] = sum;
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    double mups;       // 百万次更新/秒（含归并）
+    double merge_ms;
+    int ok;
+} hist_result_t;
+
+static hist_result_t run_strategy(strategy_t strategy, const uint32_t *keys, int nbins,
+                                  int nthreads, placement_t placement,
+                                  const uint64_t *reference) {
+    hist_ctx_t *c = calloc(1, sizeof(hist_ctx_t));
+    pthread_t threads[MAX_THREADS];
+    thread_arg_t args[MAX_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+    hist_result_t r = {0, 0, 0};
+
+    if (!c) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+    c->strategy = strategy;
+    c->nthreads = nthreads;
+    c->nbins = nbins;
+    c->keys = keys;
+    c->nkeys = NUM_KEYS;
+    c->global = aligned_alloc(CACHE_LINE_SIZE, (size_t)nbins * sizeof(uint64_t));
+    if (!c->global) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+    memset(c->global, 0, (size_t)nbins * sizeof(uint64_t));
+
+    // smt-shared 的两个线程必须是同一核心的超线程
+    if (strategy == S_SMT_SHARED) placement = PLACE_COMPACT;
+    c->ncopies = strategy == S_PRIVATE ? nthreads
+               : strategy == S_SMT_SHARED ? (nthreads + 1) / 2 : 0;
+    for (int i = 0; i < c->ncopies; i++) {
+        c->copies[i] = aligned_alloc(CACHE_LINE_SIZE, (size_t)nbins * sizeof(uint64_t));
+        if (!c->copies[i]) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+    }
+    if (strategy == S_PARTITIONED) {
+        for (int t = 0; t < nthreads; t++) {
+            size_t lo, hi;
+            chunk(NUM_KEYS, nthreads, t, &lo, &hi);
+            c->part_buf[t] = malloc((hi - lo) * sizeof(uint32_t));
+            if (!c->part_buf[t]) {
+                perror("Memory allocation failed");
+                exit(1);
+            }
+        }
+    }
+
+    pthread_barrier_init(&c->barrier, NULL, nthreads);
+    for (int t = 0; t < nthreads; t++) {
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, placement), .tid = t, .ctx = c,
+            .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < nthreads) usleep(100);
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+    double t1 = get_time_sec();
+
+    r.mups = NUM_KEYS / (t1 - t0) / 1e6;
+    r.merge_ms = (t1 - c->t_merge) * 1e3;
+    r.ok = memcmp(c->global, reference, (size_t)nbins * sizeof(uint64_t)) == 0;
+
+    pthread_barrier_destroy(&c->barrier);
+    for (int i = 0; i < c->ncopies; i++) free(c->copies[i]);
+    for (int t = 0; t < nthreads; t++) free(c->part_buf[t]);
+    free(c->global);
+    free(c);
+    return r;
+}
+
+// 生成键：均匀，或按 Zipf(s) 取秩后映射到随机置换的桶编号
+static void generate_keys(uint32_t *keys, int nbins, int zipf, double s) {
+    if (!zipf) {
+        for (size_t i = 0; i < NUM_KEYS; i++) {
+            keys[i] = (uint32_t)(((xorshift64() >> 32) * (uint64_t)nbins) >> 32);
+        }
+        return;
+    }
+
+    double *cdf = malloc((size_t)nbins * sizeof(double));
+    uint32_t *perm = malloc((size_t)nbins * sizeof(uint32_t));
+    if (!cdf || !perm) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+    double sum = 0;
+    for (int i = 0; i < nbins; i++) {
+        sum += 1.0 / pow(i + 1, s);
+        cdf[i] = sum;
+        perm[i] = i;
+    }
+    for (int i = nbins - 1; i > 0; i--) {
+        int j = xorshift64() % (i + 1);
+        uint32_t tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+
+    for (size_t i = 0; i < NUM_KEYS; i++) {
+        double u = (xorshift64() >> 11) * (1.0 / 9007199254740992.0) * sum;
+        int lo = 0, hi = nbins - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (cdf[mid] < u) lo = mid + 1;
+            else hi = mid;
+        }
+        keys[i] = perm[lo];
+    }
+    free(cdf);
+    free(perm);
+}
+
+static int run_distribution(int zipf, double s, int nbins, int max_threads,
+                            placement_t placement) {
+    uint32_t *keys = malloc((size_t)NUM_KEYS * sizeof(uint32_t));
+    uint64_t *reference = calloc(nbins, sizeof(uint64_t));
+    if (!keys || !reference) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    generate_keys(keys, nbins, zipf, s);
+    uint64_t top = 0;
+    for (size_t i = 0; i < NUM_KEYS; i++) reference[keys[i]]++;
+    for (int b = 0; b < nbins; b++) {
+        if (reference[b] > top) top = reference[b];
+    }
+
+    if (zipf) {
+        printf("\n=== Zipf s=%.2f, %d bins (%zu KB per copy) ===\n", s, nbins,
+               nbins * sizeof(uint64_t) / 1024);
+    } else {
+        printf("\n=== Uniform, %d bins (%zu KB per copy) ===\n", nbins,
+               nbins * sizeof(uint64_t) / 1024);
+    }
+    printf("%d keys, hottest bin receives %.2f%% of updates, placement %s\n",
+           NUM_KEYS, 100.0 * top / NUM_KEYS, placement_name(placement));
+    printf("M updates/s (merge ms); smt-shared always uses compact placement\n");
+    printf("%-8s", "Threads");
+    for (int st = 0; st < NUM_STRATEGIES; st++) printf(" %20s", strategy_names[st]);
+    printf("\n");
+    printf("--------------------------------------------------------------------------------------\n");
+
+    int all_ok = 1;
+    for (int nt = 1; nt <= max_threads;
+         nt = nt < max_threads && nt * 2 > max_threads ? max_threads : nt * 2) {
+        printf("%-8d", nt);
+        for (int st = 0; st < NUM_STRATEGIES; st++) {
+            hist_result_t r = run_strategy((strategy_t)st, keys, nbins, nt, placement,
+                                           reference);
+            all_ok &= r.ok;
+            if (st == S_PRIVATE || st == S_SMT_SHARED) {
+                printf(" %11.1f (%6.2f)", r.mups, r.merge_ms);
+            } else {
+                printf(" %20.1f", r.mups);
+            }
+            if (!r.ok) printf(" MISMATCH");
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+    printf("Check: %s\n", all_ok ? "OK" : "MISMATCH");
+
+    free(keys);
+    free(reference);
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--uniform | --zipf | --all] [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --threads N     Largest thread count, sweeps 1,2,4,.. (default %d)\n",
+           NUM_HW_THREADS);
+    printf("  --bins N        Number of bins (default %d)\n", DEFAULT_BINS);
+    printf("  --zipf-s S      Zipf exponent (default %.1f)\n", DEFAULT_ZIPF_S);
+    printf("  --placement P   spread | compact (default compact)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    int max_threads = NUM_HW_THREADS;
+    int nbins = DEFAULT_BINS;
+    double s = DEFAULT_ZIPF_S;
+    placement_t placement = PLACE_COMPACT;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            max_threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--bins") == 0) {
+            nbins = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--zipf-s") == 0) {
+            s = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "--placement") == 0) {
+            placement = strcmp(argv[i + 1], "spread") == 0 ? PLACE_SPREAD : PLACE_COMPACT;
+        }
+    }
+    if (max_threads < 1 || max_threads > MAX_THREADS || nbins < 1 || nbins > MAX_BINS ||
+        s <= 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("=== Parallel Histogram Benchmark ===\n");
+
+    if (strcmp(mode, "--uniform") == 0) {
+        return run_distribution(0, s, nbins, max_threads, placement);
+    } else if (strcmp(mode, "--zipf") == 0) {
+        return run_distribution(1, s, nbins, max_threads, placement);
+    } else if (strcmp(mode, "--all") == 0) {
+        int bins[] = {nbins, 256 * 1024};
+        for (int i = 0; i < 2; i++) {
+            if (run_distribution(0, s, bins[i], max_threads, placement) != 0) return 1;
+            if (run_distribution(1, s, bins[i], max_threads, placement) != 0) return 1;
+        }
+
+        printf("\n=== Analysis ===\n");
+        printf("- atomic: uniform keys over many bins rarely collide, but every update\n");
+        printf("  is a locked RMW; under Zipf the hottest lines ping-pong between cores\n");
+        printf("  and throughput falls as threads are added\n");
+        printf("- private: no sharing during updates; merge cost grows as threads x bins\n");
+        printf("  and dominates when the input per thread is small or bins are many\n");
+        printf("- smt-shared: siblings share one copy in their L1/L2, so atomics stay\n");
+        printf("  core-local; half the copies to merge, and the copy footprint per core\n");
+        printf("  is halved compared with two private copies\n");
+        printf("- partitioned: no atomics and no merge, each owner's bins fit in cache;\n");
+        printf("  pays one extra write + read of every key, so it wins mainly when bins\n");
+        printf("  are too many for per-thread copies\n");
+        return 0;
+    }
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,392 @@
+/*
+ * linked_traversal.c - 链式结构遍历：跳跃指针、贪婪预取与超线程预执行
+ *
+ * random_prefetch.c 的预取依赖事先知道 indices[i + PREFETCH_AHEAD]，
+ * 链表和树做不到：下一个地址要等当前节点加载完才知道。
+ * 本测试对链表和二叉树（先序 DFS）比较：
+ *
+ * 节点分配顺序：
+ *   sequential  按遍历顺序连续分配，硬件预取器可以跟上
+ *   random      随机槽位，每个节点一次缓存缺失
+ *   clustered   16 个池交替分配（类似 slab），池内连续、池间交错
+ *
+ * 预取策略：
+ *   none        只有依赖链
+ *   greedy      访问节点时预取所有后继（链表 next，树 left/right）
+ *   jump        构建时安装跳跃指针，指向 JUMP_DISTANCE 个节点之后，
+ *               访问时预取 jump
+ *   run-ahead   同核心的超线程上运行辅助线程，沿同一路径提前遍历，
+ *               最多领先 RUNAHEAD_WINDOW 个节点
+ *
+ * 每个节点 64 字节，访问时做一小段依赖计算（模拟处理节点）。
+ *
+ * 编译: gcc -O2 -pthread -o linked_traversal linked_traversal.c
+ * 运行: ./linked_traversal [--list | --tree | --all]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define SMALL_NODES (16 * 1024)         // 1MB：L2/L3 内
+#define LARGE_NODES (1024 * 1024)       // 64MB：超出 L3
+#define TOTAL_VISITS (8 * 1024 * 1024)  // 每次测量访问的节点总数
+#define JUMP_DISTANCE 16                // 跳跃指针距离（节点数）
+#define NUM_POOLS 16                    // clustered 分配的池数
+#define RUNAHEAD_WINDOW 256             // 辅助线程最多领先的节点数
+#define PUBLISH_INTERVAL 64             // 主线程每隔多少节点公布进度
+#define WORK_ROUNDS 8                   // 每个节点的依赖计算轮数
+#define MAX_DEPTH 64
+
+typedef struct lnode {
+    struct lnode *next;
+    struct lnode *jump;
+    uint64_t value;
+    char padding[CACHE_LINE_SIZE - 3 * sizeof(void *)];
+} lnode_t;
+
+typedef struct tnode {
+    struct tnode *left;
+    struct tnode *right;
+    struct tnode *jump;  // 先序遍历中 JUMP_DISTANCE 个节点之后的节点
+    uint64_t key;
+    char padding[CACHE_LINE_SIZE - 4 * sizeof(void *)];
+} tnode_t;
+
+typedef enum {
+    ORDER_SEQUENTIAL,
+    ORDER_RANDOM,
+    ORDER_CLUSTERED,
+    NUM_ORDERS
+} alloc_order_t;
+
+typedef enum {
+    STRAT_NONE,
+    STRAT_GREEDY,
+    STRAT_JUMP,
+    STRAT_RUNAHEAD,
+    NUM_STRATEGIES
+} strategy_t;
+
+static const char *order_names[NUM_ORDERS] = {"sequential", "random", "clustered"};
+static const char *strategy_names[NUM_STRATEGIES] = {"none", "greedy", "jump", "run-ahead"};
+
+static uint64_t rng_state = 12345;
+
+static inline uint64_t next_rand(void) {
+    rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return rng_state >> 33;
+}
+
+// 模拟处理节点的一段依赖计算
+static inline uint64_t node_work(uint64_t v) {
+    for (int i = 0; i < WORK_ROUNDS; i++) {
+        v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return v;
+}
+
+// ---------------------------------------------------------------
+// 节点分配顺序：slots[i] 为第 i 次分配得到的槽位
+// ---------------------------------------------------------------
+
+static void make_slots(size_t *slots, size_t n, alloc_order_t order) {
+    if (order == ORDER_SEQUENTIAL) {
+        for (size_t i = 0; i < n; i++) slots[i] = i;
+    } else if (order == ORDER_RANDOM) {
+        for (size_t i = 0; i < n; i++) slots[i] = i;
+        for (size_t i = n - 1; i > 0; i--) {
+            size_t j = next_rand() % (i + 1);
+            size_t tmp = slots[i];
+            slots[i] = slots[j];
+            slots[j] = tmp;
+        }
+    } else {
+        // 每次分配随机选一个池，池内按顺序取下一个槽位
+        size_t per_pool = n / NUM_POOLS;
+        size_t fill[NUM_POOLS] = {0};
+        for (size_t i = 0; i < n; i++) {
+            int p = next_rand() % NUM_POOLS;
+            while (fill[p] == per_pool) p = (p + 1) % NUM_POOLS;
+            slots[i] = p * per_pool + fill[p]++;
+        }
+    }
+}
+
+// ---------------------------------------------------------------
+// 构建
+// ---------------------------------------------------------------
+
+static lnode_t *build_list(lnode_t *pool, const size_t *slots, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        lnode_t *node = &pool[slots[i]];
+        node->next = i + 1 < n ? &pool[slots[i + 1]] : NULL;
+        node->jump = i + JUMP_DISTANCE < n ? &pool[slots[i + JUMP_DISTANCE]] : NULL;
+        node->value = i;
+    }
+    return &pool[slots[0]];
+}
+
+typedef struct {
+    tnode_t *pool;
+    const size_t *slots;
+    tnode_t **preorder;  // 按先序记录节点，用于安装跳跃指针
+    size_t count;
+} tree_builder_t;
+
+// 平衡 BST，按先序分配节点
+static tnode_t *build_tree_rec(tree_builder_t *b, int64_t lo, int64_t hi) {
+    if (lo > hi) return NULL;
+    int64_t mid = lo + (hi - lo) / 2;
+    tnode_t *node = &b->pool[b->slots[b->count]];
+    b->preorder[b->count++] = node;
+    node->key = mid;
+    node->left = build_tree_rec(b, lo, mid - 1);
+    node->right = build_tree_rec(b, mid + 1, hi);
+    return node;
+}
+
+static tnode_t *build_tree(tnode_t *pool, const size_t *slots, tnode_t **preorder, size_t n) {
+    tree_builder_t b = {pool, slots, preorder, 0};
+    tnode_t *root = build_tree_rec(&b, 0, (int64_t)n - 1);
+    for (size_t i = 0; i < n; i++) {
+        preorder[i]->jump = i + JUMP_DISTANCE < n ? preorder[i + JUMP_DISTANCE] : NULL;
+    }
+    return root;
+}
+
+// ---------------------------------------------------------------
+// 遍历（progress 非空时每 PUBLISH_INTERVAL 个节点公布进度）
+// ---------------------------------------------------------------
+
+static uint64_t list_traverse(const lnode_t *head, strategy_t strategy,
+                              volatile uint64_t *progress, uint64_t *visited) {
+    uint64_t sum = 0;
+    uint64_t count = *visited;
+
+    for (const lnode_t *node = head; node; node = node->next) {
+        if (strategy == STRAT_GREEDY) {
+            PREFETCH_T0(node->next);
+        } else if (strategy == STRAT_JUMP) {
+            PREFETCH_T0(node->jump);
+        }
+        sum += node_work(node->value);
+        if (progress && (++count % PUBLISH_INTERVAL) == 0) *progress = count;
+    }
+    *visited = count;
+    return sum;
+}
+
+static uint64_t tree_traverse(const tnode_t *root, strategy_t strategy,
+                              volatile uint64_t *progress, uint64_t *visited) {
+    const tnode_t *stack[MAX_DEPTH];
+    int top = 0;
+    uint64_t sum = 0;
+    uint64_t count = *visited;
+
+    stack[top++] = root;
+    while (top > 0) {
+        const tnode_t *node = stack[--top];
+        if (strategy == STRAT_GREEDY) {
+            PREFETCH_T0(node->left);
+            PREFETCH_T0(node->right);
+        } else if (strategy == STRAT_JUMP) {
+            PREFETCH_T0(node->jump);
+        }
+        sum += node_work(node->key);
+        if (node->right) stack[top++] = node->right;
+        if (node->left) stack[top++] = node->left;
+        if (progress && (++count % PUBLISH_INTERVAL) == 0) *progress = count;
+    }
+    *visited = count;
+    return sum;
+}
+
+// ---------------------------------------------------------------
+// 超线程预执行辅助线程：只沿路径加载，不做计算
+// ---------------------------------------------------------------
+
+typedef struct {
+    int cpu_id;
+    int is_tree;
+    const void *root;
+    int passes;
+    volatile uint64_t *progress;  // 主线程已访问节点数
+    volatile int *done;
+    volatile int *ready;
+    volatile int *start;
+} helper_arg_t;
+
+// 领先超过窗口时等待主线程追上
+static inline void helper_throttle(uint64_t ahead, const helper_arg_t *h) {
+    while (ahead > *h->progress + RUNAHEAD_WINDOW && !*h->done) {
+        __builtin_ia32_pause();
+    }
+}
+
+static void *helper_thread(void *arg) {
+    helper_arg_t *h = (helper_arg_t *)arg;
+    uint64_t count = 0;
+
+    bind_to_cpu(h->cpu_id);
+
+    __atomic_fetch_add(h->ready, 1, __ATOMIC_SEQ_CST);
+    while (*h->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    for (int pass = 0; pass < h->passes && !*h->done; pass++) {
+        if (!h->is_tree) {
+            for (const lnode_t *node = h->root; node && !*h->done; node = node->next) {
+                if ((++count % PUBLISH_INTERVAL) == 0) helper_throttle(count, h);
+            }
+        } else {
+            const tnode_t *stack[MAX_DEPTH];
+            int top = 0;
+            stack[top++] = h->root;
+            while (top > 0 && !*h->done) {
+                const tnode_t *node = stack[--top];
+                if (node->right) stack[top++] = node->right;
+                if (node->left) stack[top++] = node->left;
+                if ((++count % PUBLISH_INTERVAL) == 0) helper_throttle(count, h);
+            }
+        }
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------
+// 测量
+// ---------------------------------------------------------------
+
+static uint64_t sink;
+
+// 返回 ns/node
+static double measure(int is_tree, const void *root, size_t n, strategy_t strategy) {
+    int passes = TOTAL_VISITS / n;
+    volatile uint64_t progress = 0;
+    volatile uint64_t *publish = NULL;
+    volatile int done = 0;
+    volatile int ready = 0;
+    volatile int start = 0;
+    pthread_t helper;
+    helper_arg_t harg;
+    uint64_t visited = 0;
+    uint64_t sum = 0;
+
+    if (strategy == STRAT_RUNAHEAD) {
+        harg = (helper_arg_t){
+            .cpu_id = HT_PAIRS[0][1], .is_tree = is_tree, .root = root, .passes = passes,
+            .progress = &progress, .done = &done, .ready = &ready, .start = &start
+        };
+        pthread_create(&helper, NULL, helper_thread, &harg);
+        while (ready < 1) usleep(100);
+        publish = &progress;
+    }
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int pass = 0; pass < passes; pass++) {
+        if (is_tree) {
+            sum += tree_traverse(root, strategy, publish, &visited);
+        } else {
+            sum += list_traverse(root, strategy, publish, &visited);
+        }
+    }
+    double elapsed = get_time_sec() - t0;
+
+    if (strategy == STRAT_RUNAHEAD) {
+        done = 1;
+        pthread_join(helper, NULL);
+    }
+    sink += sum;
+    return elapsed / ((double)passes * n) * 1e9;
+}
+
+static void run_structure(int is_tree) {
+    static const size_t sizes[] = {SMALL_NODES, LARGE_NODES};
+    double results[NUM_ORDERS][NUM_STRATEGIES][2];
+
+    size_t *slots = malloc(LARGE_NODES * sizeof(size_t));
+    tnode_t **preorder = malloc(LARGE_NODES * sizeof(tnode_t *));
+    void *pool = aligned_alloc(CACHE_LINE_SIZE, LARGE_NODES * CACHE_LINE_SIZE);
+    if (!slots || !preorder || !pool) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+
+    for (int s = 0; s < 2; s++) {
+        size_t n = sizes[s];
+        for (int order = 0; order < NUM_ORDERS; order++) {
+            const void *root;
+            make_slots(slots, n, (alloc_order_t)order);
+            if (is_tree) {
+                root = build_tree(pool, slots, preorder, n);
+            } else {
+                root = build_list(pool, slots, n);
+            }
+            for (int strat = 0; strat < NUM_STRATEGIES; strat++) {
+                results[order][strat][s] = measure(is_tree, root, n, (strategy_t)strat);
+            }
+        }
+    }
+
+    printf("\n=== %s Traversal (ns/node) ===\n", is_tree ? "Binary Tree (preorder DFS)"
+                                                     : "Linked List");
+    printf("%-11s %-10s %14s %14s\n", "Order", "Strategy", "16K (1MB)", "1M (64MB)");
+    printf("-------------------------------------------------------\n");
+    for (int order = 0; order < NUM_ORDERS; order++) {
+        for (int strat = 0; strat < NUM_STRATEGIES; strat++) {
+            printf("%-11s %-10s %14.2f %14.2f\n", order_names[order], strategy_names[strat],
+                   results[order][strat][0], results[order][strat][1]);
+        }
+    }
+
+    free(slots);
+    free(preorder);
+    free(pool);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+
+    printf("=== Linked Structure Traversal Benchmark ===\n");
+    printf("Node size: %d bytes, work per node: %d dependent multiply-adds\n",
+           CACHE_LINE_SIZE, WORK_ROUNDS);
+    printf("Jump distance: %d nodes, run-ahead window: %d nodes (helper on CPU %d)\n",
+           JUMP_DISTANCE, RUNAHEAD_WINDOW, HT_PAIRS[0][1]);
+
+    bind_to_cpu(HT_PAIRS[0][0]);
+
+    if (strcmp(mode, "--list") == 0) {
+        run_structure(0);
+    } else if (strcmp(mode, "--tree") == 0) {
+        run_structure(1);
+    } else if (strcmp(mode, "--all") == 0) {
+        run_structure(0);
+        run_structure(1);
+
+        printf("\n=== Analysis ===\n");
+        printf("- sequential: the hardware prefetcher already hides latency;\n");
+        printf("  software prefetch only adds instructions\n");
+        printf("- greedy only hides the latency of one node's work: enough in L2,\n");
+        printf("  not for DRAM (list next is needed immediately)\n");
+        printf("- jump pointers prefetch %d nodes ahead: best for random/clustered\n",
+               JUMP_DISTANCE);
+        printf("  large structures, at the cost of 8 bytes per node and rebuilds\n");
+        printf("  on insert/delete\n");
+        printf("- run-ahead needs no layout change but competes with the main thread\n");
+        printf("  for the core; it helps when per-node work leaves the miss queue idle\n");
+    } else {
+        printf("Usage: %s [--list | --tree | --all]\n", argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
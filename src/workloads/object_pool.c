@@ -0,0 +1,334 @@
+/*
+ * object_pool.c - 定长对象池 vs malloc
+ *
+ * 服务中的请求对象是 64-256 字节的定长结构，每个请求分配、释放一次，
+ * 而且经常由一个线程分配、另一个线程释放。本测试比较 malloc 与
+ * common/object_pool.h（每 CPU 弹匣 + 无锁 depot，对象按缓存行对齐）：
+ *
+ *   local    每线程批量分配 32 个对象、写入，再释放最早的 32 个（窗口 256）；
+ *            pool-bulk 使用 obj_pool_alloc_bulk / obj_pool_free_bulk
+ *   handoff  线程 t 分配并写入对象，通过 SPSC 环交给线程 t+1，由它写入并释放；
+ *            pool 中释放的对象进入消费者自己的弹匣，多余的以整个弹匣为单位经
+ *            depot 流转；malloc 中相邻对象可能同时被生产者和消费者写（伪共享）
+ *
+ * 编译: gcc -O2 -pthread -o object_pool object_pool.c
+ * 运行: ./object_pool [--local | --handoff | --all] [--threads N] [--ops M]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+#include "../common/object_pool.h"
+
+// 配置参数
+#define MAX_THREADS NUM_HW_THREADS
+#define DEFAULT_OPS 4000000               // 每线程操作数（分配 + 释放）
+#define BATCH 32
+#define WINDOW 256                        // local 场景每线程存活对象数
+#define RING_SIZE 1024                    // handoff 场景 SPSC 环大小
+#define POOL_OBJECTS (1024 * 1024)        // 对象池容量（按需分配物理页）
+
+static const size_t object_sizes[] = {64, 128, 256};
+#define NUM_SIZES (sizeof(object_sizes) / sizeof(object_sizes[0]))
+
+typedef enum { M_MALLOC, M_POOL, M_POOL_BULK, NUM_METHODS } method_t;
+static const char *method_names[NUM_METHODS] = {"malloc", "pool", "bulk"};
+
+typedef struct {
+    CACHE_PADDED(volatile uint32_t, head);
+    CACHE_PADDED(volatile uint32_t, tail);
+    void *slots[RING_SIZE];
+} spsc_ring_t;
+
+typedef struct {
+    method_t method;
+    size_t size;
+    int nthreads;
+    long ops;
+    obj_pool_t *pool;
+    spsc_ring_t *rings;       // handoff：环 t 由线程 t 写入、线程 t+1 读取
+} bench_ctx_t;
+
+typedef struct {
+    int cpu_id;
+    int tid;
+    bench_ctx_t *ctx;
+    long done;
+    uint64_t check;
+    volatile int *ready;
+    volatile int *start;
+} thread_arg_t;
+
+static inline void *obj_alloc(bench_ctx_t *ctx, op_cache_t *c) {
+    return ctx->method == M_MALLOC ? malloc(ctx->size) : obj_pool_alloc(c);
+}
+
+static inline void obj_free(bench_ctx_t *ctx, op_cache_t *c, void *p) {
+    if (ctx->method == M_MALLOC) {
+        free(p);
+    } else {
+        obj_pool_free(c, p);
+    }
+}
+
+// 写入对象的首尾缓存行，模拟填充请求
+static inline void obj_touch(void *p, size_t size, uint64_t v) {
+    ((volatile uint64_t *)p)[0] = v;
+    ((volatile uint64_t *)p)[size / sizeof(uint64_t) - 1] = v;
+}
+
+static void local_worker(thread_arg_t *targ, op_cache_t *c) {
+    bench_ctx_t *ctx = targ->ctx;
+    void *window[WINDOW];
+    long rounds = ctx->ops / (2 * BATCH);
+    int head = 0;
+
+    for (int i = 0; i < WINDOW; i++) {
+        window[i] = obj_alloc(ctx, c);
+        obj_touch(window[i], ctx->size, i);
+    }
+    // window 作为 FIFO：每轮释放最早的 BATCH 个，再在同一位置分配 BATCH 个
+    for (long r = 0; r < rounds; r++) {
+        void **slot = &window[head];
+        if (ctx->method == M_POOL_BULK) {
+            obj_pool_free_bulk(c, slot, BATCH);
+            obj_pool_alloc_bulk(c, slot, BATCH);
+        } else {
+            for (int i = 0; i < BATCH; i++) obj_free(ctx, c, slot[i]);
+            for (int i = 0; i < BATCH; i++) slot[i] = obj_alloc(ctx, c);
+        }
+        for (int i = 0; i < BATCH; i++) obj_touch(slot[i], ctx->size, r);
+        head = (head + BATCH) % WINDOW;
+    }
+    for (int i = 0; i < WINDOW; i++) obj_free(ctx, c, window[i]);
+    targ->done = rounds * 2 * BATCH;
+}
+
+// 环满/空时自旋，过久则让出 CPU（线程数超过 CPU 数时对端才能运行）
+static inline void spin_pause(int spins) {
+    if (spins < 1024) {
+        __builtin_ia32_pause();
+    } else {
+        sched_yield();
+    }
+}
+
+static void handoff_worker(thread_arg_t *targ, op_cache_t *c) {
+    bench_ctx_t *ctx = targ->ctx;
+    spsc_ring_t *out = &ctx->rings[targ->tid];
+    spsc_ring_t *in = &ctx->rings[(targ->tid + ctx->nthreads - 1) % ctx->nthreads];
+    long items = ctx->ops / 2, produced = 0, consumed = 0;
+    uint64_t check = 0;
+    int spins = 0;
+
+    while (produced < items || consumed < items) {
+        int progress = 0;
+
+        // 生产：最多一批
+        uint32_t head = out->head.value;
+        uint32_t space = RING_SIZE - (head - __atomic_load_n(&out->tail.value, __ATOMIC_ACQUIRE));
+        for (uint32_t i = 0; i < space && i < BATCH && produced < items; i++) {
+            uint64_t *p = obj_alloc(ctx, c);
+            obj_touch(p, ctx->size, produced);
+            out->slots[head++ % RING_SIZE] = p;
+            produced++;
+            progress = 1;
+        }
+        __atomic_store_n(&out->head.value, head, __ATOMIC_RELEASE);
+
+        // 消费：取走所有可用的
+        uint32_t tail = in->tail.value;
+        uint32_t avail = __atomic_load_n(&in->head.value, __ATOMIC_ACQUIRE) - tail;
+        for (uint32_t i = 0; i < avail; i++) {
+            uint64_t *p = in->slots[tail++ % RING_SIZE];
+            check += p[0];
+            obj_touch(p, ctx->size, 0);
+            obj_free(ctx, c, p);
+            consumed++;
+            progress = 1;
+        }
+        __atomic_store_n(&in->tail.value, tail, __ATOMIC_RELEASE);
+
+        spins = progress ? 0 : spins + 1;
+        if (!progress) spin_pause(spins);
+    }
+    targ->done = produced + consumed;
+    targ->check = check;
+}
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+    bench_ctx_t *ctx = targ->ctx;
+    op_cache_t *c = ctx->pool ? obj_pool_cache(ctx->pool, targ->tid) : NULL;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    if (ctx->rings) {
+        handoff_worker(targ, c);
+    } else {
+        local_worker(targ, c);
+    }
+    if (c) obj_pool_cache_flush(c);
+    return NULL;
+}
+
+// 返回 M ops/s；*ok 为 handoff 的校验结果
+static double run_case(method_t method, size_t size, int nthreads, long ops, int handoff,
+                       int *ok) {
+    pthread_t threads[MAX_THREADS];
+    thread_arg_t args[MAX_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+    obj_pool_t pool;
+    bench_ctx_t ctx = {.method = method, .size = size, .nthreads = nthreads, .ops = ops};
+
+    *ok = 1;
+    if (method != M_MALLOC) {
+        if (obj_pool_init(&pool, size, POOL_OBJECTS, nthreads) != 0) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+        ctx.pool = &pool;
+    }
+    if (handoff) {
+        ctx.rings = aligned_alloc(CACHE_LINE_SIZE, nthreads * sizeof(spsc_ring_t));
+        if (!ctx.rings) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+        memset(ctx.rings, 0, nthreads * sizeof(spsc_ring_t));
+    }
+
+    for (int t = 0; t < nthreads; t++) {
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, PLACE_SPREAD), .tid = t, .ctx = &ctx,
+            .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < nthreads) usleep(100);
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+    double elapsed = get_time_sec() - t0;
+
+    long total = 0;
+    uint64_t items = ops / 2;
+    for (int t = 0; t < nthreads; t++) {
+        total += args[t].done;
+        if (handoff) *ok &= args[t].check == items * (items - 1) / 2;
+    }
+
+    free(ctx.rings);
+    if (ctx.pool) obj_pool_destroy(&pool);
+    return total / elapsed / 1e6;
+}
+
+static void run_scenario(int handoff, int max_threads, long ops) {
+    int nmethods = handoff ? M_POOL + 1 : NUM_METHODS;
+
+    if (handoff) {
+        printf("\n=== Handoff: allocate on thread t, free on thread t+1 (ring of %d) ===\n",
+               RING_SIZE);
+    } else {
+        printf("\n=== Local: free %d oldest + allocate %d, window %d per thread ===\n",
+               BATCH, BATCH, WINDOW);
+    }
+    printf("M ops/s (allocations + frees), threads placed spread\n");
+    printf("%-8s", "");
+    for (size_t s = 0; s < NUM_SIZES; s++) {
+        printf(" | %*zu B", nmethods * 8 - 2, object_sizes[s]);
+    }
+    printf("\n%-8s", "Threads");
+    for (size_t s = 0; s < NUM_SIZES; s++) {
+        printf(" |");
+        for (int m = 0; m < nmethods; m++) printf(" %7s", method_names[m]);
+    }
+    printf("  Check\n");
+    printf("---------------------------------------------------------------------------------\n");
+
+    for (int nt = 1; nt <= max_threads; nt = nt < max_threads && nt * 2 > max_threads
+                                             ? max_threads : nt * 2) {
+        int ok = 1;
+        printf("%-8d", nt);
+        for (size_t s = 0; s < NUM_SIZES; s++) {
+            printf(" |");
+            for (int m = 0; m < nmethods; m++) {
+                int case_ok;
+                printf(" %7.1f", run_case((method_t)m, object_sizes[s], nt, ops, handoff,
+                                          &case_ok));
+                ok &= case_ok;
+                fflush(stdout);
+            }
+        }
+        printf("  %s\n", ok ? "OK" : "FAIL");
+        if (nt == max_threads) break;
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--local | --handoff | --all] [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --threads N   Maximum threads (default %d)\n", NUM_HW_THREADS);
+    printf("  --ops M       Operations per thread (default %d)\n", DEFAULT_OPS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    int max_threads = NUM_HW_THREADS;
+    long ops = DEFAULT_OPS;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            max_threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--ops") == 0) {
+            ops = atol(argv[i + 1]);
+        }
+    }
+    if (max_threads < 1 || max_threads > MAX_THREADS || ops < 4 * BATCH) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("=== Object Pool Benchmark: per-CPU magazines vs malloc ===\n");
+    printf("Magazine: %d objects, objects rounded up to %d-byte lines, ops per thread: %ld\n",
+           OP_MAG_SIZE, CACHE_LINE_SIZE, ops);
+
+    if (strcmp(mode, "--local") == 0) {
+        run_scenario(0, max_threads, ops);
+    } else if (strcmp(mode, "--handoff") == 0) {
+        run_scenario(1, max_threads, ops);
+    } else if (strcmp(mode, "--all") == 0) {
+        run_scenario(0, max_threads, ops);
+        run_scenario(1, max_threads, ops);
+
+        printf("\n=== Analysis ===\n");
+        printf("- local: the pool fast path is an index decrement in a per-CPU magazine;\n");
+        printf("  bulk moves a whole batch with one memcpy\n");
+        printf("- handoff: remote frees land in the consumer's own magazines and are\n");
+        printf("  reused for what it produces; any surplus moves through the depot a\n");
+        printf("  magazine at a time, so shared atomics cost once per %d objects, while\n",
+               OP_MAG_SIZE);
+        printf("  malloc pays for every remote free\n");
+        printf("- line-aligned objects keep producer and consumer writes on different\n");
+        printf("  lines; malloc packs 64 B requests into 80 B chunks that straddle lines\n");
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,875 @@
+/*
+ * parallel_sort.c - 缓存友好的并行排序
+ *
+ * 排序的访问模式是其它测试没有覆盖的：基数排序每趟一次顺序读 + 256 路分散写，
+ * 归并排序每趟一次顺序读写，趟数与缓存大小的关系决定内存流量。
+ *
+ * 算法：
+ *   qsort        libc qsort，单线程基线
+ *   lsd-radix    8 位一趟，从低位到高位；每趟线程各自做直方图，前缀和后分散写，
+ *                分散写用每桶一条缓存行的软件写合并缓冲 + 非临时存储
+ *                （与 radix_partition.c 相同）
+ *   msd-radix    最高 8 位一趟并行分区，之后各桶由线程动态领取递归细分，
+ *                桶小于 L2 后改用普通分散写，<= 64 个元素用插入排序；
+ *                随机 64 位键通常 3~4 层就结束，而 LSD 必须做满 8 趟
+ *   simd-merge   AVX2 排序网络生成有序小段（8x8 u32 / 4x4 u64 列排序 + 转置），
+ *                双调合并网络做向量化归并；先在 L2 大小的段内排好（不出缓存），
+ *                再做跨段归并，线程之间用 merge path 把每趟归并均分给所有线程
+ *
+ * 键类型：u32、u64、kv（高 32 位键 + 低 32 位载荷，基数排序只处理键的 4 个字节）。
+ * 报告 M keys/s 以及访问内存的趟数对应的流量（字节/键，只计数据量大于 L2 的趟）。
+ *
+ * 编译: gcc -O2 -pthread -o parallel_sort parallel_sort.c
+ * 运行: ./parallel_sort [--u32 | --u64 | --kv | --all] [--n N] [--threads N]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define RADIX_BITS 8
+#define RADIX (1 << RADIX_BITS)
+#define SMALL_SORT 64               // MSD 桶小于等于此值时插入排序
+#define L2_SIZE (1024 * 1024)       // 小于 L2 的趟不用非临时存储，也不计入流量
+#define SEGMENT_BYTES (256 * 1024)  // 归并排序段内排序的大小
+#define BLOCK 64                    // 数组按 BLOCK * 线程数 补齐（归并排序）
+#define CHECK_KEYS (4 * 1024 * 1024)  // MSD 大桶校验的键数
+#define MAX_THREADS NUM_HW_THREADS
+
+typedef enum { T_U32, T_U64, T_KV, NUM_TYPES } key_type_t;
+typedef enum { A_QSORT, A_LSD, A_MSD, A_MERGE, NUM_ALGOS } algo_t;
+
+static const char *type_names[NUM_TYPES] = {"u32", "u64", "kv (u32 key + u32 payload)"};
+static const char *algo_names[NUM_ALGOS] = {"qsort", "lsd-radix", "msd-radix", "simd-merge"};
+
+static int has_avx2;
+
+typedef struct {
+    size_t pos[RADIX];
+    size_t start[RADIX];
+    CACHE_ALIGNED char wc[RADIX][CACHE_LINE_SIZE];  // 软件写合并缓冲
+    uint64_t bytes;                                 // 访问内存的流量
+} scratch_t;
+
+// ---------------------------------------------------------------
+// 类型相关的基本操作（u32 / u64 各生成一份）
+// ---------------------------------------------------------------
+
+#define DEFINE_PRIMITIVES(sfx, T) \
+static void sfx##_insertion(T *a, size_t n) { \
+    for (size_t i = 1; i < n; i++) { \
+        T x = a[i]; \
+        size_t j = i; \
+        while (j > 0 && a[j - 1] > x) { \
+            a[j] = a[j - 1]; \
+            j--; \
+        } \
+        a[j] = x; \
+    } \
+} \
+static void sfx##_merge_scalar(const void *a_, size_t na, const void *b_, size_t nb, \
+                               void *out_) { \
+    const T *a = a_, *b = b_; \
+    T *out = out_; \
+    size_t i = 0, j = 0; \
+    while (i < na && j < nb) { \
+        T x = a[i], y = b[j]; \
+        int take_b = y < x; \
+        *out++ = take_b ? y : x; \
+        i += !take_b; \
+        j += take_b; \
+    } \
+    memcpy(out, a + i, (na - i) * sizeof(T)); \
+    memcpy(out + (na - i), b + j, (nb - j) * sizeof(T)); \
+} \
+/* 三路合并：向量归并结束时寄存器里剩下的一段与两个输入的余下部分 */ \
+static void sfx##_merge3(const T *x, size_t nx, const T *a, size_t na, const T *b, \
+                         size_t nb, T *out) { \
+    size_t i = 0, j = 0, k = 0; \
+    while (i < nx || j < na || k < nb) { \
+        int pick = -1; \
+        T best = 0; \
+        if (i < nx) { best = x[i]; pick = 0; } \
+        if (j < na && (pick < 0 || a[j] < best)) { best = a[j]; pick = 1; } \
+        if (k < nb && (pick < 0 || b[k] < best)) { best = b[k]; pick = 2; } \
+        *out++ = best; \
+        i += pick == 0; \
+        j += pick == 1; \
+        k += pick == 2; \
+    } \
+} \
+/* 每 32 字节（与 AVX2 版本相同的段长）插入排序，生成有序小段 */ \
+static void sfx##_run_form_scalar(const void *src, void *dst, size_t n) { \
+    if (src != dst) memcpy(dst, src, n * sizeof(T)); \
+    for (size_t i = 0; i < n; i += 32 / sizeof(T)) { \
+        sfx##_insertion((T *)dst + i, 32 / sizeof(T)); \
+    } \
+} \
+/* merge path：合并结果的前 k 个元素中有几个来自 a */ \
+static size_t sfx##_corank(size_t k, const void *a_, size_t na, const void *b_, size_t nb) { \
+    const T *a = a_, *b = b_; \
+    size_t lo = k > nb ? k - nb : 0, hi = k < na ? k : na; \
+    while (lo < hi) { \
+        size_t i = (lo + hi) / 2, j = k - i; \
+        if (a[i] <= b[j - 1]) lo = i + 1; \
+        else hi = i; \
+    } \
+    return lo; \
+} \
+static void sfx##_hist(const void *in_, size_t n, int shift, size_t *hist) { \
+    const T *in = in_; \
+    memset(hist, 0, RADIX * sizeof(size_t)); \
+    for (size_t i = 0; i < n; i++) hist[(in[i] >> shift) & (RADIX - 1)]++; \
+} \
+/* \
+ * 按 s->pos 分散写。缓冲槽位与输出的绝对缓存行对齐，整行用非临时存储写出； \
+ * 起点之前的槽位属于别的线程/桶，首尾不完整的行用普通存储。 \
+ */ \
+static void sfx##_scatter(const void *in_, size_t n, void *out_, int shift, scratch_t *s) { \
+    enum { PER_LINE = CACHE_LINE_SIZE / sizeof(T) }; \
+    const T *in = in_; \
+    T *out = out_; \
+    size_t *pos = s->pos; \
+    if (n * sizeof(T) < L2_SIZE) { \
+        for (size_t i = 0; i < n; i++) out[pos[(in[i] >> shift) & (RADIX - 1)]++] = in[i]; \
+        return; \
+    } \
+    T (*wc)[PER_LINE] = (T (*)[PER_LINE])s->wc; \
+    size_t a0 = (uintptr_t)out / sizeof(T) % PER_LINE; \
+    memcpy(s->start, pos, sizeof(s->start)); \
+    for (size_t i = 0; i < n; i++) { \
+        size_t d = (in[i] >> shift) & (RADIX - 1); \
+        size_t e = pos[d]++, slot = (e + a0) % PER_LINE; \
+        wc[d][slot] = in[i]; \
+        if (slot == PER_LINE - 1) { \
+            /* out 不按缓存行对齐时，开头的行可能在 out 之前开始 */ \
+            if (e + 1 >= PER_LINE && e + 1 - PER_LINE >= s->start[d]) { \
+                size_t line = e + 1 - PER_LINE; \
+                const __m128i *src = (const __m128i *)wc[d]; \
+                __m128i *dst = (__m128i *)(out + line); \
+                _mm_stream_si128(dst + 0, _mm_load_si128(src + 0)); \
+                _mm_stream_si128(dst + 1, _mm_load_si128(src + 1)); \
+                _mm_stream_si128(dst + 2, _mm_load_si128(src + 2)); \
+                _mm_stream_si128(dst + 3, _mm_load_si128(src + 3)); \
+            } else { \
+                for (size_t j = s->start[d]; j <= e; j++) out[j] = wc[d][(j + a0) % PER_LINE]; \
+            } \
+        } \
+    } \
+    for (size_t d = 0; d < RADIX; d++) { \
+        size_t e = pos[d], tail = (e + a0) % PER_LINE; \
+        size_t from = e >= s->start[d] + tail ? e - tail : s->start[d]; \
+        for (size_t j = from; j < e; j++) out[j] = wc[d][(j + a0) % PER_LINE]; \
+    } \
+    _mm_sfence(); \
+} \
+/* \
+ * MSD 递归：数据在 cur，按第 digit 字节分到 other，再对各桶递归到 last 字节。 \
+ * cur_is_orig 表示 cur 是否为原数组；结果最终必须落在原数组中。 \
+ */ \
+static void sfx##_msd(T *cur, T *other, size_t n, int digit, int last, int cur_is_orig, \
+                      scratch_t *s) { \
+    if (n <= SMALL_SORT) { \
+        sfx##_insertion(cur, n); \
+        if (!cur_is_orig) memcpy(other, cur, n * sizeof(T)); \
+        return; \
+    } \
+    size_t count[RADIX]; \
+    sfx##_hist(cur, n, digit * RADIX_BITS, count); \
+    if (n * sizeof(T) >= L2_SIZE) s->bytes += 3 * n * sizeof(T); \
+    for (int d = 0; d < RADIX; d++) { \
+        if (count[d] == n) { /* 这一字节全部相同，跳过 */ \
+            if (digit == last) { \
+                if (!cur_is_orig) memcpy(other, cur, n * sizeof(T)); \
+            } else { \
+                sfx##_msd(cur, other, n, digit - 1, last, cur_is_orig, s); \
+            } \
+            return; \
+        } \
+    } \
+    size_t off = 0; \
+    for (int d = 0; d < RADIX; d++) { \
+        s->pos[d] = off; \
+        off += count[d]; \
+    } \
+    sfx##_scatter(cur, n, other, digit * RADIX_BITS, s); \
+    off = 0; \
+    for (int d = 0; d < RADIX; d++) { \
+        size_t c = count[d]; \
+        if (c > 0 && digit == last) { \
+            if (cur_is_orig) memcpy(cur + off, other + off, c * sizeof(T)); \
+        } else if (c > 0) { \
+            sfx##_msd(other + off, cur + off, c, digit - 1, last, !cur_is_orig, s); \
+        } \
+        off += c; \
+    } \
+}
+
+DEFINE_PRIMITIVES(u32, uint32_t)
+DEFINE_PRIMITIVES(u64, uint64_t)
+
+// ---------------------------------------------------------------
+// AVX2 排序网络与双调合并
+// ---------------------------------------------------------------
+
+// 双调序列排序（8 x u32）：距离 4、2、1 的半清洗器
+__attribute__((target("avx2")))
+static inline __m256i bitonic8_u32(__m256i v) {
+    __m256i t = _mm256_permute2x128_si256(v, v, 0x01);
+    v = _mm256_blend_epi32(_mm256_min_epu32(v, t), _mm256_max_epu32(v, t), 0xF0);
+    t = _mm256_shuffle_epi32(v, 0x4E);
+    v = _mm256_blend_epi32(_mm256_min_epu32(v, t), _mm256_max_epu32(v, t), 0xCC);
+    t = _mm256_shuffle_epi32(v, 0xB1);
+    return _mm256_blend_epi32(_mm256_min_epu32(v, t), _mm256_max_epu32(v, t), 0xAA);
+}
+
+// 两个有序向量合并：*a 得到较小的 8 个，*b 得到较大的 8 个
+__attribute__((target("avx2")))
+static inline void merge8_u32(__m256i *a, __m256i *b) {
+    __m256i rb = _mm256_permutevar8x32_epi32(*b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    __m256i lo = _mm256_min_epu32(*a, rb), hi = _mm256_max_epu32(*a, rb);
+    *a = bitonic8_u32(lo);
+    *b = bitonic8_u32(hi);
+}
+
+#define CMPSWAP_U32(x, y) do { \
+    __m256i _t = _mm256_min_epu32(x, y); \
+    y = _mm256_max_epu32(x, y); \
+    x = _t; \
+} while (0)
+
+// 每 64 个元素：8 个向量按列做 Batcher 奇偶归并网络（19 个比较器），转置后得到 8 段有序的 8 元素
+__attribute__((target("avx2")))
+static void u32_run_form_avx2(const void *src_, void *dst_, size_t n) {
+    const uint32_t *src = src_;
+    uint32_t *dst = dst_;
+    for (size_t i = 0; i < n; i += 64) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *)(src + i + 16));
+        __m256i v3 = _mm256_loadu_si256((const __m256i *)(src + i + 24));
+        __m256i v4 = _mm256_loadu_si256((const __m256i *)(src + i + 32));
+        __m256i v5 = _mm256_loadu_si256((const __m256i *)(src + i + 40));
+        __m256i v6 = _mm256_loadu_si256((const __m256i *)(src + i + 48));
+        __m256i v7 = _mm256_loadu_si256((const __m256i *)(src + i + 56));
+        CMPSWAP_U32(v0, v1); CMPSWAP_U32(v2, v3); CMPSWAP_U32(v4, v5); CMPSWAP_U32(v6, v7);
+        CMPSWAP_U32(v0, v2); CMPSWAP_U32(v1, v3); CMPSWAP_U32(v4, v6); CMPSWAP_U32(v5, v7);
+        CMPSWAP_U32(v1, v2); CMPSWAP_U32(v5, v6);
+        CMPSWAP_U32(v0, v4); CMPSWAP_U32(v1, v5); CMPSWAP_U32(v2, v6); CMPSWAP_U32(v3, v7);
+        CMPSWAP_U32(v2, v4); CMPSWAP_U32(v3, v5);
+        CMPSWAP_U32(v1, v2); CMPSWAP_U32(v3, v4); CMPSWAP_U32(v5, v6);
+
+        __m256i t0 = _mm256_unpacklo_epi32(v0, v1), t1 = _mm256_unpackhi_epi32(v0, v1);
+        __m256i t2 = _mm256_unpacklo_epi32(v2, v3), t3 = _mm256_unpackhi_epi32(v2, v3);
+        __m256i t4 = _mm256_unpacklo_epi32(v4, v5), t5 = _mm256_unpackhi_epi32(v4, v5);
+        __m256i t6 = _mm256_unpacklo_epi32(v6, v7), t7 = _mm256_unpackhi_epi32(v6, v7);
+        __m256i u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+        __m256i u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+        __m256i u4 = _mm256_unpacklo_epi64(t4, t6), u5 = _mm256_unpackhi_epi64(t4, t6);
+        __m256i u6 = _mm256_unpacklo_epi64(t5, t7), u7 = _mm256_unpackhi_epi64(t5, t7);
+        __m256i *out = (__m256i *)(dst + i);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(u0, u4, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(u1, u5, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(u2, u6, 0x20));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(u3, u7, 0x20));
+        _mm256_storeu_si256(out + 4, _mm256_permute2x128_si256(u0, u4, 0x31));
+        _mm256_storeu_si256(out + 5, _mm256_permute2x128_si256(u1, u5, 0x31));
+        _mm256_storeu_si256(out + 6, _mm256_permute2x128_si256(u2, u6, 0x31));
+        _mm256_storeu_si256(out + 7, _mm256_permute2x128_si256(u3, u7, 0x31));
+    }
+}
+
+// 无符号 64 位比较：翻转符号位后用有符号比较
+__attribute__((target("avx2")))
+static inline void minmax_u64(__m256i x, __m256i y, __m256i *mn, __m256i *mx) {
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(y, sign));
+    *mn = _mm256_blendv_epi8(x, y, gt);
+    *mx = _mm256_blendv_epi8(y, x, gt);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i bitonic4_u64(__m256i v) {
+    __m256i mn, mx;
+    minmax_u64(v, _mm256_permute4x64_epi64(v, 0x4E), &mn, &mx);
+    v = _mm256_blend_epi32(mn, mx, 0xF0);
+    minmax_u64(v, _mm256_permute4x64_epi64(v, 0xB1), &mn, &mx);
+    return _mm256_blend_epi32(mn, mx, 0xCC);
+}
+
+__attribute__((target("avx2")))
+static inline void merge4_u64(__m256i *a, __m256i *b) {
+    __m256i lo, hi;
+    minmax_u64(*a, _mm256_permute4x64_epi64(*b, 0x1B), &lo, &hi);
+    *a = bitonic4_u64(lo);
+    *b = bitonic4_u64(hi);
+}
+
+// 每 16 个元素：4 个向量按列排序（5 个比较器），转置后得到 4 段有序的 4 元素
+__attribute__((target("avx2")))
+static void u64_run_form_avx2(const void *src_, void *dst_, size_t n) {
+    const uint64_t *src = src_;
+    uint64_t *dst = dst_;
+    for (size_t i = 0; i < n; i += 16) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(src + i + 4));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+        __m256i v3 = _mm256_loadu_si256((const __m256i *)(src + i + 12));
+        minmax_u64(v0, v1, &v0, &v1);
+        minmax_u64(v2, v3, &v2, &v3);
+        minmax_u64(v0, v2, &v0, &v2);
+        minmax_u64(v1, v3, &v1, &v3);
+        minmax_u64(v1, v2, &v1, &v2);
+
+        __m256i t0 = _mm256_unpacklo_epi64(v0, v1), t1 = _mm256_unpackhi_epi64(v0, v1);
+        __m256i t2 = _mm256_unpacklo_epi64(v2, v3), t3 = _mm256_unpackhi_epi64(v2, v3);
+        __m256i *out = (__m256i *)(dst + i);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(t0, t2, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(t1, t3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(t0, t2, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(t1, t3, 0x31));
+    }
+}
+
+/*
+ * 向量化归并：寄存器里保留较大的 W 个元素，每次从首元素较小的一侧读入 W 个，
+ * 双调合并后写出较小的 W 个。任一侧不足 W 个时，余下部分做三路标量合并。
+ */
+#define DEFINE_SIMD_MERGE(sfx, T, W, MERGE_VEC) \
+__attribute__((target("avx2"))) \
+static void sfx##_merge_avx2(const void *a_, size_t na, const void *b_, size_t nb, \
+                             void *out_) { \
+    const T *a = a_, *b = b_; \
+    T *out = out_; \
+    if (na < W || nb < W) { \
+        sfx##_merge_scalar(a, na, b, nb, out); \
+        return; \
+    } \
+    __m256i v = _mm256_loadu_si256((const __m256i *)a); \
+    __m256i nv = _mm256_loadu_si256((const __m256i *)b); \
+    size_t ia = W, ib = W; \
+    MERGE_VEC(&v, &nv); \
+    _mm256_storeu_si256((__m256i *)out, v); \
+    out += W; \
+    v = nv; \
+    while (ia + W <= na && ib + W <= nb) { \
+        int take_a = a[ia] <= b[ib];  /* 无分支选择，避免 50% 的误预测 */ \
+        nv = _mm256_loadu_si256((const __m256i *)(take_a ? a + ia : b + ib)); \
+        ia += take_a * W; \
+        ib += (!take_a) * W; \
+        MERGE_VEC(&nv, &v); \
+        _mm256_storeu_si256((__m256i *)out, nv); \
+        out += W; \
+    } \
+    T rest[W]; \
+    _mm256_storeu_si256((__m256i *)rest, v); \
+    sfx##_merge3(rest, W, a + ia, na - ia, b + ib, nb - ib, out); \
+}
+
+DEFINE_SIMD_MERGE(u32, uint32_t, 8, merge8_u32)
+DEFINE_SIMD_MERGE(u64, uint64_t, 4, merge4_u64)
+
+// ---------------------------------------------------------------
+// 按类型分派
+// ---------------------------------------------------------------
+
+typedef struct {
+    size_t size;
+    int run;             // run_form 之后的有序段长度
+    int first_digit;     // 参与基数排序的字节
+    int last_digit;
+    int key_shift;       // 校验时的键：x >> key_shift
+    void (*run_form)(const void *src, void *dst, size_t n);
+    void (*merge)(const void *a, size_t na, const void *b, size_t nb, void *out);
+    size_t (*corank)(size_t k, const void *a, size_t na, const void *b, size_t nb);
+    void (*hist)(const void *in, size_t n, int shift, size_t *hist);
+    void (*scatter)(const void *in, size_t n, void *out, int shift, scratch_t *s);
+    void (*msd)(void *cur, void *other, size_t n, int digit, int last, int cur_is_orig,
+                scratch_t *s);
+    int (*cmp)(const void *a, const void *b);
+} sort_ops_t;
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void u32_msd_void(void *cur, void *other, size_t n, int digit, int last,
+                         int cur_is_orig, scratch_t *s) {
+    u32_msd(cur, other, n, digit, last, cur_is_orig, s);
+}
+
+static void u64_msd_void(void *cur, void *other, size_t n, int digit, int last,
+                         int cur_is_orig, scratch_t *s) {
+    u64_msd(cur, other, n, digit, last, cur_is_orig, s);
+}
+
+static sort_ops_t make_ops(key_type_t type) {
+    if (type == T_U32) {
+        return (sort_ops_t){
+            .size = 4, .run = 8, .first_digit = 0, .last_digit = 3, .key_shift = 0,
+            .run_form = has_avx2 ? u32_run_form_avx2 : u32_run_form_scalar,
+            .merge = has_avx2 ? u32_merge_avx2 : u32_merge_scalar,
+            .corank = u32_corank, .hist = u32_hist, .scatter = u32_scatter,
+            .msd = u32_msd_void, .cmp = cmp_u32
+        };
+    }
+    return (sort_ops_t){
+        .size = 8, .run = 4,
+        .first_digit = type == T_KV ? 4 : 0, .last_digit = 7,
+        .key_shift = type == T_KV ? 32 : 0,
+        .run_form = has_avx2 ? u64_run_form_avx2 : u64_run_form_scalar,
+        .merge = has_avx2 ? u64_merge_avx2 : u64_merge_scalar,
+        .corank = u64_corank, .hist = u64_hist, .scatter = u64_scatter,
+        .msd = u64_msd_void, .cmp = cmp_u64
+    };
+}
+
+// ---------------------------------------------------------------
+// 多线程驱动
+// ---------------------------------------------------------------
+
+typedef struct {
+    sort_ops_t ops;
+    algo_t algo;
+    char *data;
+    char *tmp;
+    size_t n;               // 实际元素数（基数排序）
+    size_t padded_n;        // 归并排序处理的元素数（尾部用最大值补齐）
+    int nthreads;
+    size_t hist[MAX_THREADS][RADIX];
+    volatile int next_bucket;
+    pthread_barrier_t barrier;
+} sort_ctx_t;
+
+typedef struct {
+    int cpu_id;
+    int tid;
+    sort_ctx_t *ctx;
+    scratch_t *scratch;
+    volatile int *ready;
+    volatile int *start;
+} thread_arg_t;
+
+static int ceil_log2(size_t x) {
+    int r = 0;
+    while (((size_t)1 << r) < x) r++;
+    return r;
+}
+
+// 一趟并行基数分区：src 的第 digit 字节 -> dst
+static void radix_pass(sort_ctx_t *c, int tid, scratch_t *s, const char *src, char *dst,
+                       int digit) {
+    const sort_ops_t *ops = &c->ops;
+    int nt = c->nthreads;
+    size_t lo = c->n * tid / nt, hi = c->n * (tid + 1) / nt;
+
+    ops->hist(src + lo * ops->size, hi - lo, digit * RADIX_BITS, c->hist[tid]);
+    pthread_barrier_wait(&c->barrier);
+
+    size_t base = 0;
+    for (int d = 0; d < RADIX; d++) {
+        size_t before = 0, total = 0;
+        for (int t = 0; t < nt; t++) {
+            if (t < tid) before += c->hist[t][d];
+            total += c->hist[t][d];
+        }
+        s->pos[d] = base + before;
+        base += total;
+    }
+    ops->scatter(src + lo * ops->size, hi - lo, dst, digit * RADIX_BITS, s);
+    s->bytes += 3 * (hi - lo) * ops->size;
+    pthread_barrier_wait(&c->barrier);
+}
+
+// 把 len 个元素按宽度 width 的有序段两两归并：src -> dst
+static void merge_pass(const sort_ops_t *ops, const char *src, char *dst, size_t len,
+                       size_t width) {
+    size_t sz = ops->size;
+    for (size_t i = 0; i < len; i += 2 * width) {
+        size_t na = len - i < width ? len - i : width;
+        size_t nb = len - i - na < width ? len - i - na : width;
+        if (nb == 0) {
+            memcpy(dst + i * sz, src + i * sz, na * sz);
+        } else {
+            ops->merge(src + i * sz, na, src + (i + na) * sz, nb, dst + i * sz);
+        }
+    }
+}
+
+static void merge_sort(sort_ctx_t *c, int tid, scratch_t *s) {
+    const sort_ops_t *ops = &c->ops;
+    size_t sz = ops->size, pn = c->padded_n;
+    int nt = c->nthreads;
+    size_t chunk = pn / nt, base = chunk * tid;
+    size_t seg = SEGMENT_BYTES / sz;
+    int rounds = ceil_log2(nt);
+    int seg_passes = ceil_log2((chunk + seg - 1) / seg);
+
+    // 按后续趟数的奇偶选择段内排序的目标缓冲，使最终结果落在 data 中
+    char *x = (seg_passes + rounds) % 2 == 0 ? c->data : c->tmp;
+#define OTHER(p) ((p) == c->data ? c->tmp : c->data)
+
+    // 1. 段内排序（不出 L2）
+    for (size_t s0 = 0; s0 < chunk; s0 += seg) {
+        size_t len = chunk - s0 < seg ? chunk - s0 : seg;
+        size_t off = (base + s0) * sz;
+        int passes = ceil_log2(len / ops->run);
+        char *y = passes % 2 == 0 ? x : OTHER(x);
+        ops->run_form(c->data + off, y + off, len);
+        for (size_t w = ops->run; w < len; w *= 2) {
+            merge_pass(ops, y + off, OTHER(y) + off, len, w);
+            y = OTHER(y);
+        }
+    }
+    s->bytes += 2 * chunk * sz;
+
+    // 2. 线程内跨段归并
+    char *src = x;
+    for (size_t w = seg; w < chunk; w *= 2) {
+        merge_pass(ops, src + base * sz, OTHER(src) + base * sz, chunk, w);
+        src = OTHER(src);
+        s->bytes += 2 * chunk * sz;
+    }
+
+    // 3. 线程间归并：每轮把所有输出均分给全部线程（merge path）
+    size_t o0 = pn * tid / nt, o1 = pn * (tid + 1) / nt;
+    for (int r = 0; r < rounds; r++) {
+        size_t group = chunk << (r + 1);
+        pthread_barrier_wait(&c->barrier);
+        for (size_t g = o0 / group; g * group < o1; g++) {
+            size_t gs = g * group;
+            size_t na = pn - gs < group / 2 ? pn - gs : group / 2;
+            size_t nb = pn - gs - na < group / 2 ? pn - gs - na : group / 2;
+            const char *a = src + gs * sz, *b = a + na * sz;
+            size_t lo = (o0 > gs ? o0 : gs) - gs;
+            size_t hi = (o1 < gs + na + nb ? o1 : gs + na + nb) - gs;
+            size_t i0 = ops->corank(lo, a, na, b, nb), i1 = ops->corank(hi, a, na, b, nb);
+            ops->merge(a + i0 * sz, i1 - i0, b + (lo - i0) * sz, (hi - i1) - (lo - i0),
+                       OTHER(src) + (gs + lo) * sz);
+        }
+        src = OTHER(src);
+        s->bytes += 2 * (o1 - o0) * sz;
+    }
+#undef OTHER
+}
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+    sort_ctx_t *c = targ->ctx;
+    scratch_t *s = targ->scratch;
+    const sort_ops_t *ops = &c->ops;
+    int tid = targ->tid;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    switch (c->algo) {
+    case A_QSORT:
+        qsort(c->data, c->n, ops->size, ops->cmp);
+        break;
+    case A_LSD:
+        // 趟数为偶数，结果回到 data
+        for (int d = ops->first_digit; d <= ops->last_digit; d++) {
+            int odd = (d - ops->first_digit) % 2;
+            radix_pass(c, tid, s, odd ? c->tmp : c->data, odd ? c->data : c->tmp, d);
+        }
+        break;
+    case A_MSD: {
+        int top = ops->last_digit;
+        radix_pass(c, tid, s, c->data, c->tmp, top);
+
+        size_t start[RADIX + 1];
+        start[0] = 0;
+        for (int d = 0; d < RADIX; d++) {
+            size_t total = 0;
+            for (int t = 0; t < c->nthreads; t++) total += c->hist[t][d];
+            start[d + 1] = start[d] + total;
+        }
+        for (;;) {
+            int d = __atomic_fetch_add(&c->next_bucket, 1, __ATOMIC_RELAXED);
+            if (d >= RADIX) break;
+            size_t cnt = start[d + 1] - start[d];
+            if (cnt == 0) continue;
+            ops->msd(c->tmp + start[d] * ops->size, c->data + start[d] * ops->size, cnt,
+                     top - 1, ops->first_digit, 0, s);
+        }
+        break;
+    }
+    case A_MERGE:
+        merge_sort(c, tid, s);
+        break;
+    default:
+        break;
+    }
+    return NULL;
+}
+
+// 按键有序，且元素集合与输入一致（求和校验）
+static int verify(const sort_ops_t *ops, const char *input, const char *out, size_t n) {
+    uint64_t sum_in = 0, sum_out = 0, prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t x, y;
+        if (ops->size == 4) {
+            x = ((const uint32_t *)input)[i];
+            y = ((const uint32_t *)out)[i];
+        } else {
+            x = ((const uint64_t *)input)[i];
+            y = ((const uint64_t *)out)[i];
+        }
+        sum_in += x * 0x9E3779B97F4A7C15ULL ^ (x >> 29);
+        sum_out += y * 0x9E3779B97F4A7C15ULL ^ (y >> 29);
+        if ((y >> ops->key_shift) < prev) return 0;
+        prev = y >> ops->key_shift;
+    }
+    return sum_in == sum_out;
+}
+
+typedef struct {
+    double mkeys;
+    double bytes_per_key;
+    int ok;
+} sort_result_t;
+
+static sort_result_t run_sort(const sort_ops_t *ops, algo_t algo, const char *input,
+                              char *data, char *tmp, size_t n, int nthreads,
+                              placement_t placement) {
+    sort_ctx_t *c = calloc(1, sizeof(sort_ctx_t));
+    scratch_t *scratch = aligned_alloc(CACHE_LINE_SIZE, MAX_THREADS * sizeof(scratch_t));
+    pthread_t threads[MAX_THREADS];
+    thread_arg_t args[MAX_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+    sort_result_t r = {0, 0, 0};
+
+    if (!c || !scratch) {
+        perror("Memory allocation failed");
+        exit(1);
+    }
+    if (algo == A_QSORT) nthreads = 1;
+    c->ops = *ops;
+    c->algo = algo;
+    c->data = data;
+    c->tmp = tmp;
+    c->n = n;
+    c->padded_n = (n + (size_t)BLOCK * nthreads - 1) / ((size_t)BLOCK * nthreads) *
+                  ((size_t)BLOCK * nthreads);
+    c->nthreads = nthreads;
+    memset(scratch, 0, MAX_THREADS * sizeof(scratch_t));
+
+    memcpy(data, input, n * ops->size);
+    memset(data + n * ops->size, 0xFF, (c->padded_n - n) * ops->size);
+
+    pthread_barrier_init(&c->barrier, NULL, nthreads);
+    for (int t = 0; t < nthreads; t++) {
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, placement), .tid = t, .ctx = c,
+            .scratch = &scratch[t], .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < nthreads) usleep(100);
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+    double elapsed = get_time_sec() - t0;
+
+    uint64_t bytes = 0;
+    for (int t = 0; t < nthreads; t++) bytes += scratch[t].bytes;
+    r.mkeys = n / elapsed / 1e6;
+    r.bytes_per_key = (double)bytes / n;
+    r.ok = verify(ops, input, data, n);
+
+    pthread_barrier_destroy(&c->barrier);
+    free(scratch);
+    free(c);
+    return r;
+}
+
+// 随机键；top_byte_mask 限制键最高字节的取值（0xFF 为均匀随机）
+static void fill_keys(key_type_t type, char *input, size_t n, uint8_t top_byte_mask) {
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    uint64_t mask = ((uint64_t)top_byte_mask << 56) | 0x00FFFFFFFFFFFFFFULL;
+    for (size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        if (type == T_U32) {
+            ((uint32_t *)input)[i] = (uint32_t)((x & mask) >> 32);
+        } else if (type == T_U64) {
+            ((uint64_t *)input)[i] = x & mask;
+        } else {
+            ((uint64_t *)input)[i] = (x & mask & 0xFFFFFFFF00000000ULL) | (uint32_t)i;
+        }
+    }
+}
+
+static int alloc_buffers(const sort_ops_t *ops, size_t n, char **input, char **data,
+                         char **tmp) {
+    size_t cap = n + (size_t)BLOCK * MAX_THREADS;
+    *input = malloc(n * ops->size);
+    *data = aligned_alloc(CACHE_LINE_SIZE, cap * ops->size);
+    *tmp = aligned_alloc(CACHE_LINE_SIZE, cap * ops->size);
+    if (!*input || !*data || !*tmp) {
+        perror("Memory allocation failed");
+        free(*input);
+        free(*data);
+        free(*tmp);
+        return -1;
+    }
+    memset(*data, 0, cap * ops->size);
+    memset(*tmp, 0, cap * ops->size);
+    return 0;
+}
+
+static int run_type(key_type_t type, size_t n, int nthreads) {
+    sort_ops_t ops = make_ops(type);
+    char *input, *data, *tmp;
+    if (alloc_buffers(&ops, n, &input, &data, &tmp) != 0) return 1;
+    fill_keys(type, input, n, 0xFF);
+
+    printf("\n=== %s keys, n = %zu (%zu MB) ===\n", type_names[type], n,
+           n * ops.size / (1024 * 1024));
+    printf("M keys/s; B/key = bytes read+written by passes over more than %d KB\n",
+           L2_SIZE / 1024);
+    printf("%-12s %10s %12s %12s %9s %8s  Check\n", "Algorithm", "1 thread", "N spread",
+           "N compact", "speedup", "B/key");
+    printf("  (N = %d threads)\n", nthreads);
+    printf("--------------------------------------------------------------------------\n");
+
+    for (int a = 0; a < NUM_ALGOS; a++) {
+        sort_result_t one = run_sort(&ops, (algo_t)a, input, data, tmp, n, 1, PLACE_SPREAD);
+        int ok = one.ok;
+        printf("%-12s %10.1f", algo_names[a], one.mkeys);
+        if (a == A_QSORT) {
+            printf(" %12s %12s %9s %8s  %s\n", "-", "-", "-", "-", ok ? "OK" : "MISMATCH");
+            continue;
+        }
+        sort_result_t spread = run_sort(&ops, (algo_t)a, input, data, tmp, n, nthreads,
+                                        PLACE_SPREAD);
+        sort_result_t compact = run_sort(&ops, (algo_t)a, input, data, tmp, n, nthreads,
+                                         PLACE_COMPACT);
+        ok &= spread.ok && compact.ok;
+        double best = spread.mkeys > compact.mkeys ? spread.mkeys : compact.mkeys;
+        printf(" %12.1f %12.1f %8.2fx %8.1f  %s\n", spread.mkeys, compact.mkeys,
+               best / one.mkeys, spread.bytes_per_key, ok ? "OK" : "MISMATCH");
+        fflush(stdout);
+    }
+
+    free(input);
+    free(data);
+    free(tmp);
+    return 0;
+}
+
+// 最高字节只取 4 个值：第一趟后每个桶都远大于 L2，递归层也走写合并 +
+// 非临时存储的分散路径，且输出起点（其它桶之后）不按缓存行对齐
+static int check_msd_large_buckets(key_type_t type, int nthreads) {
+    sort_ops_t ops = make_ops(type);
+    size_t n = CHECK_KEYS;
+    char *input, *data, *tmp;
+    if (alloc_buffers(&ops, n, &input, &data, &tmp) != 0) return 1;
+    fill_keys(type, input, n, 0x03);
+
+    sort_result_t one = run_sort(&ops, A_MSD, input, data, tmp, n, 1, PLACE_SPREAD);
+    sort_result_t multi = run_sort(&ops, A_MSD, input, data, tmp, n, nthreads, PLACE_SPREAD);
+    printf("msd-radix with %zu MB recursive buckets (1 and %d threads): %s\n",
+           n / 4 * ops.size / (1024 * 1024), nthreads, one.ok && multi.ok ? "OK" : "MISMATCH");
+
+    free(input);
+    free(data);
+    free(tmp);
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--u32 | --u64 | --kv | --all] [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --n N         Number of keys (default: 1M and 16M)\n");
+    printf("  --threads N   Threads for the multi-threaded columns (default %d)\n",
+           NUM_CORES);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    size_t n = 0;
+    int nthreads = NUM_CORES;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--n") == 0) {
+            n = strtoull(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            nthreads = atoi(argv[i + 1]);
+        }
+    }
+    if (nthreads < 1 || nthreads > MAX_THREADS || (n != 0 && n < (size_t)nthreads)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2");
+
+    int first, last;
+    if (strcmp(mode, "--u32") == 0) {
+        first = last = T_U32;
+    } else if (strcmp(mode, "--u64") == 0) {
+        first = last = T_U64;
+    } else if (strcmp(mode, "--kv") == 0) {
+        first = last = T_KV;
+    } else if (strcmp(mode, "--all") == 0) {
+        first = T_U32;
+        last = T_KV;
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("=== Parallel Sort Benchmark ===\n");
+    printf("Merge kernels: %s, radix: %d bits/pass, segment %d KB\n",
+           has_avx2 ? "AVX2 bitonic" : "scalar", RADIX_BITS, SEGMENT_BYTES / 1024);
+
+    size_t sizes[] = {n ? n : 1024 * 1024, 16 * 1024 * 1024};
+    int nsizes = n ? 1 : 2;
+    for (int t = first; t <= last; t++) {
+        for (int i = 0; i < nsizes; i++) {
+            if (run_type((key_type_t)t, sizes[i], nthreads) != 0) return 1;
+        }
+        if (check_msd_large_buckets((key_type_t)t, nthreads) != 0) return 1;
+    }
+
+    if (strcmp(mode, "--all") == 0) {
+        printf("\n=== Analysis ===\n");
+        printf("- lsd-radix: fixed passes (4 for u32/kv, 8 for u64), each a streaming\n");
+        printf("  read + write-combined scatter; traffic = passes x 3 x key size\n");
+        printf("- msd-radix: after the first parallel pass buckets drop below L2, so the\n");
+        printf("  remaining levels run in cache; wins on u64 where LSD needs 8 passes\n");
+        printf("- simd-merge: in-L2 segment sort is free of memory traffic, then one\n");
+        printf("  streaming pass per doubling; merge path keeps all threads busy in the\n");
+        printf("  last rounds, but log2(n/segment) passes still exceed radix passes\n");
+        printf("- AVX2 has no unsigned 64-bit min/max: the u64/kv network emulates it with\n");
+        printf("  xor + cmpgt + blendv, making each merge step a long dependency chain\n");
+        printf("- compact placement puts two threads on each core: radix passes gain\n");
+        printf("  little (bandwidth bound), merge kernels lose half of each core's ALUs\n");
+    }
+    return 0;
+}
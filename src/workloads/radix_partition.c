@@ -0,0 +1,442 @@
+/*
+ * radix_partition.c - 基数分区：软件写合并缓冲与非临时存储
+ *
+ * random_prefetch.c 测的是随机读；分区是它的写端对应物：每个元组写到
+ * fanout 个输出流之一，fanout 一大，活跃的写目标（页、缓存行）就超过
+ * L1 DTLB 和 L1D 的容量，每次写都可能 TLB 缺失并读入一整条缓存行（写分配）。
+ *
+ * 变体：
+ *   naive      out[pos[p]++] = t，直接分散写
+ *   swwcb      每个分区一个缓存行大小的软件写合并缓冲（4 个 16 字节元组），
+ *              满一行才写出 64 字节；活跃写集合缩小为 fanout 个 L1 常驻行
+ *   swwcb+nt   同上，整行用非临时存储 (movntdq) 写出，绕过缓存、无写分配
+ *   2-pass     两趟 swwcb+nt：先按高位分 sqrt(fanout)，再把每个分区按低位细分
+ *
+ * 多线程：每个线程对自己的输入段做直方图，前缀和后每个线程在每个分区内
+ * 拥有一段连续输出（分区之间按分区号排列）。第二趟按分区动态分配给线程。
+ * 页大小：输入/输出缓冲区用 madvise 请求 4KB 页或 2MB 透明大页。
+ *
+ * 编译: gcc -O2 -pthread -o radix_partition radix_partition.c
+ * 运行: ./radix_partition [--fanout | --pages | --all] [--threads N] [--tuples N]
+ *                         [--bits B]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <emmintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define DEFAULT_TUPLES (16 * 1024 * 1024)   // 16 字节元组，256MB
+#define MIN_BITS 4                          // fanout 16
+#define MAX_BITS 16                         // fanout 65536
+#define DEFAULT_BITS 12
+#define PAGE_SIZE_2M (2 * 1024 * 1024)
+#define TUPLES_PER_LINE (CACHE_LINE_SIZE / sizeof(tuple_t))
+#define MAX_THREADS NUM_HW_THREADS
+
+typedef struct {
+    uint64_t key;
+    uint64_t payload;
+} tuple_t;
+
+// 软件写合并缓冲：每个分区一条对齐的缓存行
+typedef struct {
+    tuple_t slot[4];
+} CACHE_ALIGNED wc_line_t;
+
+typedef enum { V_NAIVE, V_SWWCB, V_SWWCB_NT, V_TWO_PASS, NUM_VARIANTS } variant_t;
+
+static const char *variant_names[NUM_VARIANTS] = {"naive", "swwcb", "swwcb+nt", "2-pass"};
+
+typedef struct {
+    size_t *pos;        // 下一个写入位置
+    size_t *start;      // 本线程在各分区的起始位置（首行可能不完整）
+    size_t *hist;
+    wc_line_t *wc;
+} scratch_t;
+
+typedef struct {
+    const tuple_t *in;
+    tuple_t *out;       // 第一趟输出（单趟变体的最终结果）
+    tuple_t *out2;      // 第二趟输出
+    size_t n;
+    int bits;
+    variant_t variant;
+    int nthreads;
+    size_t *hist[MAX_THREADS];   // 第一趟每线程直方图
+    size_t *part_start;          // 第一趟各分区在 out 中的起始位置（fanout + 1 项）
+    volatile int next_part;      // 第二趟动态分配
+    pthread_barrier_t barrier;
+} part_ctx_t;
+
+typedef struct {
+    int cpu_id;
+    int tid;
+    part_ctx_t *ctx;
+    scratch_t scratch;
+    volatile int *ready;
+    volatile int *start;
+} thread_arg_t;
+
+static inline uint32_t part_of(uint64_t key, int shift, int bits) {
+    return (uint32_t)(key >> shift) & ((1u << bits) - 1);
+}
+
+static void histogram(const tuple_t *in, size_t n, int shift, int bits, size_t *hist) {
+    memset(hist, 0, ((size_t)1 << bits) * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) hist[part_of(in[i].key, shift, bits)]++;
+}
+
+// 整行写出：out + e 是缓存行对齐的
+static inline void flush_line(tuple_t *dst, const wc_line_t *line, int nt) {
+    if (nt) {
+        const __m128i *src = (const __m128i *)line->slot;
+        _mm_stream_si128((__m128i *)dst + 0, _mm_load_si128(src + 0));
+        _mm_stream_si128((__m128i *)dst + 1, _mm_load_si128(src + 1));
+        _mm_stream_si128((__m128i *)dst + 2, _mm_load_si128(src + 2));
+        _mm_stream_si128((__m128i *)dst + 3, _mm_load_si128(src + 3));
+    } else {
+        memcpy(dst, line->slot, sizeof(line->slot));
+    }
+}
+
+/*
+ * 把 in[0..n) 分散到 out，s->pos 已初始化为各分区写入起点。
+ * 缓冲槽位与输出缓存行对齐：元组写到槽位 pos % 4，槽位 3 写满时
+ * 对应的输出行 [pos-4, pos) 已完整。起点前的槽位属于别的线程/分区，不能写出。
+ */
+static void scatter(const tuple_t *in, size_t n, tuple_t *out, int shift, int bits,
+                    variant_t variant, scratch_t *s) {
+    size_t fanout = (size_t)1 << bits;
+    size_t *pos = s->pos;
+
+    if (variant == V_NAIVE) {
+        for (size_t i = 0; i < n; i++) {
+            out[pos[part_of(in[i].key, shift, bits)]++] = in[i];
+        }
+        return;
+    }
+
+    int nt = variant != V_SWWCB;
+    wc_line_t *wc = s->wc;
+    memcpy(s->start, pos, fanout * sizeof(size_t));
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t p = part_of(in[i].key, shift, bits);
+        size_t e = pos[p]++;
+        wc[p].slot[e % TUPLES_PER_LINE] = in[i];
+        if (e % TUPLES_PER_LINE == TUPLES_PER_LINE - 1) {
+            size_t line = e + 1 - TUPLES_PER_LINE;
+            if (line >= s->start[p]) {
+                flush_line(out + line, &wc[p], nt);
+            } else {
+                for (size_t j = s->start[p]; j <= e; j++) {
+                    out[j] = wc[p].slot[j % TUPLES_PER_LINE];
+                }
+            }
+        }
+    }
+
+    // 剩余的不完整行用普通存储写出
+    for (size_t p = 0; p < fanout; p++) {
+        size_t e = pos[p];
+        size_t line = e / TUPLES_PER_LINE * TUPLES_PER_LINE;
+        size_t from = line > s->start[p] ? line : s->start[p];
+        for (size_t j = from; j < e; j++) out[j] = wc[p].slot[j % TUPLES_PER_LINE];
+    }
+    if (nt) _mm_sfence();
+}
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+    part_ctx_t *c = targ->ctx;
+    scratch_t *s = &targ->scratch;
+    int tid = targ->tid, nt = c->nthreads;
+    int two_pass = c->variant == V_TWO_PASS;
+    int bits1 = two_pass ? (c->bits + 1) / 2 : c->bits;
+    int bits2 = c->bits - bits1;
+    size_t fanout1 = (size_t)1 << bits1;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    // 第一趟：按 [bits2, bits2 + bits1) 位分区
+    size_t lo = c->n * tid / nt, hi = c->n * (tid + 1) / nt;
+    histogram(c->in + lo, hi - lo, bits2, bits1, c->hist[tid]);
+    pthread_barrier_wait(&c->barrier);
+
+    size_t base = 0;
+    for (size_t p = 0; p < fanout1; p++) {
+        size_t before = 0, total = 0;
+        for (int t = 0; t < nt; t++) {
+            if (t < tid) before += c->hist[t][p];
+            total += c->hist[t][p];
+        }
+        s->pos[p] = base + before;
+        if (tid == 0) c->part_start[p] = base;
+        base += total;
+    }
+    if (tid == 0) c->part_start[fanout1] = base;
+
+    scatter(c->in + lo, hi - lo, c->out, bits2, bits1,
+            two_pass ? V_SWWCB_NT : c->variant, s);
+    if (!two_pass) return NULL;
+
+    // 第二趟：每个分区由一个线程按低 bits2 位细分
+    pthread_barrier_wait(&c->barrier);
+    for (;;) {
+        int p = __atomic_fetch_add(&c->next_part, 1, __ATOMIC_RELAXED);
+        if ((size_t)p >= fanout1) break;
+        size_t p0 = c->part_start[p], p1 = c->part_start[p + 1];
+        size_t fanout2 = (size_t)1 << bits2;
+
+        histogram(c->out + p0, p1 - p0, 0, bits2, s->hist);
+        size_t off = p0;
+        for (size_t q = 0; q < fanout2; q++) {
+            s->pos[q] = off;
+            off += s->hist[q];
+        }
+        scatter(c->out + p0, p1 - p0, c->out2, 0, bits2, V_SWWCB_NT, s);
+    }
+    return NULL;
+}
+
+// 4KB 页或 2MB 透明大页，预先触碰
+static void *alloc_pages(size_t bytes, int huge) {
+    bytes = (bytes + PAGE_SIZE_2M - 1) / PAGE_SIZE_2M * PAGE_SIZE_2M;
+    void *p = aligned_alloc(PAGE_SIZE_2M, bytes);
+    if (!p) return NULL;
+    madvise(p, bytes, huge ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    memset(p, 0, bytes);
+    return p;
+}
+
+// 检查输出按分区号非递减，且元组集合与输入一致（求和校验）
+static int verify(const tuple_t *in, const tuple_t *out, size_t n, int bits) {
+    uint64_t sum_in = 0, sum_out = 0;
+    uint32_t prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum_in += in[i].key * 31 + in[i].payload;
+        sum_out += out[i].key * 31 + out[i].payload;
+        uint32_t p = part_of(out[i].key, 0, bits);
+        if (p < prev) return 0;
+        prev = p;
+    }
+    return sum_in == sum_out;
+}
+
+typedef struct {
+    tuple_t *in, *out, *out2;
+    size_t n;
+    int nthreads;
+    placement_t placement;
+    scratch_t scratch[MAX_THREADS];
+    size_t *hist[MAX_THREADS];
+    size_t *part_start;
+} bench_t;
+
+// 返回 M tuples/s，*ok 为校验结果
+static double run_partition(bench_t *b, int bits, variant_t variant, int *ok) {
+    part_ctx_t c = {
+        .in = b->in, .out = b->out, .out2 = b->out2, .n = b->n, .bits = bits,
+        .variant = variant, .nthreads = b->nthreads, .part_start = b->part_start
+    };
+    pthread_t threads[MAX_THREADS];
+    thread_arg_t args[MAX_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+
+    memcpy(c.hist, b->hist, sizeof(c.hist));
+    pthread_barrier_init(&c.barrier, NULL, b->nthreads);
+    for (int t = 0; t < b->nthreads; t++) {
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, b->placement), .tid = t, .ctx = &c,
+            .scratch = b->scratch[t], .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < b->nthreads) usleep(100);
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int t = 0; t < b->nthreads; t++) pthread_join(threads[t], NULL);
+    double elapsed = get_time_sec() - t0;
+
+    pthread_barrier_destroy(&c.barrier);
+    *ok = verify(b->in, variant == V_TWO_PASS ? b->out2 : b->out, b->n, bits);
+    return b->n / elapsed / 1e6;
+}
+
+static int setup_bench(bench_t *b, size_t n, int nthreads, int huge) {
+    size_t max_fanout = (size_t)1 << MAX_BITS;
+
+    b->n = n;
+    b->nthreads = nthreads;
+    b->placement = PLACE_SPREAD;
+    b->in = alloc_pages(n * sizeof(tuple_t), huge);
+    b->out = alloc_pages(n * sizeof(tuple_t), huge);
+    b->out2 = alloc_pages(n * sizeof(tuple_t), huge);
+    b->part_start = malloc((max_fanout + 1) * sizeof(size_t));
+    if (!b->in || !b->out || !b->out2 || !b->part_start) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+    for (int t = 0; t < nthreads; t++) {
+        scratch_t *s = &b->scratch[t];
+        s->pos = malloc(max_fanout * sizeof(size_t));
+        s->start = malloc(max_fanout * sizeof(size_t));
+        s->hist = malloc(max_fanout * sizeof(size_t));
+        s->wc = aligned_alloc(CACHE_LINE_SIZE, max_fanout * sizeof(wc_line_t));
+        b->hist[t] = malloc(max_fanout * sizeof(size_t));
+        if (!s->pos || !s->start || !s->hist || !s->wc || !b->hist[t]) {
+            perror("Memory allocation failed");
+            return 1;
+        }
+    }
+
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        b->in[i] = (tuple_t){.key = x, .payload = i};
+    }
+    return 0;
+}
+
+static void free_bench(bench_t *b) {
+    for (int t = 0; t < b->nthreads; t++) {
+        free(b->scratch[t].pos);
+        free(b->scratch[t].start);
+        free(b->scratch[t].hist);
+        free(b->scratch[t].wc);
+        free(b->hist[t]);
+    }
+    free(b->in);
+    free(b->out);
+    free(b->out2);
+    free(b->part_start);
+}
+
+static int run_fanout_sweep(size_t n, int nthreads, int huge, int min_bits, int max_bits) {
+    bench_t b;
+    memset(&b, 0, sizeof(b));
+    if (setup_bench(&b, n, nthreads, huge) != 0) return 1;
+
+    printf("\n=== Fanout sweep: %zu tuples (%zu MB), %d threads, %s pages ===\n",
+           n, n * sizeof(tuple_t) / (1024 * 1024), nthreads, huge ? "2MB THP" : "4KB");
+    printf("M tuples/s; 2-pass uses swwcb+nt for both passes\n");
+    printf("%-8s %-8s", "Fanout", "Bits");
+    for (int v = 0; v < NUM_VARIANTS; v++) printf(" %12s", variant_names[v]);
+    printf("  %8s  Check\n", "best/naive");
+    printf("-------------------------------------------------------------------------------------\n");
+
+    for (int bits = min_bits; bits <= max_bits; bits += 2) {
+        double rate[NUM_VARIANTS];
+        int all_ok = 1;
+        printf("%-8d %-8d", 1 << bits, bits);
+        for (int v = 0; v < NUM_VARIANTS; v++) {
+            int ok;
+            rate[v] = run_partition(&b, bits, (variant_t)v, &ok);
+            all_ok &= ok;
+            printf(" %12.1f", rate[v]);
+            fflush(stdout);
+        }
+        double best = rate[V_SWWCB];
+        for (int v = V_SWWCB_NT; v < NUM_VARIANTS; v++) {
+            if (rate[v] > best) best = rate[v];
+        }
+        printf("  %9.2fx  %s\n", best / rate[V_NAIVE], all_ok ? "OK" : "MISMATCH");
+    }
+
+    free_bench(&b);
+    return 0;
+}
+
+static void print_thp_mode(void) {
+    char line[128] = "unknown";
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (f) {
+        if (!fgets(line, sizeof(line), f)) strcpy(line, "unknown\n");
+        fclose(f);
+    }
+    printf("Transparent huge pages: %s", line);
+    if (!strchr(line, '\n')) printf("\n");
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--fanout | --pages | --all] [options]\n", prog);
+    printf("\n");
+    printf("Modes:\n");
+    printf("  --fanout    Fanout 16..65536 with 4KB pages\n");
+    printf("  --pages     Fanout --bits with 4KB vs 2MB pages\n");
+    printf("  --all       Both fanout sweeps (4KB and 2MB pages)\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  --threads N   Worker threads (default %d)\n", NUM_CORES);
+    printf("  --tuples N    Number of 16-byte tuples (default %d)\n", DEFAULT_TUPLES);
+    printf("  --bits B      Radix bits for --pages, %d..%d (default %d)\n",
+           MIN_BITS, MAX_BITS, DEFAULT_BITS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    int nthreads = NUM_CORES;
+    size_t n = DEFAULT_TUPLES;
+    int bits = DEFAULT_BITS;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            nthreads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--tuples") == 0) {
+            n = strtoull(argv[i + 1], NULL, 10);
+        } else if (strcmp(argv[i], "--bits") == 0) {
+            bits = atoi(argv[i + 1]);
+        }
+    }
+    if (nthreads < 1 || nthreads > MAX_THREADS || n < (size_t)nthreads ||
+        bits < MIN_BITS || bits > MAX_BITS) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    printf("=== Radix Partition Benchmark: Software Write-Combining ===\n");
+    print_thp_mode();
+
+    if (strcmp(mode, "--fanout") == 0) {
+        return run_fanout_sweep(n, nthreads, 0, MIN_BITS, MAX_BITS);
+    } else if (strcmp(mode, "--pages") == 0) {
+        if (run_fanout_sweep(n, nthreads, 0, bits, bits) != 0) return 1;
+        return run_fanout_sweep(n, nthreads, 1, bits, bits);
+    } else if (strcmp(mode, "--all") == 0) {
+        if (run_fanout_sweep(n, nthreads, 0, MIN_BITS, MAX_BITS) != 0) return 1;
+        if (run_fanout_sweep(n, nthreads, 1, MIN_BITS, MAX_BITS) != 0) return 1;
+
+        printf("\n=== Analysis ===\n");
+        printf("- naive: each partition is an open write stream; past ~64 partitions\n");
+        printf("  (L1 DTLB entries with 4KB pages) and ~512 (L1D lines) every store can\n");
+        printf("  miss the TLB and read a line it is about to overwrite\n");
+        printf("- swwcb: stores hit fanout x 64B of L1-resident buffers; memory sees one\n");
+        printf("  full-line write per 4 tuples, and the TLB is touched once per line\n");
+        printf("- swwcb+nt: full lines go straight to memory without a read-for-ownership,\n");
+        printf("  cutting traffic from read+write to write only\n");
+        printf("- once fanout x 64B overflows L1/L2 the buffers themselves miss; two passes\n");
+        printf("  of sqrt(fanout) each keep both passes in the cheap region\n");
+        printf("- 2MB pages extend TLB reach, moving the naive cliff to higher fanout\n");
+        return 0;
+    }
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,412 @@
+/*
+ * record_layout.c - 记录布局：AoS / SoA / AoSoA / 冷热字段分离
+ *
+ * 其它测试只扫描 uint64_t 数组，缓存行利用率总是 100%。实际数据是记录：
+ * 查询只用到少数字段，布局决定了每个有用字节要搬运多少字节。
+ *
+ * 记录由 R/8 个 uint64_t 字段组成（R = 16..512 字节），查询使用前 K 个字段：
+ *     if (f0 < T) sum += f0 + f1 + ... + f(K-1)      （约 50% 选择率，无分支实现）
+ *
+ * 布局：
+ *   aos       struct rec[n]，记录连续
+ *   soa       每个字段一个数组
+ *   aosoa     每 8 条记录一个 tile，tile 内按字段存放（一个字段 8 个值 = 一个缓存行）
+ *   hot-cold  前 K 个字段一个 AoS 数组，其余字段另一个 AoS 数组
+ *
+ * 访问：
+ *   scan       顺序扫描，标量与 AVX2（aos/hot-cold 用 gather，soa/aosoa 连续加载）
+ *   rand-hot   随机记录，只读 K 个热字段
+ *   rand-all   随机记录，读全部字段（点查询整条记录，aos 的强项）
+ *
+ * 报告有用带宽（n*K*8 字节/时间）、扫描实际搬运的缓存行字节/有用字节、随机访问 ns/记录。
+ *
+ * 编译: gcc -O2 -o record_layout record_layout.c
+ * 运行: ./record_layout [--scan | --random | --all] [--size R] [--fields K]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define DATA_BYTES (256UL * 1024 * 1024)   // 每种布局的数据量
+#define MIN_RECORD 16
+#define MAX_RECORD 512
+#define DEFAULT_FIELDS 2
+#define TILE 8                             // AoSoA 每个 tile 的记录数
+#define RANDOM_LOOKUPS (4 * 1024 * 1024)
+#define THRESHOLD (1ULL << 61)             // 字段值 < 2^62，约 50% 选择率
+
+typedef enum { L_AOS, L_SOA, L_AOSOA, L_HOT_COLD, NUM_LAYOUTS } layout_kind_t;
+
+static const char *layout_names[NUM_LAYOUTS] = {"aos", "soa", "aosoa", "hot-cold"};
+
+typedef struct {
+    layout_kind_t kind;
+    uint64_t *base;     // hot-cold 时为热字段数组
+    uint64_t *cold;     // hot-cold 的冷字段数组
+    size_t n;           // 记录数（TILE 的倍数）
+    int nf;             // 每条记录的字段数
+    int k;              // 查询使用的字段数
+} layout_t;
+
+static int has_avx2;
+
+static inline uint64_t field_value(size_t i, int f) {
+    uint64_t x = (uint64_t)i * 64 + f + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return (x ^ (x >> 31)) >> 2;
+}
+
+// ---------------------------------------------------------------
+// 字段地址与标量访问（每种布局一份）
+// ---------------------------------------------------------------
+
+#define ADDR_AOS(L, i, f)   ((L)->base + (size_t)(i) * (L)->nf + (f))
+#define ADDR_SOA(L, i, f)   ((L)->base + (size_t)(f) * (L)->n + (i))
+#define ADDR_AOSOA(L, i, f) ((L)->base + (size_t)(i) / TILE * (L)->nf * TILE + \
+                             (size_t)(f) * TILE + (i) % TILE)
+#define ADDR_HOT_COLD(L, i, f) ((f) < (L)->k \
+    ? (L)->base + (size_t)(i) * (L)->k + (f) \
+    : (L)->cold + (size_t)(i) * ((L)->nf - (L)->k) + (f) - (L)->k)
+
+#define DEFINE_LAYOUT(name, ADDR) \
+static void name##_build(const layout_t *L) { \
+    for (size_t i = 0; i < L->n; i++) { \
+        for (int f = 0; f < L->nf; f++) *ADDR(L, i, f) = field_value(i, f); \
+    } \
+} \
+static uint64_t name##_scan(const layout_t *L) { \
+    uint64_t acc = 0; \
+    for (size_t i = 0; i < L->n; i++) { \
+        uint64_t f0 = *ADDR(L, i, 0), s = f0; \
+        for (int f = 1; f < L->k; f++) s += *ADDR(L, i, f); \
+        acc += -(uint64_t)(f0 < THRESHOLD) & s; \
+    } \
+    return acc; \
+} \
+static uint64_t name##_random_hot(const layout_t *L, const uint32_t *ids, size_t m) { \
+    uint64_t acc = 0; \
+    for (size_t r = 0; r < m; r++) { \
+        size_t i = ids[r]; \
+        uint64_t f0 = *ADDR(L, i, 0), s = f0; \
+        for (int f = 1; f < L->k; f++) s += *ADDR(L, i, f); \
+        acc += -(uint64_t)(f0 < THRESHOLD) & s; \
+    } \
+    return acc; \
+} \
+static uint64_t name##_random_all(const layout_t *L, const uint32_t *ids, size_t m) { \
+    uint64_t acc = 0; \
+    for (size_t r = 0; r < m; r++) { \
+        size_t i = ids[r]; \
+        for (int f = 0; f < L->nf; f++) acc += *ADDR(L, i, f); \
+    } \
+    return acc; \
+}
+
+DEFINE_LAYOUT(aos, ADDR_AOS)
+DEFINE_LAYOUT(soa, ADDR_SOA)
+DEFINE_LAYOUT(aosoa, ADDR_AOSOA)
+DEFINE_LAYOUT(hot_cold, ADDR_HOT_COLD)
+
+// ---------------------------------------------------------------
+// AVX2 扫描：4 条记录一个向量
+// ---------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static inline uint64_t hsum_epi64(__m256i v) {
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return (uint64_t)_mm_cvtsi128_si64(s) + (uint64_t)_mm_extract_epi64(s, 1);
+}
+
+// 跨步为 stride 个字段的 AoS 数组（aos 与 hot-cold 的热数组）
+__attribute__((target("avx2")))
+static uint64_t strided_scan_avx2(const uint64_t *base, size_t n, int stride, int k) {
+    const __m256i thr = _mm256_set1_epi64x(THRESHOLD);
+    const __m256i vindex = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t i = 0; i < n; i += 4) {
+        const long long *p = (const long long *)(base + i * stride);
+        __m256i f0 = _mm256_i64gather_epi64(p, vindex, 8), s = f0;
+        for (int f = 1; f < k; f++) {
+            s = _mm256_add_epi64(s, _mm256_i64gather_epi64(p + f, vindex, 8));
+        }
+        acc = _mm256_add_epi64(acc, _mm256_and_si256(_mm256_cmpgt_epi64(thr, f0), s));
+    }
+    return hsum_epi64(acc);
+}
+
+__attribute__((target("avx2")))
+static uint64_t soa_scan_avx2(const layout_t *L) {
+    const __m256i thr = _mm256_set1_epi64x(THRESHOLD);
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t i = 0; i < L->n; i += 4) {
+        __m256i f0 = _mm256_load_si256((const __m256i *)ADDR_SOA(L, i, 0)), s = f0;
+        for (int f = 1; f < L->k; f++) {
+            s = _mm256_add_epi64(s, _mm256_load_si256((const __m256i *)ADDR_SOA(L, i, f)));
+        }
+        acc = _mm256_add_epi64(acc, _mm256_and_si256(_mm256_cmpgt_epi64(thr, f0), s));
+    }
+    return hsum_epi64(acc);
+}
+
+__attribute__((target("avx2")))
+static uint64_t aosoa_scan_avx2(const layout_t *L) {
+    const __m256i thr = _mm256_set1_epi64x(THRESHOLD);
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t i = 0; i < L->n; i += 4) {
+        __m256i f0 = _mm256_load_si256((const __m256i *)ADDR_AOSOA(L, i, 0)), s = f0;
+        for (int f = 1; f < L->k; f++) {
+            s = _mm256_add_epi64(s, _mm256_load_si256((const __m256i *)ADDR_AOSOA(L, i, f)));
+        }
+        acc = _mm256_add_epi64(acc, _mm256_and_si256(_mm256_cmpgt_epi64(thr, f0), s));
+    }
+    return hsum_epi64(acc);
+}
+
+static uint64_t scan_simd(const layout_t *L) {
+    switch (L->kind) {
+    case L_AOS:      return strided_scan_avx2(L->base, L->n, L->nf, L->k);
+    case L_SOA:      return soa_scan_avx2(L);
+    case L_AOSOA:    return aosoa_scan_avx2(L);
+    case L_HOT_COLD: return strided_scan_avx2(L->base, L->n, L->k, L->k);
+    default:         return 0;
+    }
+}
+
+static uint64_t scan_scalar(const layout_t *L) {
+    switch (L->kind) {
+    case L_AOS:      return aos_scan(L);
+    case L_SOA:      return soa_scan(L);
+    case L_AOSOA:    return aosoa_scan(L);
+    case L_HOT_COLD: return hot_cold_scan(L);
+    default:         return 0;
+    }
+}
+
+static uint64_t random_access(const layout_t *L, const uint32_t *ids, int all) {
+    switch (L->kind) {
+    case L_AOS:
+        return all ? aos_random_all(L, ids, RANDOM_LOOKUPS) : aos_random_hot(L, ids, RANDOM_LOOKUPS);
+    case L_SOA:
+        return all ? soa_random_all(L, ids, RANDOM_LOOKUPS) : soa_random_hot(L, ids, RANDOM_LOOKUPS);
+    case L_AOSOA:
+        return all ? aosoa_random_all(L, ids, RANDOM_LOOKUPS)
+                   : aosoa_random_hot(L, ids, RANDOM_LOOKUPS);
+    case L_HOT_COLD:
+        return all ? hot_cold_random_all(L, ids, RANDOM_LOOKUPS)
+                   : hot_cold_random_hot(L, ids, RANDOM_LOOKUPS);
+    default:
+        return 0;
+    }
+}
+
+// 扫描实际触碰的缓存行字节数
+static double scan_bytes_moved(const layout_t *L) {
+    size_t lines = 0;
+    switch (L->kind) {
+    case L_AOS: {
+        size_t rec = (size_t)L->nf * 8, prev = SIZE_MAX;
+        for (size_t i = 0; i < L->n; i++) {
+            size_t first = i * rec / CACHE_LINE_SIZE;
+            size_t last = (i * rec + (size_t)L->k * 8 - 1) / CACHE_LINE_SIZE;
+            lines += last - first + 1 - (first == prev);
+            prev = last;
+        }
+        break;
+    }
+    case L_SOA:
+        lines = (size_t)L->k * ((L->n * 8 + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE);
+        break;
+    case L_AOSOA:
+        lines = L->n / TILE * L->k;
+        break;
+    case L_HOT_COLD:
+        lines = (L->n * L->k * 8 + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+        break;
+    default:
+        break;
+    }
+    return (double)lines * CACHE_LINE_SIZE;
+}
+
+static int build_layout(layout_t *L, layout_kind_t kind, size_t n, int nf, int k) {
+    *L = (layout_t){.kind = kind, .n = n, .nf = nf, .k = k};
+    size_t hot_bytes = kind == L_HOT_COLD ? n * k * 8 : n * nf * 8;
+    size_t cold_bytes = kind == L_HOT_COLD ? n * (nf - k) * 8 : 0;
+
+    L->base = aligned_alloc(CACHE_LINE_SIZE, hot_bytes);
+    L->cold = aligned_alloc(CACHE_LINE_SIZE, cold_bytes + CACHE_LINE_SIZE);
+    if (!L->base || !L->cold) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    switch (kind) {
+    case L_AOS:      aos_build(L); break;
+    case L_SOA:      soa_build(L); break;
+    case L_AOSOA:    aosoa_build(L); break;
+    case L_HOT_COLD: hot_cold_build(L); break;
+    default:         break;
+    }
+    return 0;
+}
+
+static void free_layout(layout_t *L) {
+    free(L->base);
+    free(L->cold);
+}
+
+static int run_record_size(int record, int k, int do_scan, int do_random,
+                           const uint32_t *ids) {
+    int nf = record / 8;
+    size_t n = DATA_BYTES / record / TILE * TILE;
+    double useful = (double)n * k * 8;
+    uint64_t ref_scan = 0, ref_hot = 0, ref_all = 0;
+
+    printf("\n=== Record %d bytes (%d fields), query uses %d field%s, %zu records ===\n",
+           record, nf, k, k > 1 ? "s" : "", n);
+    printf("%-10s %12s %12s %13s %12s %12s  Check\n", "Layout", "scalar GB/s",
+           has_avx2 ? "avx2 GB/s" : "simd GB/s", "moved/useful", "rand-hot ns",
+           "rand-all ns");
+    printf("--------------------------------------------------------------------------------------\n");
+
+    for (int l = 0; l < NUM_LAYOUTS; l++) {
+        layout_t L;
+        int ok = 1;
+        if (build_layout(&L, (layout_kind_t)l, n, nf, k) != 0) return 1;
+        printf("%-10s", layout_names[l]);
+
+        if (do_scan) {
+            double t0 = get_time_sec();
+            uint64_t r = scan_scalar(&L);
+            double t_scalar = get_time_sec() - t0;
+            if (l == L_AOS) ref_scan = r;
+            ok &= r == ref_scan;
+
+            if (has_avx2) {
+                t0 = get_time_sec();
+                r = scan_simd(&L);
+                double t_simd = get_time_sec() - t0;
+                ok &= r == ref_scan;
+                printf(" %12.2f %12.2f", useful / t_scalar / 1e9, useful / t_simd / 1e9);
+            } else {
+                printf(" %12.2f %12s", useful / t_scalar / 1e9, "-");
+            }
+            printf(" %12.2fx", scan_bytes_moved(&L) / useful);
+        } else {
+            printf(" %12s %12s %13s", "-", "-", "-");
+        }
+
+        if (do_random) {
+            double t0 = get_time_sec();
+            uint64_t hot = random_access(&L, ids, 0);
+            double t_hot = get_time_sec() - t0;
+            t0 = get_time_sec();
+            uint64_t all = random_access(&L, ids, 1);
+            double t_all = get_time_sec() - t0;
+            if (l == L_AOS) {
+                ref_hot = hot;
+                ref_all = all;
+            }
+            ok &= hot == ref_hot && all == ref_all;
+            printf(" %12.1f %12.1f", t_hot * 1e9 / RANDOM_LOOKUPS, t_all * 1e9 / RANDOM_LOOKUPS);
+        } else {
+            printf(" %12s %12s", "-", "-");
+        }
+
+        printf("  %s\n", ok ? "OK" : "MISMATCH");
+        fflush(stdout);
+        free_layout(&L);
+    }
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--scan | --random | --all] [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --size R      Record size in bytes, multiple of 8 in %d..%d "
+           "(default: sweep 16..512)\n", MIN_RECORD, MAX_RECORD);
+    printf("  --fields K    Fields used by the query (default %d)\n", DEFAULT_FIELDS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    int record = 0;
+    int k = DEFAULT_FIELDS;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--size") == 0) {
+            record = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--fields") == 0) {
+            k = atoi(argv[i + 1]);
+        }
+    }
+
+    int do_scan = strcmp(mode, "--random") != 0;
+    int do_random = strcmp(mode, "--scan") != 0;
+    if ((strcmp(mode, "--scan") != 0 && strcmp(mode, "--random") != 0 &&
+         strcmp(mode, "--all") != 0) ||
+        (record != 0 && (record < MIN_RECORD || record > MAX_RECORD || record % 8 != 0)) ||
+        k < 1 || k * 8 > (record ? record : MAX_RECORD)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2");
+
+    // 随机访问的记录编号缓冲，每种记录大小按其记录数重新生成
+    uint32_t *ids = malloc(RANDOM_LOOKUPS * sizeof(uint32_t));
+    if (!ids) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    printf("=== Record Layout Benchmark: AoS / SoA / AoSoA / Hot-Cold ===\n");
+    printf("Data per layout: %lu MB, query: if (f0 < T) sum += f0..f(K-1), ~50%% selected\n",
+           DATA_BYTES / (1024 * 1024));
+    printf("GB/s counts useful bytes (records x K x 8); moved/useful counts whole cache lines\n");
+
+    for (int r = MIN_RECORD; r <= MAX_RECORD; r *= 2) {
+        int size = record ? record : r;
+        if (size < k * 8) continue;   // 记录放不下 K 个字段
+        size_t n = DATA_BYTES / size / TILE * TILE;
+        // 每种大小使用同一种子，编号在 [0, n) 内，查询时无需取模
+        uint64_t x = 0x2545F4914F6CDD1DULL;
+        for (size_t i = 0; i < RANDOM_LOOKUPS; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            ids[i] = (uint32_t)(x % n);
+        }
+        if (run_record_size(size, k, do_scan, do_random, ids) != 0) {
+            free(ids);
+            return 1;
+        }
+        if (record) break;
+    }
+
+    if (strcmp(mode, "--all") == 0 && record == 0) {
+        printf("\n=== Analysis ===\n");
+        printf("- aos scans move whole lines: moved/useful grows with the record until\n");
+        printf("  each record's hot fields cost a full line (64/(K*8) for K*8 <= 64)\n");
+        printf("- soa and aosoa both move only hot fields (1.00x), but with large records an\n");
+        printf("  aosoa tile spans pages and its few hot lines per tile look like a strided\n");
+        printf("  access to the prefetcher; soa stays K clean sequential streams\n");
+        printf("- aos SIMD needs gathers, which do not help once the scan is memory bound\n");
+        printf("- hot-cold recovers soa-like scans while a point lookup of the hot\n");
+        printf("  fields is still one line; rand-all is where aos wins: one or a few\n");
+        printf("  adjacent lines per record versus one line per field for soa/aosoa\n");
+    }
+
+    free(ids);
+    return 0;
+}
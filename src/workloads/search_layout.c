@@ -0,0 +1,421 @@
+/*
+ * search_layout.c - 查找布局对比：有序数组 / Eytzinger / S-tree
+ *
+ * random_prefetch.c 演示了独立随机读上的预取，但实际的查找是二分搜索：
+ * 每一步的地址依赖上一步的比较结果，无法简单地提前预取。
+ * 本测试在 1K..1G 个 key 上做 lower_bound，比较四种布局：
+ *
+ * 1. sorted     有序数组 + 普通二分（分支预测失败约一半）
+ * 2. branchless 有序数组 + 无分支二分（掩码选择），同时预取两个候选中点
+ * 3. eytzinger  BFS 顺序存储的隐式二叉树，前 4 层后代连续存放在
+ *               一个缓存行内，预取 k*16 提前 4 层取数据
+ * 4. s-tree     静态 B 树，每个节点 16 个 key 正好一个缓存行，
+ *               节点内用 SIMD 比较 + popcount 求秩，树高为 log17(n)
+ *
+ * 每种布局两种模式：
+ *   single   逐个查询，一次只有一条依赖链在等内存
+ *   batched  16 个查询交错推进，每一层同时发出 16 个独立访存
+ *
+ * 编译: gcc -O2 -o search_layout search_layout.c
+ * 运行: ./search_layout [--single | --batched | --all] [--max-keys N]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define MIN_KEYS 1024
+#define DEFAULT_MAX_KEYS (64 * 1024 * 1024)  // 每种布局 256MB
+#define QUERY_COUNT (1 << 20)
+#define BATCH 16
+#define STREE_B 16                            // 每个节点的 key 数（64 字节）
+#define KEY_MAX INT32_MAX                     // 哨兵：大于所有 key
+
+static int32_t *sorted;     // 有序数组
+static int32_t *eytzinger;  // 下标从 1 开始，eytzinger[0] 为哨兵
+static int32_t *stree;      // nblocks 个节点，每个 STREE_B 个 key
+static size_t num_keys;
+static size_t nblocks;
+static int32_t *queries;
+static int has_avx2;
+
+// ---------------------------------------------------------------
+// 构建
+// ---------------------------------------------------------------
+
+// 严格递增的随机 key，平均间隔保证最大值 < 2^31
+static void generate_keys(size_t n) {
+    uint64_t seed = 12345;
+    uint64_t avg_gap = (1ULL << 30) / n;
+    int64_t key = 0;
+
+    if (avg_gap < 1) avg_gap = 1;
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        key += 1 + (seed >> 16) % (2 * avg_gap - 1);
+        sorted[i] = (int32_t)key;
+    }
+
+    for (size_t i = 0; i < QUERY_COUNT; i++) {
+        seed = seed * 1103515245 + 12345;
+        queries[i] = (int32_t)((seed >> 16) % (uint64_t)(key + 1));
+    }
+}
+
+// 按中序遍历把有序数组填入 BFS 下标（迭代实现，避免深递归）
+static void build_eytzinger(size_t n) {
+    size_t i = 0, k = 1;
+
+    eytzinger[0] = KEY_MAX;
+    // 中序遍历：先走到最左，再逐个回溯
+    for (;;) {
+        while (k <= n) k = 2 * k;
+        k >>= __builtin_ffsll(~(long long)k);  // 回到最近一个从左子树返回的祖先
+        if (k == 0) break;
+        eytzinger[k] = sorted[i++];
+        k = 2 * k + 1;
+    }
+}
+
+static size_t stree_child(size_t k, int i) {
+    return k * (STREE_B + 1) + i + 1;
+}
+
+// 中序填充静态 B 树：节点 k 的第 i 个 key 位于子树 i 和子树 i+1 之间
+static void build_stree_rec(size_t k, size_t *t) {
+    if (k >= nblocks) return;
+    for (int i = 0; i < STREE_B; i++) {
+        build_stree_rec(stree_child(k, i), t);
+        stree[k * STREE_B + i] = *t < num_keys ? sorted[(*t)++] : KEY_MAX;
+    }
+    build_stree_rec(stree_child(k, STREE_B), t);
+}
+
+static void build_stree(void) {
+    size_t t = 0;
+    build_stree_rec(0, &t);
+}
+
+// ---------------------------------------------------------------
+// 查找：返回第一个 >= x 的 key，不存在时返回 KEY_MAX
+// ---------------------------------------------------------------
+
+static int32_t search_sorted(int32_t x) {
+    size_t lo = 0, hi = num_keys;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (sorted[mid] < x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < num_keys ? sorted[lo] : KEY_MAX;
+}
+
+static int32_t search_branchless(int32_t x) {
+    const int32_t *base = sorted;
+    size_t len = num_keys;
+    while (len > 1) {
+        size_t half = len / 2;
+        // 下一步的中点只有两种可能，提前把两个都取进来
+        PREFETCH_T0(&base[len / 4 - 1]);
+        PREFETCH_T0(&base[half + len / 4 - 1]);
+        // 用掩码做选择：三元表达式在 -O2 下会被编译成条件跳转而不是 cmov
+        base += half & -(size_t)(base[half - 1] < x);
+        len -= half;
+    }
+    size_t idx = (base - sorted) + (*base < x);
+    return idx < num_keys ? sorted[idx] : KEY_MAX;
+}
+
+static int32_t search_eytzinger(int32_t x) {
+    size_t k = 1;
+    while (k <= num_keys) {
+        // k 的第 4 层后代 16k..16k+15 连续存放在一个缓存行
+        PREFETCH_T0(&eytzinger[k * 16]);
+        k = 2 * k + (eytzinger[k] < x);
+    }
+    k >>= __builtin_ffsll(~(long long)k);
+    return eytzinger[k];
+}
+
+// 节点内小于 x 的 key 个数（节点有序，即第一个 >= x 的位置）
+static inline int rank_sse2(int32_t x, const int32_t *node) {
+    __m128i xv = _mm_set1_epi32(x);
+    int mask = 0;
+    for (int i = 0; i < STREE_B; i += 4) {
+        __m128i keys = _mm_load_si128((const __m128i *)(node + i));
+        mask |= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(xv, keys))) << i;
+    }
+    return __builtin_popcount(mask);
+}
+
+__attribute__((target("avx2")))
+static inline int rank_avx2(int32_t x, const int32_t *node) {
+    __m256i xv = _mm256_set1_epi32(x);
+    __m256i lo = _mm256_cmpgt_epi32(xv, _mm256_load_si256((const __m256i *)node));
+    __m256i hi = _mm256_cmpgt_epi32(xv, _mm256_load_si256((const __m256i *)(node + 8)));
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(lo)) |
+               (_mm256_movemask_ps(_mm256_castsi256_ps(hi)) << 8);
+    return __builtin_popcount(mask);
+}
+
+#define DEFINE_STREE_SEARCH(name, ATTR, RANK) \
+ATTR static int32_t name(int32_t x) { \
+    int32_t res = KEY_MAX; \
+    size_t k = 0; \
+    while (k < nblocks) { \
+        const int32_t *node = &stree[k * STREE_B]; \
+        int i = RANK(x, node); \
+        if (i < STREE_B) res = node[i]; \
+        k = stree_child(k, i); \
+    } \
+    return res; \
+}
+
+DEFINE_STREE_SEARCH(search_stree_sse2, , rank_sse2)
+DEFINE_STREE_SEARCH(search_stree_avx2, __attribute__((target("avx2"))), rank_avx2)
+
+// ---------------------------------------------------------------
+// 批量交错查找：BATCH 个查询每层同步推进
+// ---------------------------------------------------------------
+
+// 有序数组：所有查询的 len 序列相同，只有 base 不同
+static void batch_branchless(const int32_t *x, int32_t *out) {
+    const int32_t *base[BATCH];
+    size_t len = num_keys;
+
+    for (int q = 0; q < BATCH; q++) base[q] = sorted;
+    while (len > 1) {
+        size_t half = len / 2;
+        for (int q = 0; q < BATCH; q++) {
+            base[q] += half & -(size_t)(base[q][half - 1] < x[q]);
+        }
+        len -= half;
+    }
+    for (int q = 0; q < BATCH; q++) {
+        size_t idx = (base[q] - sorted) + (*base[q] < x[q]);
+        out[q] = idx < num_keys ? sorted[idx] : KEY_MAX;
+    }
+}
+
+// 分支版本无法交错（每个查询的区间不同步），按顺序执行作为对照
+static void batch_sorted(const int32_t *x, int32_t *out) {
+    for (int q = 0; q < BATCH; q++) out[q] = search_sorted(x[q]);
+}
+
+// Eytzinger：前 full_levels 层对所有查询都存在，最后一层按需
+static void batch_eytzinger(const int32_t *x, int32_t *out) {
+    size_t k[BATCH];
+    int full_levels = 63 - __builtin_clzll(num_keys + 1);
+
+    for (int q = 0; q < BATCH; q++) k[q] = 1;
+    for (int level = 0; level < full_levels; level++) {
+        for (int q = 0; q < BATCH; q++) {
+            PREFETCH_T0(&eytzinger[k[q] * 16]);
+            k[q] = 2 * k[q] + (eytzinger[k[q]] < x[q]);
+        }
+    }
+    for (int q = 0; q < BATCH; q++) {
+        if (k[q] <= num_keys) k[q] = 2 * k[q] + (eytzinger[k[q]] < x[q]);
+        k[q] >>= __builtin_ffsll(~(long long)k[q]);
+        out[q] = eytzinger[k[q]];
+    }
+}
+
+#define DEFINE_STREE_BATCH(name, ATTR, RANK) \
+ATTR static void name(const int32_t *x, int32_t *out) { \
+    size_t k[BATCH]; \
+    int active = BATCH; \
+    for (int q = 0; q < BATCH; q++) { \
+        k[q] = 0; \
+        out[q] = KEY_MAX; \
+    } \
+    while (active > 0) { \
+        active = 0; \
+        for (int q = 0; q < BATCH; q++) { \
+            if (k[q] >= nblocks) continue; \
+            const int32_t *node = &stree[k[q] * STREE_B]; \
+            int i = RANK(x[q], node); \
+            if (i < STREE_B) out[q] = node[i]; \
+            k[q] = stree_child(k[q], i); \
+            active++; \
+        } \
+    } \
+}
+
+DEFINE_STREE_BATCH(batch_stree_sse2, , rank_sse2)
+DEFINE_STREE_BATCH(batch_stree_avx2, __attribute__((target("avx2"))), rank_avx2)
+
+static int32_t search_stree(int32_t x) {
+    return has_avx2 ? search_stree_avx2(x) : search_stree_sse2(x);
+}
+
+static void batch_stree(const int32_t *x, int32_t *out) {
+    if (has_avx2) {
+        batch_stree_avx2(x, out);
+    } else {
+        batch_stree_sse2(x, out);
+    }
+}
+
+// ---------------------------------------------------------------
+// 测量
+// ---------------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    int32_t (*single)(int32_t x);
+    void (*batched)(const int32_t *x, int32_t *out);
+} layout_t;
+
+static const layout_t layouts[] = {
+    {"sorted",     search_sorted,     batch_sorted},
+    {"branchless", search_branchless, batch_branchless},
+    {"eytzinger",  search_eytzinger,  batch_eytzinger},
+    {"s-tree",     search_stree,      batch_stree},
+};
+#define NUM_LAYOUTS (int)(sizeof(layouts) / sizeof(layouts[0]))
+
+// 返回 ns/query，checksum 用于校验各布局结果一致
+static double measure(const layout_t *layout, int batched, uint64_t *checksum) {
+    uint64_t sum = 0;
+    int32_t out[BATCH];
+
+    double start = get_time_sec();
+    if (batched) {
+        for (size_t i = 0; i < QUERY_COUNT; i += BATCH) {
+            layout->batched(&queries[i], out);
+            for (int q = 0; q < BATCH; q++) sum += (uint32_t)out[q];
+        }
+    } else {
+        for (size_t i = 0; i < QUERY_COUNT; i++) {
+            sum += (uint32_t)layout->single(queries[i]);
+        }
+    }
+    double elapsed = get_time_sec() - start;
+
+    *checksum = sum;
+    return elapsed / QUERY_COUNT * 1e9;
+}
+
+static void print_size(size_t n) {
+    if (n >= 1024 * 1024 * 1024) {
+        printf("%4zuG", n / (1024 * 1024 * 1024));
+    } else if (n >= 1024 * 1024) {
+        printf("%4zuM", n / (1024 * 1024));
+    } else {
+        printf("%4zuK", n / 1024);
+    }
+}
+
+static void run_sweep(int batched, size_t max_keys) {
+    printf("\n=== Lower-Bound Search, %s (ns/query) ===\n",
+           batched ? "Batched-Interleaved (16 queries)" : "Single Query");
+    printf("%-6s %10s", "Keys", "Footprint");
+    for (int l = 0; l < NUM_LAYOUTS; l++) printf(" %11s", layouts[l].name);
+    printf("  Check\n");
+    printf("-----------------------------------------------------------------------------\n");
+
+    for (size_t n = MIN_KEYS; n <= max_keys; n *= 4) {
+        num_keys = n;
+        nblocks = (n + STREE_B - 1) / STREE_B;
+        generate_keys(n);
+        build_eytzinger(n);
+        build_stree();
+
+        print_size(n);
+        printf("  %8zuKB", n * sizeof(int32_t) / 1024);
+
+        uint64_t reference = 0;
+        int ok = 1;
+        for (int l = 0; l < NUM_LAYOUTS; l++) {
+            uint64_t checksum;
+            measure(&layouts[l], batched, &checksum);  // 预热
+            double ns = measure(&layouts[l], batched, &checksum);
+            if (l == 0) reference = checksum;
+            if (checksum != reference) ok = 0;
+            printf(" %11.1f", ns);
+            fflush(stdout);
+        }
+        printf("  %s\n", ok ? "OK" : "MISMATCH");
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--single | --batched | --all] [--max-keys N]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --single      One query at a time (dependent loads only)\n");
+    printf("  --batched     16 queries interleaved level by level\n");
+    printf("  --all         Both modes\n");
+    printf("  --max-keys N  Largest key count (default %d, up to 1G = 1073741824)\n",
+           DEFAULT_MAX_KEYS);
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    size_t max_keys = DEFAULT_MAX_KEYS;
+
+    if (argc > 3 && strcmp(argv[2], "--max-keys") == 0) {
+        max_keys = strtoull(argv[3], NULL, 0);
+    }
+    if (max_keys < MIN_KEYS || max_keys > (1ULL << 30)) {
+        fprintf(stderr, "Invalid --max-keys: %zu\n", max_keys);
+        return 1;
+    }
+
+    // Eytzinger 的 k*16 预取会超出数组，预取指令不会触发缺页异常，无需额外分配
+    size_t max_blocks = (max_keys + STREE_B - 1) / STREE_B;
+    sorted = aligned_alloc(CACHE_LINE_SIZE, max_keys * sizeof(int32_t));
+    eytzinger = aligned_alloc(CACHE_LINE_SIZE, (max_keys + 1) * sizeof(int32_t));
+    stree = aligned_alloc(CACHE_LINE_SIZE, max_blocks * STREE_B * sizeof(int32_t));
+    queries = aligned_alloc(CACHE_LINE_SIZE, QUERY_COUNT * sizeof(int32_t));
+    if (!sorted || !eytzinger || !stree || !queries) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2");
+    bind_to_cpu(0);
+
+    printf("=== Search Layout Benchmark ===\n");
+    printf("Keys: %d .. %zu (int32), queries per measurement: %d\n",
+           MIN_KEYS, max_keys, QUERY_COUNT);
+    printf("S-tree node: %d keys (%d bytes), rank via %s\n", STREE_B,
+           STREE_B * (int)sizeof(int32_t), has_avx2 ? "AVX2" : "SSE2");
+
+    if (strcmp(mode, "--single") == 0) {
+        run_sweep(0, max_keys);
+    } else if (strcmp(mode, "--batched") == 0) {
+        run_sweep(1, max_keys);
+    } else if (strcmp(mode, "--all") == 0) {
+        run_sweep(0, max_keys);
+        run_sweep(1, max_keys);
+
+        printf("\n=== Analysis ===\n");
+        printf("- In L1/L2 branchless wins over sorted: no mispredictions\n");
+        printf("- Beyond L3 sorted/branchless pay one cache miss per level;\n");
+        printf("  Eytzinger prefetch overlaps 4 levels, S-tree has ~4x fewer levels\n");
+        printf("- Batching issues 16 independent misses per level: the gain grows\n");
+        printf("  with size until memory bandwidth, not latency, is the limit\n");
+        printf("- Sorted (branchy) cannot be interleaved; it is the batched baseline\n");
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    free(sorted);
+    free(eytzinger);
+    free(stree);
+    free(queries);
+    return 0;
+}
@@ -0,0 +1,770 @@
+/*
+ * spmv.c - 稀疏矩阵向量乘 (SpMV)：存储格式、SIMD 与间接预取
+ *
+ * matrix_prefetch.c 的稠密矩阵访问模式是规则的；SpMV 的 x[col[k]]
+ * 是间接访问，val/col 顺序流式读取，x 随机读取。本测试比较四种格式：
+ *
+ * 1. csr        行指针 + 列号 + 值，行内用 AVX2 gather 处理 4 个非零元
+ * 2. sell-8-1   SELL-C-σ，C=8 行一组按列主序存储（分块 ELLPACK），
+ *               组内补齐到最长行，8 行一次 SIMD 计算
+ * 3. sell-8-256 同上，但每 σ=256 行按行长降序排序后再分组，减少补齐
+ * 4. bcsr-4x4   4x4 分块 CSR，块内列主序，每块 4 次 FMA，x 按块连续读取
+ *
+ * 预取：每处理一个存储位置 k，预取 x[col[k + L]]（col 尾部填充，无需边界检查）。
+ * 多线程：按非零元（含补齐）数量均衡划分连续的行/行组/块行。
+ *
+ * 报告 GFLOPS（2*nnz/时间）和有效带宽（格式存储 + x + y 的字节数/时间）。
+ *
+ * 编译: gcc -O2 -pthread -o spmv spmv.c
+ * 运行: ./spmv [--all | --csr | --sell | --bcsr] [--type random|powerlaw|block]
+ *              [--rows N] [--nnz-per-row K] [--lookahead L] [--threads N]
+ *              [--placement spread|compact]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+
+// 配置参数
+#define DEFAULT_ROWS (2 * 1024 * 1024)
+#define DEFAULT_NNZ_PER_ROW 16
+#define DEFAULT_LOOKAHEAD 32      // 预取提前的存储位置数
+#define MAX_LOOKAHEAD 512         // 列号数组尾部填充
+#define SELL_C 8                  // SELL 每组行数（两个 AVX2 double 向量）
+#define SELL_SIGMA 256            // 排序窗口
+#define BCSR_R 4
+#define BCSR_MAX_FILL 4.0         // 补零超过 4 倍时跳过 BCSR
+#define BAND_BLOCKS 64            // block 矩阵：块列距对角线的最大距离
+#define MAX_ROW_LEN 4096          // powerlaw 行长上限
+#define SPMV_ITERS 5
+#define MAX_THREADS NUM_HW_THREADS
+
+typedef enum { MAT_RANDOM, MAT_POWERLAW, MAT_BLOCK, NUM_MAT_TYPES } mat_type_t;
+typedef enum { FMT_CSR, FMT_SELL1, FMT_SELL, FMT_BCSR, NUM_FORMATS } format_t;
+
+static const char *mat_type_names[NUM_MAT_TYPES] = {"random", "powerlaw", "block"};
+static const char *format_names[NUM_FORMATS] = {"csr", "sell-8-1", "sell-8-256", "bcsr-4x4"};
+
+// SELL-C-σ：第 c 组第 j 列第 r 行的元素位于 chunk_ptr[c] + j * SELL_C + r
+typedef struct {
+    size_t nchunks;
+    size_t stored;           // 含补齐的元素数
+    uint64_t *chunk_ptr;     // nchunks + 1
+    uint32_t *perm;          // 组内第 r 行对应的原始行
+    uint32_t *col;
+    double *val;
+} sell_t;
+
+typedef struct {
+    size_t rows;
+    size_t nnz;
+    // CSR
+    uint64_t *row_ptr;
+    uint32_t *col;
+    double *val;
+    sell_t sell[2];          // σ=1 与 σ=SELL_SIGMA
+    // BCSR
+    size_t nblocks;
+    uint64_t *brow_ptr;      // rows / BCSR_R + 1
+    uint32_t *bcol;
+    double *bval;            // 每块 16 个值，列主序
+    double bcsr_fill;        // 0 表示未构建
+} matrix_t;
+
+static int has_avx2;
+static uint64_t rng_state = 88172645463325252ULL;
+
+static inline uint64_t next_rand(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static inline double rand_unit(void) {
+    return (next_rand() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void *alloc_aligned(size_t bytes) {
+    return aligned_alloc(CACHE_LINE_SIZE, (bytes + CACHE_LINE_SIZE - 1) /
+                                          CACHE_LINE_SIZE * CACHE_LINE_SIZE);
+}
+
+// 列号数组多分配 MAX_LOOKAHEAD 个 0，预取可以越过末尾
+static uint32_t *alloc_cols(size_t n) {
+    uint32_t *c = alloc_aligned((n + MAX_LOOKAHEAD) * sizeof(uint32_t));
+    if (c) memset(c + n, 0, MAX_LOOKAHEAD * sizeof(uint32_t));
+    return c;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// ---------------------------------------------------------------
+// 矩阵生成（CSR）
+// ---------------------------------------------------------------
+
+static size_t row_length(mat_type_t type, size_t k) {
+    if (type == MAT_RANDOM) {
+        return k / 2 + next_rand() % (k + 1);           // [k/2, 3k/2]
+    }
+    // Pareto(alpha=2, xm=k/2)，均值约为 k
+    double len = (k / 2.0) / sqrt(1.0 - rand_unit());
+    return len > MAX_ROW_LEN ? MAX_ROW_LEN : (size_t)len + 1;
+}
+
+static int generate_matrix(matrix_t *m, mat_type_t type, size_t rows, size_t k) {
+    memset(m, 0, sizeof(*m));
+    m->rows = rows;
+    m->row_ptr = malloc((rows + 1) * sizeof(uint64_t));
+    if (!m->row_ptr) return -1;
+
+    // block：每个 4 行块行有 k/4 个 4x4 稠密块，块列在对角线附近
+    size_t blocks_per_row = k / BCSR_R > 0 ? k / BCSR_R : 1;
+    if (blocks_per_row > 2 * BAND_BLOCKS + 1) blocks_per_row = 2 * BAND_BLOCKS + 1;
+    m->row_ptr[0] = 0;
+    for (size_t r = 0; r < rows; r++) {
+        size_t len = type == MAT_BLOCK ? blocks_per_row * BCSR_R : row_length(type, k);
+        if (len > rows) len = rows;
+        m->row_ptr[r + 1] = m->row_ptr[r] + len;
+    }
+    m->nnz = m->row_ptr[rows];
+    m->col = alloc_cols(m->nnz);
+    m->val = alloc_aligned(m->nnz * sizeof(double));
+    if (!m->col || !m->val) return -1;
+
+    size_t nbc = rows / BCSR_R;
+    for (size_t r = 0; r < rows; r++) {
+        uint32_t *c = m->col + m->row_ptr[r];
+        size_t len = m->row_ptr[r + 1] - m->row_ptr[r];
+
+        if (type == MAT_BLOCK) {
+            if (r % BCSR_R == 0) {
+                // 块行首行选块列（不重复），同块行其余各行复制
+                size_t br = r / BCSR_R;
+                for (size_t b = 0; b < blocks_per_row; b++) {
+                    uint32_t bc;
+                    int dup;
+                    do {
+                        int64_t off = (int64_t)(next_rand() % (2 * BAND_BLOCKS + 1)) - BAND_BLOCKS;
+                        int64_t cand = (int64_t)br + off;
+                        if (cand < 0) cand += nbc;
+                        if (cand >= (int64_t)nbc) cand -= nbc;
+                        bc = (uint32_t)cand;
+                        dup = 0;
+                        for (size_t j = 0; j < b; j++) dup |= c[j * BCSR_R] == bc * BCSR_R;
+                    } while (dup);
+                    for (int j = 0; j < BCSR_R; j++) c[b * BCSR_R + j] = bc * BCSR_R + j;
+                }
+                qsort(c, len, sizeof(uint32_t), cmp_u32);
+            } else {
+                memcpy(c, m->col + m->row_ptr[r - 1], len * sizeof(uint32_t));
+            }
+        } else {
+            for (size_t j = 0; j < len; j++) c[j] = next_rand() % rows;
+            qsort(c, len, sizeof(uint32_t), cmp_u32);
+        }
+    }
+    for (size_t i = 0; i < m->nnz; i++) m->val[i] = rand_unit() * 2 - 1;
+    return 0;
+}
+
+// ---------------------------------------------------------------
+// 格式转换
+// ---------------------------------------------------------------
+
+static const matrix_t *sort_matrix;
+
+static int cmp_row_len_desc(const void *a, const void *b) {
+    uint32_t ra = *(const uint32_t *)a, rb = *(const uint32_t *)b;
+    uint64_t la = sort_matrix->row_ptr[ra + 1] - sort_matrix->row_ptr[ra];
+    uint64_t lb = sort_matrix->row_ptr[rb + 1] - sort_matrix->row_ptr[rb];
+    return la > lb ? -1 : la < lb ? 1 : (ra > rb) - (ra < rb);
+}
+
+static int build_sell(matrix_t *m, int which, size_t sigma) {
+    size_t rows = m->rows;
+    size_t nchunks = (rows + SELL_C - 1) / SELL_C;
+    sell_t *s = &m->sell[which];
+
+    s->nchunks = nchunks;
+    s->perm = malloc(nchunks * SELL_C * sizeof(uint32_t));
+    s->chunk_ptr = malloc((nchunks + 1) * sizeof(uint64_t));
+    if (!s->perm || !s->chunk_ptr) return -1;
+
+    for (size_t r = 0; r < rows; r++) s->perm[r] = (uint32_t)r;
+    sort_matrix = m;
+    for (size_t w = 0; sigma > 1 && w < rows; w += sigma) {
+        size_t len = rows - w < sigma ? rows - w : sigma;
+        qsort(s->perm + w, len, sizeof(uint32_t), cmp_row_len_desc);
+    }
+    // 行数不是 C 的倍数时，末组多出的行指向不存在的行（长度按 0 处理）
+    for (size_t r = rows; r < nchunks * SELL_C; r++) s->perm[r] = UINT32_MAX;
+
+    s->chunk_ptr[0] = 0;
+    for (size_t c = 0; c < nchunks; c++) {
+        uint64_t width = 0;
+        for (int r = 0; r < SELL_C; r++) {
+            uint32_t row = s->perm[c * SELL_C + r];
+            if (row == UINT32_MAX) continue;
+            uint64_t len = m->row_ptr[row + 1] - m->row_ptr[row];
+            if (len > width) width = len;
+        }
+        s->chunk_ptr[c + 1] = s->chunk_ptr[c] + width * SELL_C;
+    }
+    s->stored = s->chunk_ptr[nchunks];
+    s->col = alloc_cols(s->stored);
+    s->val = alloc_aligned(s->stored * sizeof(double));
+    if (!s->col || !s->val) return -1;
+
+    for (size_t c = 0; c < nchunks; c++) {
+        size_t width = (s->chunk_ptr[c + 1] - s->chunk_ptr[c]) / SELL_C;
+        for (int r = 0; r < SELL_C; r++) {
+            uint32_t row = s->perm[c * SELL_C + r];
+            size_t len = row == UINT32_MAX ? 0 : m->row_ptr[row + 1] - m->row_ptr[row];
+            for (size_t j = 0; j < width; j++) {
+                size_t dst = s->chunk_ptr[c] + j * SELL_C + r;
+                if (j < len) {
+                    s->col[dst] = m->col[m->row_ptr[row] + j];
+                    s->val[dst] = m->val[m->row_ptr[row] + j];
+                } else {
+                    s->col[dst] = 0;
+                    s->val[dst] = 0;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// 要求 rows 是 BCSR_R 的倍数；补零超过 BCSR_MAX_FILL 时不构建
+static int build_bcsr(matrix_t *m) {
+    size_t nbr = m->rows / BCSR_R;
+    size_t nbc = m->rows / BCSR_R;
+    int64_t *slot = malloc(nbc * sizeof(int64_t));  // 当前块行中块列 -> 块下标
+    m->brow_ptr = malloc((nbr + 1) * sizeof(uint64_t));
+    if (!slot || !m->brow_ptr) return -1;
+    for (size_t i = 0; i < nbc; i++) slot[i] = -1;
+
+    // 第一遍：统计每个块行的块数
+    m->brow_ptr[0] = 0;
+    for (size_t br = 0; br < nbr; br++) {
+        uint64_t count = 0;
+        for (size_t r = br * BCSR_R; r < (br + 1) * BCSR_R; r++) {
+            for (uint64_t k = m->row_ptr[r]; k < m->row_ptr[r + 1]; k++) {
+                uint32_t bc = m->col[k] / BCSR_R;
+                if (slot[bc] < 0) {
+                    slot[bc] = 0;
+                    count++;
+                }
+            }
+        }
+        for (size_t r = br * BCSR_R; r < (br + 1) * BCSR_R; r++) {
+            for (uint64_t k = m->row_ptr[r]; k < m->row_ptr[r + 1]; k++) {
+                slot[m->col[k] / BCSR_R] = -1;
+            }
+        }
+        m->brow_ptr[br + 1] = m->brow_ptr[br] + count;
+    }
+    m->nblocks = m->brow_ptr[nbr];
+    m->bcsr_fill = (double)m->nblocks * BCSR_R * BCSR_R / m->nnz;
+    if (m->bcsr_fill > BCSR_MAX_FILL) {
+        free(slot);
+        return 0;
+    }
+
+    m->bcol = alloc_cols(m->nblocks);
+    m->bval = alloc_aligned(m->nblocks * BCSR_R * BCSR_R * sizeof(double));
+    if (!m->bcol || !m->bval) return -1;
+    memset(m->bval, 0, m->nblocks * BCSR_R * BCSR_R * sizeof(double));
+
+    // 第二遍：按出现顺序分配块并累加值（重复元素相加）
+    for (size_t br = 0; br < nbr; br++) {
+        uint64_t next = m->brow_ptr[br];
+        for (size_t r = br * BCSR_R; r < (br + 1) * BCSR_R; r++) {
+            for (uint64_t k = m->row_ptr[r]; k < m->row_ptr[r + 1]; k++) {
+                uint32_t bc = m->col[k] / BCSR_R;
+                if (slot[bc] < 0) {
+                    slot[bc] = (int64_t)next;
+                    m->bcol[next++] = bc;
+                }
+                double *blk = m->bval + slot[bc] * BCSR_R * BCSR_R;
+                blk[(m->col[k] % BCSR_R) * BCSR_R + (r % BCSR_R)] += m->val[k];
+            }
+        }
+        for (uint64_t b = m->brow_ptr[br]; b < next; b++) slot[m->bcol[b]] = -1;
+    }
+    free(slot);
+    return 0;
+}
+
+static void free_matrix(matrix_t *m) {
+    free(m->row_ptr);
+    free(m->col);
+    free(m->val);
+    for (int i = 0; i < 2; i++) {
+        free(m->sell[i].chunk_ptr);
+        free(m->sell[i].perm);
+        free(m->sell[i].col);
+        free(m->sell[i].val);
+    }
+    free(m->brow_ptr);
+    free(m->bcol);
+    free(m->bval);
+}
+
+// 格式存储字节数（不含 x、y）
+static size_t format_bytes(const matrix_t *m, format_t fmt) {
+    if (fmt == FMT_CSR) {
+        return m->nnz * (sizeof(double) + sizeof(uint32_t)) + (m->rows + 1) * sizeof(uint64_t);
+    }
+    if (fmt == FMT_BCSR) {
+        return m->nblocks * (BCSR_R * BCSR_R * sizeof(double) + sizeof(uint32_t)) +
+               (m->rows / BCSR_R + 1) * sizeof(uint64_t);
+    }
+    const sell_t *s = &m->sell[fmt == FMT_SELL];
+    return s->stored * (sizeof(double) + sizeof(uint32_t)) +
+           (s->nchunks + 1) * sizeof(uint64_t) + s->nchunks * SELL_C * sizeof(uint32_t);
+}
+
+static double format_fill(const matrix_t *m, format_t fmt) {
+    if (fmt == FMT_CSR) return 1.0;
+    if (fmt == FMT_BCSR) return m->bcsr_fill;
+    return (double)m->sell[fmt == FMT_SELL].stored / m->nnz;
+}
+
+static int format_available(const matrix_t *m, format_t fmt) {
+    return fmt != FMT_BCSR || m->bval != NULL;
+}
+
+// ---------------------------------------------------------------
+// 内核：处理 [lo, hi) 个划分单元（行 / 行组 / 块行）
+// ---------------------------------------------------------------
+
+static void csr_scalar(const matrix_t *m, const double *x, double *y, size_t lo, size_t hi,
+                       int lookahead) {
+    const uint32_t *col = m->col;
+    const double *val = m->val;
+    for (size_t r = lo; r < hi; r++) {
+        double sum = 0;
+        for (uint64_t k = m->row_ptr[r]; k < m->row_ptr[r + 1]; k++) {
+            if (lookahead) PREFETCH_T0(&x[col[k + lookahead]]);
+            sum += val[k] * x[col[k]];
+        }
+        y[r] = sum;
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static inline double hsum_avx2(__m256d v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+__attribute__((target("avx2,fma")))
+static void csr_avx2(const matrix_t *m, const double *x, double *y, size_t lo, size_t hi,
+                     int lookahead) {
+    const uint32_t *col = m->col;
+    const double *val = m->val;
+    for (size_t r = lo; r < hi; r++) {
+        uint64_t k = m->row_ptr[r], end = m->row_ptr[r + 1];
+        __m256d acc = _mm256_setzero_pd();
+        for (; k + 4 <= end; k += 4) {
+            if (lookahead) {
+                for (int i = 0; i < 4; i++) PREFETCH_T0(&x[col[k + lookahead + i]]);
+            }
+            __m128i idx = _mm_loadu_si128((const __m128i *)(col + k));
+            __m256d xv = _mm256_i32gather_pd(x, idx, 8);
+            acc = _mm256_fmadd_pd(_mm256_loadu_pd(val + k), xv, acc);
+        }
+        double sum = hsum_avx2(acc);
+        for (; k < end; k++) sum += val[k] * x[col[k]];
+        y[r] = sum;
+    }
+}
+
+static void sell_scalar(const matrix_t *m, int which, const double *x, double *y,
+                        size_t lo, size_t hi, int lookahead) {
+    const sell_t *s = &m->sell[which];
+    for (size_t c = lo; c < hi; c++) {
+        double acc[SELL_C] = {0};
+        for (uint64_t base = s->chunk_ptr[c]; base < s->chunk_ptr[c + 1]; base += SELL_C) {
+            for (int r = 0; r < SELL_C; r++) {
+                if (lookahead) PREFETCH_T0(&x[s->col[base + lookahead + r]]);
+                acc[r] += s->val[base + r] * x[s->col[base + r]];
+            }
+        }
+        for (int r = 0; r < SELL_C; r++) {
+            uint32_t row = s->perm[c * SELL_C + r];
+            if (row != UINT32_MAX) y[row] = acc[r];
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void sell_avx2(const matrix_t *m, int which, const double *x, double *y,
+                      size_t lo, size_t hi, int lookahead) {
+    const sell_t *s = &m->sell[which];
+    for (size_t c = lo; c < hi; c++) {
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        for (uint64_t base = s->chunk_ptr[c]; base < s->chunk_ptr[c + 1]; base += SELL_C) {
+            if (lookahead) {
+                for (int r = 0; r < SELL_C; r++) PREFETCH_T0(&x[s->col[base + lookahead + r]]);
+            }
+            __m128i idx0 = _mm_load_si128((const __m128i *)(s->col + base));
+            __m128i idx1 = _mm_load_si128((const __m128i *)(s->col + base + 4));
+            acc0 = _mm256_fmadd_pd(_mm256_load_pd(s->val + base),
+                                   _mm256_i32gather_pd(x, idx0, 8), acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_load_pd(s->val + base + 4),
+                                   _mm256_i32gather_pd(x, idx1, 8), acc1);
+        }
+        double out[SELL_C];
+        _mm256_storeu_pd(out, acc0);
+        _mm256_storeu_pd(out + 4, acc1);
+        for (int r = 0; r < SELL_C; r++) {
+            uint32_t row = s->perm[c * SELL_C + r];
+            if (row != UINT32_MAX) y[row] = out[r];
+        }
+    }
+}
+
+static void bcsr_scalar(const matrix_t *m, const double *x, double *y, size_t lo, size_t hi,
+                        int lookahead) {
+    for (size_t br = lo; br < hi; br++) {
+        double acc[BCSR_R] = {0};
+        for (uint64_t b = m->brow_ptr[br]; b < m->brow_ptr[br + 1]; b++) {
+            if (lookahead) PREFETCH_T0(&x[m->bcol[b + lookahead] * BCSR_R]);
+            const double *blk = m->bval + b * BCSR_R * BCSR_R;
+            const double *xb = x + (size_t)m->bcol[b] * BCSR_R;
+            for (int c = 0; c < BCSR_R; c++) {
+                for (int r = 0; r < BCSR_R; r++) acc[r] += blk[c * BCSR_R + r] * xb[c];
+            }
+        }
+        memcpy(y + br * BCSR_R, acc, sizeof(acc));
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void bcsr_avx2(const matrix_t *m, const double *x, double *y, size_t lo, size_t hi,
+                      int lookahead) {
+    for (size_t br = lo; br < hi; br++) {
+        __m256d acc = _mm256_setzero_pd();
+        for (uint64_t b = m->brow_ptr[br]; b < m->brow_ptr[br + 1]; b++) {
+            if (lookahead) PREFETCH_T0(&x[m->bcol[b + lookahead] * BCSR_R]);
+            const double *blk = m->bval + b * BCSR_R * BCSR_R;
+            const double *xb = x + (size_t)m->bcol[b] * BCSR_R;
+            // 块内列主序：每列一个 4 行向量乘以广播的 x 分量
+            acc = _mm256_fmadd_pd(_mm256_load_pd(blk), _mm256_broadcast_sd(xb), acc);
+            acc = _mm256_fmadd_pd(_mm256_load_pd(blk + 4), _mm256_broadcast_sd(xb + 1), acc);
+            acc = _mm256_fmadd_pd(_mm256_load_pd(blk + 8), _mm256_broadcast_sd(xb + 2), acc);
+            acc = _mm256_fmadd_pd(_mm256_load_pd(blk + 12), _mm256_broadcast_sd(xb + 3), acc);
+        }
+        _mm256_storeu_pd(y + br * BCSR_R, acc);
+    }
+}
+
+static void spmv_range(const matrix_t *m, format_t fmt, int simd, int lookahead,
+                       const double *x, double *y, size_t lo, size_t hi) {
+    simd = simd && has_avx2;
+    switch (fmt) {
+    case FMT_CSR:
+        (simd ? csr_avx2 : csr_scalar)(m, x, y, lo, hi, lookahead);
+        break;
+    case FMT_SELL1:
+    case FMT_SELL:
+        (simd ? sell_avx2 : sell_scalar)(m, fmt == FMT_SELL, x, y, lo, hi, lookahead);
+        break;
+    default:
+        (simd ? bcsr_avx2 : bcsr_scalar)(m, x, y, lo, hi, lookahead);
+        break;
+    }
+}
+
+// 划分单元数与对应的存储指针（单元 i 的存储量为 ptr[i+1] - ptr[i]）
+static size_t format_units(const matrix_t *m, format_t fmt, const uint64_t **ptr) {
+    if (fmt == FMT_CSR) {
+        *ptr = m->row_ptr;
+        return m->rows;
+    }
+    if (fmt == FMT_BCSR) {
+        *ptr = m->brow_ptr;
+        return m->rows / BCSR_R;
+    }
+    *ptr = m->sell[fmt == FMT_SELL].chunk_ptr;
+    return m->sell[fmt == FMT_SELL].nchunks;
+}
+
+// 第一个 ptr[i] >= target 的单元
+static size_t balanced_bound(const uint64_t *ptr, size_t units, uint64_t target) {
+    size_t lo = 0, hi = units;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ptr[mid] < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// ---------------------------------------------------------------
+// 多线程测量
+// ---------------------------------------------------------------
+
+typedef struct {
+    int cpu_id;
+    const matrix_t *m;
+    format_t fmt;
+    int simd;
+    int lookahead;
+    const double *x;
+    double *y;
+    size_t lo, hi;
+    volatile int *ready;
+    volatile int *start;
+} thread_arg_t;
+
+static void *worker_thread(void *arg) {
+    thread_arg_t *targ = (thread_arg_t *)arg;
+
+    bind_to_cpu(targ->cpu_id);
+
+    __atomic_fetch_add(targ->ready, 1, __ATOMIC_SEQ_CST);
+    while (*targ->start == 0) {
+        __builtin_ia32_pause();
+    }
+
+    for (int iter = 0; iter < SPMV_ITERS; iter++) {
+        spmv_range(targ->m, targ->fmt, targ->simd, targ->lookahead, targ->x, targ->y,
+                   targ->lo, targ->hi);
+    }
+    return NULL;
+}
+
+// 返回每次 SpMV 的秒数
+static double run_spmv(const matrix_t *m, format_t fmt, int simd, int lookahead, int nthreads,
+                       placement_t placement, const double *x, double *y) {
+    pthread_t threads[MAX_THREADS];
+    thread_arg_t args[MAX_THREADS];
+    volatile int ready = 0;
+    volatile int start = 0;
+    const uint64_t *ptr;
+    size_t units = format_units(m, fmt, &ptr);
+
+    for (int t = 0; t < nthreads; t++) {
+        args[t] = (thread_arg_t){
+            .cpu_id = placement_cpu(t, placement), .m = m, .fmt = fmt, .simd = simd,
+            .lookahead = lookahead, .x = x, .y = y,
+            .lo = balanced_bound(ptr, units, ptr[units] * t / nthreads),
+            .hi = t + 1 == nthreads ? units
+                                    : balanced_bound(ptr, units, ptr[units] * (t + 1) / nthreads),
+            .ready = &ready, .start = &start
+        };
+        pthread_create(&threads[t], NULL, worker_thread, &args[t]);
+    }
+
+    while (ready < nthreads) usleep(100);
+
+    double t0 = get_time_sec();
+    start = 1;
+    for (int t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+    return (get_time_sec() - t0) / SPMV_ITERS;
+}
+
+static double max_rel_error(const double *a, const double *ref, size_t n) {
+    double err = 0;
+    for (size_t i = 0; i < n; i++) {
+        double e = fabs(a[i] - ref[i]) / (fabs(ref[i]) + 1e-12);
+        if (e > err) err = e;
+    }
+    return err;
+}
+
+// ---------------------------------------------------------------
+// 测试
+// ---------------------------------------------------------------
+
+typedef struct {
+    mat_type_t type;
+    size_t rows;
+    size_t nnz_per_row;
+    int lookahead;
+    int nthreads;
+    placement_t placement;
+} options_t;
+
+static int run_matrix(const options_t *opt, mat_type_t type, const int *formats, int nformats) {
+    matrix_t m;
+    double t0 = get_time_sec();
+
+    rng_state = 88172645463325252ULL;
+    if (generate_matrix(&m, type, opt->rows, opt->nnz_per_row) != 0 ||
+        build_sell(&m, 0, 1) != 0 || build_sell(&m, 1, SELL_SIGMA) != 0 ||
+        build_bcsr(&m) != 0) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+
+    double *x = alloc_aligned(m.rows * sizeof(double));
+    double *y = alloc_aligned(m.rows * sizeof(double));
+    double *ref = alloc_aligned(m.rows * sizeof(double));
+    if (!x || !y || !ref) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+    for (size_t i = 0; i < m.rows; i++) x[i] = rand_unit();
+    csr_scalar(&m, x, ref, 0, m.rows, 0);
+
+    printf("\n=== Matrix: %s, %zu rows, %.1fM nnz (%.1f/row), built in %.1fs ===\n",
+           mat_type_names[type], m.rows, m.nnz / 1e6, (double)m.nnz / m.rows,
+           get_time_sec() - t0);
+    printf("%-11s %9s %6s %9s %9s %9s %9s %9s  Check\n", "Format", "Size(MB)", "Fill",
+           "scalar", "simd", "simd+pf", "+threads", "GB/s");
+    printf("  (GFLOPS; simd+pf uses lookahead %d; +threads = %d threads, %s)\n",
+           opt->lookahead, opt->nthreads, opt->placement == PLACE_COMPACT ? "compact"
+                                                                           : "spread");
+    printf("------------------------------------------------------------------------------------\n");
+
+    for (int f = 0; f < nformats; f++) {
+        format_t fmt = (format_t)formats[f];
+        if (!format_available(&m, fmt)) {
+            printf("%-11s skipped (fill %.1fx > %.1fx)\n", format_names[fmt],
+                   format_fill(&m, fmt), BCSR_MAX_FILL);
+            continue;
+        }
+        double flops = 2.0 * m.nnz;
+        double bytes = format_bytes(&m, fmt) + 2.0 * m.rows * sizeof(double);
+
+        double t_scalar = run_spmv(&m, fmt, 0, 0, 1, opt->placement, x, y);
+        double t_simd = run_spmv(&m, fmt, 1, 0, 1, opt->placement, x, y);
+        double t_pf = run_spmv(&m, fmt, 1, opt->lookahead, 1, opt->placement, x, y);
+        memset(y, 0, m.rows * sizeof(double));
+        double t_mt = run_spmv(&m, fmt, 1, opt->lookahead, opt->nthreads, opt->placement, x, y);
+        double err = max_rel_error(y, ref, m.rows);
+
+        printf("%-11s %9.1f %5.2fx %9.2f %9.2f %9.2f %9.2f %9.1f  %s\n", format_names[fmt],
+               format_bytes(&m, fmt) / (1024.0 * 1024.0), format_fill(&m, fmt),
+               flops / t_scalar / 1e9, flops / t_simd / 1e9, flops / t_pf / 1e9,
+               flops / t_mt / 1e9, bytes / t_mt / 1e9, err < 1e-9 ? "OK" : "MISMATCH");
+        fflush(stdout);
+    }
+
+    free(x);
+    free(y);
+    free(ref);
+    free_matrix(&m);
+    return 0;
+}
+
+// 名称 -> 枚举下标，未知名称返回 -1
+static int parse_name(const char *val, const char *const *names, int n) {
+    for (int i = 0; i < n; i++) {
+        if (strcmp(val, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--all | --csr | --sell | --bcsr] [options]\n", prog);
+    printf("\n");
+    printf("Modes:\n");
+    printf("  --all              All formats on random, powerlaw and block matrices\n");
+    printf("  --csr | --sell | --bcsr  One format family on --type\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  --type T           random | powerlaw | block (default random)\n");
+    printf("  --rows N           Rows = columns (default %d, rounded to a multiple of %d)\n",
+           DEFAULT_ROWS, SELL_C);
+    printf("  --nnz-per-row K    Average nonzeros per row (default %d)\n", DEFAULT_NNZ_PER_ROW);
+    printf("  --lookahead L      Prefetch x[col[k + L]] (default %d, max %d, 0 = off)\n",
+           DEFAULT_LOOKAHEAD, MAX_LOOKAHEAD);
+    printf("  --threads N        Threads for the +threads column (default 1)\n");
+    printf("  --placement P      spread | compact (default spread)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    options_t opt = {MAT_RANDOM, DEFAULT_ROWS, DEFAULT_NNZ_PER_ROW, DEFAULT_LOOKAHEAD, 1,
+                     PLACE_SPREAD};
+    int bad_name = 0;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const char *val = argv[i + 1];
+        if (strcmp(argv[i], "--type") == 0) {
+            int t = parse_name(val, mat_type_names, NUM_MAT_TYPES);
+            if (t < 0) bad_name = 1; else opt.type = (mat_type_t)t;
+        } else if (strcmp(argv[i], "--rows") == 0) {
+            opt.rows = strtoull(val, NULL, 0);
+        } else if (strcmp(argv[i], "--nnz-per-row") == 0) {
+            opt.nnz_per_row = strtoull(val, NULL, 0);
+        } else if (strcmp(argv[i], "--lookahead") == 0) {
+            opt.lookahead = atoi(val);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            opt.nthreads = atoi(val);
+        } else if (strcmp(argv[i], "--placement") == 0) {
+            if (strcmp(val, "compact") == 0) {
+                opt.placement = PLACE_COMPACT;
+            } else if (strcmp(val, "spread") == 0) {
+                opt.placement = PLACE_SPREAD;
+            } else {
+                bad_name = 1;
+            }
+        }
+    }
+    opt.rows = (opt.rows + SELL_C - 1) / SELL_C * SELL_C;
+    if (bad_name || opt.rows < 1024 || opt.rows > UINT32_MAX / 2 || opt.nnz_per_row < 1 ||
+        opt.lookahead < 0 || opt.lookahead > MAX_LOOKAHEAD || opt.nthreads < 1 ||
+        opt.nthreads > MAX_THREADS) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    __builtin_cpu_init();
+    has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+
+    printf("=== Sparse Matrix-Vector Multiply Benchmark ===\n");
+    printf("SIMD kernels: %s, SELL C=%d sigma=%d, BCSR %dx%d, %d SpMV per measurement\n",
+           has_avx2 ? "AVX2+FMA (gather)" : "scalar fallback", SELL_C, SELL_SIGMA,
+           BCSR_R, BCSR_R, SPMV_ITERS);
+
+    static const int all_formats[] = {FMT_CSR, FMT_SELL1, FMT_SELL, FMT_BCSR};
+    static const int sell_formats[] = {FMT_SELL1, FMT_SELL};
+    static const int csr_formats[] = {FMT_CSR};
+    static const int bcsr_formats[] = {FMT_BCSR};
+
+    if (strcmp(mode, "--csr") == 0) {
+        return run_matrix(&opt, opt.type, csr_formats, 1);
+    } else if (strcmp(mode, "--sell") == 0) {
+        return run_matrix(&opt, opt.type, sell_formats, 2);
+    } else if (strcmp(mode, "--bcsr") == 0) {
+        return run_matrix(&opt, opt.type, bcsr_formats, 1);
+    } else if (strcmp(mode, "--all") == 0) {
+        for (int t = 0; t < NUM_MAT_TYPES; t++) {
+            if (run_matrix(&opt, (mat_type_t)t, all_formats, NUM_FORMATS) != 0) return 1;
+        }
+
+        printf("\n=== Analysis ===\n");
+        printf("- SpMV is bandwidth bound: ~12 bytes of val+col per 2 flops\n");
+        printf("- x[col] is the only random stream; prefetch helps once x exceeds L2/L3\n");
+        printf("  (random/powerlaw), not for the banded block matrix\n");
+        printf("- SELL pads each 8-row chunk to its longest row: sigma sorting keeps the\n");
+        printf("  fill near 1 for skewed (powerlaw) rows and enables full-width SIMD\n");
+        printf("- BCSR halves index traffic and reuses x within a block, but only pays\n");
+        printf("  off when the matrix has real dense blocks (fill close to 1)\n");
+        printf("- Partitioning by stored nonzeros balances threads on powerlaw rows\n");
+        return 0;
+    }
+    print_usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,368 @@
+/*
+ * work_stealing.c - 工作窃取调度：随机窃取 vs 拓扑感知窃取
+ *
+ * 仓库中的并行都是静态两线程划分（如 shared_cache.c 按 ELEMENTS / 2 切分），
+ * 任务不规则时先做完的线程只能空等。本测试用 common/work_steal.h 的
+ * Chase-Lev 运行时跑三种不规则任务图，比较两种窃取策略：
+ *
+ *   random     随机选择受害者
+ *   topology   先偷同核心超线程兄弟（共享 L1/L2），再同一 L3，最后其它
+ *
+ * 任务图：
+ *   fib      递归 fib(n)，n < cutoff 时串行，任务极小、数量极多
+ *   pfor     并行 for，二分到 grain；前 1/8 的元素代价是其余的 16 倍
+ *   matmul   C = A * B 分块，按二维分块网格四分递归，相邻分块共享 A 行条 / B 列条
+ *
+ * 报告时间、任务吞吐、按受害者层次统计的成功窃取，以及所有工作线程的
+ * L1D / LLC 缺失（perf_event，不可用时为 n/a）。
+ *
+ * 编译: gcc -O2 -pthread -o work_stealing work_stealing.c
+ * 运行: ./work_stealing [--fib | --pfor | --matmul | --all] [--threads N]
+ *                       [--placement spread|compact]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../common/cpu_bindind.h"
+#include "../common/prefetch_utils.h"
+#include "../common/perf_counters.h"
+#include "../common/work_steal.h"
+
+// 配置参数
+#define FIB_N 36
+#define FIB_CUTOFF 16
+#define PFOR_N (8 * 1024 * 1024)          // 32MB float
+#define PFOR_GRAIN 4096
+#define PFOR_HEAVY_REPS 64                // 前 1/8 元素的迭代次数
+#define PFOR_LIGHT_REPS 4
+#define MM_N 1024
+#define MM_TILE 64
+#define MM_TILES (MM_N / MM_TILE)
+
+// ---------------------------------------------------------------
+// 每线程计数器
+// ---------------------------------------------------------------
+
+typedef struct {
+    perf_counter_t counters[2];
+} thread_counters_t;
+
+static uint64_t total_misses[2];
+static int counters_valid[2];
+
+static void counters_init(ws_worker_t *w) {
+    thread_counters_t *tc = calloc(1, sizeof(*tc));
+    if (!tc) return;
+    perf_counter_open(&tc->counters[0], "L1D-miss", PERF_TYPE_HW_CACHE, PERF_L1D_READ_MISS);
+    perf_counter_open(&tc->counters[1], "LLC-miss", PERF_TYPE_HARDWARE,
+                      PERF_COUNT_HW_CACHE_MISSES);
+    perf_counters_start(tc->counters, 2);
+    w->user = tc;
+}
+
+static void counters_exit(ws_worker_t *w) {
+    thread_counters_t *tc = w->user;
+    if (!tc) return;
+    perf_counters_stop(tc->counters, 2);
+    for (int i = 0; i < 2; i++) {
+        __atomic_fetch_add(&total_misses[i], tc->counters[i].value, __ATOMIC_RELAXED);
+        if (perf_counter_valid(&tc->counters[i])) counters_valid[i] = 1;
+    }
+    perf_counters_close(tc->counters, 2);
+    free(tc);
+}
+
+// ---------------------------------------------------------------
+// fib
+// ---------------------------------------------------------------
+
+typedef struct {
+    ws_task_t task;
+    int n;
+    uint64_t result;
+} fib_task_t;
+
+static uint64_t fib_serial(int n) {
+    return n < 2 ? (uint64_t)n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+static void fib_fn(ws_worker_t *w, ws_task_t *t) {
+    fib_task_t *f = (fib_task_t *)t;
+    if (f->n < FIB_CUTOFF) {
+        f->result = fib_serial(f->n);
+        return;
+    }
+    int pending = 1;
+    fib_task_t a = {{fib_fn, &pending}, f->n - 1, 0};
+    fib_task_t b = {{fib_fn, NULL}, f->n - 2, 0};
+    ws_spawn(w, &a.task);
+    fib_fn(w, &b.task);       // 第二个分支直接执行
+    ws_sync(w, &pending);
+    f->result = a.result + b.result;
+}
+
+// ---------------------------------------------------------------
+// pfor
+// ---------------------------------------------------------------
+
+static float *pfor_in;
+static float *pfor_out;
+
+typedef struct {
+    ws_task_t task;
+    size_t lo, hi;
+} range_task_t;
+
+static void pfor_body(size_t lo, size_t hi) {
+    for (size_t i = lo; i < hi; i++) {
+        int reps = i < PFOR_N / 8 ? PFOR_HEAVY_REPS : PFOR_LIGHT_REPS;
+        float x = pfor_in[i];
+        for (int r = 0; r < reps; r++) x = x * 0.999f + 0.5f;
+        pfor_out[i] = x;
+    }
+}
+
+static void pfor_fn(ws_worker_t *w, ws_task_t *t) {
+    range_task_t *r = (range_task_t *)t;
+    if (r->hi - r->lo <= PFOR_GRAIN) {
+        pfor_body(r->lo, r->hi);
+        return;
+    }
+    size_t mid = r->lo + (r->hi - r->lo) / 2;
+    int pending = 1;
+    range_task_t right = {{pfor_fn, &pending}, mid, r->hi};
+    range_task_t left = {{pfor_fn, NULL}, r->lo, mid};
+    ws_spawn(w, &right.task);
+    pfor_fn(w, &left.task);
+    ws_sync(w, &pending);
+}
+
+// ---------------------------------------------------------------
+// matmul
+// ---------------------------------------------------------------
+
+static float *mm_a, *mm_b, *mm_c;
+
+typedef struct {
+    ws_task_t task;
+    int i0, i1, j0, j1;       // 分块网格范围 [i0, i1) x [j0, j1)
+} tile_task_t;
+
+static void mm_tile(int ti, int tj) {
+    float *c = mm_c;
+    const float *a = mm_a, *b = mm_b;
+    for (int i = ti * MM_TILE; i < (ti + 1) * MM_TILE; i++) {
+        float *crow = c + (size_t)i * MM_N + tj * MM_TILE;
+        memset(crow, 0, MM_TILE * sizeof(float));
+        for (int k = 0; k < MM_N; k++) {
+            float aik = a[(size_t)i * MM_N + k];
+            const float *brow = b + (size_t)k * MM_N + tj * MM_TILE;
+            for (int j = 0; j < MM_TILE; j++) crow[j] += aik * brow[j];
+        }
+    }
+}
+
+static void mm_fn(ws_worker_t *w, ws_task_t *t) {
+    tile_task_t *r = (tile_task_t *)t;
+    int ni = r->i1 - r->i0, nj = r->j1 - r->j0;
+    if (ni == 1 && nj == 1) {
+        mm_tile(r->i0, r->j0);
+        return;
+    }
+    // 沿较长的维度二分
+    tile_task_t lo = *r, hi = *r;
+    if (ni >= nj) {
+        lo.i1 = hi.i0 = r->i0 + ni / 2;
+    } else {
+        lo.j1 = hi.j0 = r->j0 + nj / 2;
+    }
+    int pending = 1;
+    hi.task = (ws_task_t){mm_fn, &pending};
+    lo.task = (ws_task_t){mm_fn, NULL};
+    ws_spawn(w, &hi.task);
+    mm_fn(w, &lo.task);
+    ws_sync(w, &pending);
+}
+
+// ---------------------------------------------------------------
+// 测试
+// ---------------------------------------------------------------
+
+typedef enum { G_FIB, G_PFOR, G_MATMUL, NUM_GRAPHS } graph_t;
+
+static const char *policy_names[] = {"random", "topology"};
+
+static double checksum(const float *v, size_t n) {
+    double s = 0;
+    for (size_t i = 0; i < n; i++) s += v[i];
+    return s;
+}
+
+// 运行一次任务图，返回校验值
+static double run_graph(graph_t g, ws_pool_t *pool) {
+    if (g == G_FIB) {
+        fib_task_t root = {{fib_fn, NULL}, FIB_N, 0};
+        ws_pool_run(pool, &root.task);
+        return (double)root.result;
+    }
+    if (g == G_PFOR) {
+        range_task_t root = {{pfor_fn, NULL}, 0, PFOR_N};
+        ws_pool_run(pool, &root.task);
+        return checksum(pfor_out, PFOR_N);
+    }
+    tile_task_t root = {{mm_fn, NULL}, 0, MM_TILES, 0, MM_TILES};
+    ws_pool_run(pool, &root.task);
+    return checksum(mm_c, (size_t)MM_N * MM_N);
+}
+
+static double reference(graph_t g) {
+    if (g == G_FIB) return (double)fib_serial(FIB_N);
+    if (g == G_PFOR) {
+        pfor_body(0, PFOR_N);
+        return checksum(pfor_out, PFOR_N);
+    }
+    for (int ti = 0; ti < MM_TILES; ti++) {
+        for (int tj = 0; tj < MM_TILES; tj++) mm_tile(ti, tj);
+    }
+    return checksum(mm_c, (size_t)MM_N * MM_N);
+}
+
+static void run_benchmark(graph_t g, int nthreads, placement_t placement) {
+    char title[96];
+    if (g == G_FIB) {
+        snprintf(title, sizeof(title), "fib(%d), serial below n = %d", FIB_N, FIB_CUTOFF);
+    } else if (g == G_PFOR) {
+        snprintf(title, sizeof(title), "pfor over %dM floats, grain %d, first 1/8 costs %dx",
+                 PFOR_N >> 20, PFOR_GRAIN, PFOR_HEAVY_REPS / PFOR_LIGHT_REPS);
+    } else {
+        snprintf(title, sizeof(title), "matmul %dx%d, %dx%d tiles, quadrant recursion",
+                 MM_N, MM_N, MM_TILE, MM_TILE);
+    }
+
+    printf("\n=== %s: %d workers, %s ===\n", title, nthreads, placement_name(placement));
+    double t0 = get_time_sec();
+    double ref = reference(g);
+    double serial = get_time_sec() - t0;
+    printf("Serial: %.1f ms\n", serial * 1e3);
+    printf("%-9s %9s %8s %9s %8s", "Policy", "Time(ms)", "Speedup", "M tasks/s", "Steals");
+    for (int k = 0; k < WS_NUM_TIERS; k++) printf(" %8s", ws_tier_names[k]);
+    printf(" %10s %10s  %s\n", "L1D miss", "LLC miss", "Check");
+    printf("------------------------------------------------------------------------------------"
+           "-----------------------\n");
+
+    for (int p = 0; p < 2; p++) {
+        ws_pool_t pool;
+        memset(total_misses, 0, sizeof(total_misses));
+        memset(counters_valid, 0, sizeof(counters_valid));
+        if (ws_pool_init(&pool, nthreads, placement, (ws_policy_t)p, counters_init,
+                         counters_exit) != 0) {
+            perror("Memory allocation failed");
+            exit(1);
+        }
+
+        t0 = get_time_sec();
+        double got = run_graph(g, &pool);
+        double elapsed = get_time_sec() - t0;
+
+        uint64_t tasks = 0, steals[WS_NUM_TIERS] = {0}, all = 0;
+        for (int i = 0; i < nthreads; i++) {
+            tasks += pool.workers[i].tasks_run;
+            for (int k = 0; k < WS_NUM_TIERS; k++) steals[k] += pool.workers[i].steals[k];
+        }
+        ws_pool_destroy(&pool);
+        for (int k = 0; k < WS_NUM_TIERS; k++) all += steals[k];
+
+        char l1[32], llc[32];
+        if (counters_valid[0]) snprintf(l1, sizeof(l1), "%.2fM", total_misses[0] / 1e6);
+        else snprintf(l1, sizeof(l1), "n/a");
+        if (counters_valid[1]) snprintf(llc, sizeof(llc), "%.2fM", total_misses[1] / 1e6);
+        else snprintf(llc, sizeof(llc), "n/a");
+
+        printf("%-9s %9.1f %7.2fx %9.2f %8lu", policy_names[p], elapsed * 1e3,
+               serial / elapsed, tasks / elapsed / 1e6, (unsigned long)all);
+        for (int k = 0; k < WS_NUM_TIERS; k++) {
+            printf(" %7.1f%%", all ? 100.0 * steals[k] / all : 0.0);
+        }
+        printf(" %10s %10s  %s\n", l1, llc, got == ref ? "OK" : "MISMATCH");
+    }
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--fib | --pfor | --matmul | --all] [options]\n", prog);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --threads N                  Worker threads (default %d)\n", NUM_HW_THREADS);
+    printf("  --placement spread|compact   Worker placement (default compact)\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *mode = argc > 1 ? argv[1] : "--all";
+    int nthreads = NUM_HW_THREADS;
+    placement_t placement = PLACE_COMPACT;
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) {
+            nthreads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--placement") == 0) {
+            placement = strcmp(argv[i + 1], "spread") == 0 ? PLACE_SPREAD : PLACE_COMPACT;
+        }
+    }
+    if (nthreads < 1 || nthreads > WS_MAX_WORKERS) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    pfor_in = aligned_alloc(CACHE_LINE_SIZE, PFOR_N * sizeof(float));
+    pfor_out = aligned_alloc(CACHE_LINE_SIZE, PFOR_N * sizeof(float));
+    mm_a = aligned_alloc(CACHE_LINE_SIZE, (size_t)MM_N * MM_N * sizeof(float));
+    mm_b = aligned_alloc(CACHE_LINE_SIZE, (size_t)MM_N * MM_N * sizeof(float));
+    mm_c = aligned_alloc(CACHE_LINE_SIZE, (size_t)MM_N * MM_N * sizeof(float));
+    if (!pfor_in || !pfor_out || !mm_a || !mm_b || !mm_c) {
+        perror("Memory allocation failed");
+        return 1;
+    }
+    for (size_t i = 0; i < PFOR_N; i++) pfor_in[i] = (float)(i % 1000) * 0.001f;
+    for (size_t i = 0; i < (size_t)MM_N * MM_N; i++) {
+        mm_a[i] = (float)(i % 17) * 0.125f;
+        mm_b[i] = (float)(i % 13) * 0.25f;
+    }
+
+    printf("=== Work-Stealing Benchmark: Chase-Lev deques, random vs topology stealing ===\n");
+    printf("Steal columns: share of successful steals by victim tier (HT sibling / same L3 /\n");
+    printf("other L3); L3 groups from /sys/devices/system/cpu/cpu*/cache/index3/id\n");
+
+    if (strcmp(mode, "--fib") == 0) {
+        run_benchmark(G_FIB, nthreads, placement);
+    } else if (strcmp(mode, "--pfor") == 0) {
+        run_benchmark(G_PFOR, nthreads, placement);
+    } else if (strcmp(mode, "--matmul") == 0) {
+        run_benchmark(G_MATMUL, nthreads, placement);
+    } else if (strcmp(mode, "--all") == 0) {
+        for (int g = 0; g < NUM_GRAPHS; g++) run_benchmark((graph_t)g, nthreads, placement);
+
+        printf("\n=== Analysis ===\n");
+        printf("- fib: tasks are tiny and owners mostly pop their own LIFO end, so the\n");
+        printf("  policy matters little; steals are rare compared with the task count\n");
+        printf("- pfor: the skewed first 1/8 keeps generating steals; a sibling that steals\n");
+        printf("  the neighbouring half of a range keeps working in the same L2\n");
+        printf("- matmul: neighbouring tiles share an A row panel or a B column panel,\n");
+        printf("  so stealing from the HT sibling reuses panels already in the shared\n");
+        printf("  L1/L2 and lowers L1D/LLC misses compared with random stealing\n");
+        printf("- with a single L3 (one CCX) the remote tier is empty and topology\n");
+        printf("  stealing reduces to sibling first, then everyone else\n");
+    } else {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    free(pfor_in);
+    free(pfor_out);
+    free(mm_a);
+    free(mm_b);
+    free(mm_c);
+    return 0;
+}